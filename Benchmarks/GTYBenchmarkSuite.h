@@ -0,0 +1,45 @@
+// Copyright 2017 Sysdata S.p.A.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#import <Foundation/Foundation.h>
+
+/**
+ * Benchmarks of the hot paths of SDLocalizationManager on synthetic tables.
+ *
+ * The suite writes .lproj folders with generated tables into the resources of the main bundle, configures the shared manager with them and measures table parsing, lookups by tier, misses, first loads, added strings, placeholders, prefix queries, formatters and concurrent lookups.
+ * Each result is a dictionary with the name of the benchmark, its parameters, the number of operations, the total time and the derived time per operation and throughput.
+ */
+@interface GTYBenchmarkSuite : NSObject
+
+/**
+ * @param keyCounts Number of keys of the generated tables: each benchmark on tables runs once per size.
+ * @param localeCount Number of locales with generated tables, at least 3: the selected one, its generic language and the default one.
+ * @param iterations Number of operations of each measure. Slower paths run a fraction of them.
+ * @param threadCounts Numbers of threads of the concurrent benchmarks.
+ */
+- (instancetype) initWithKeyCounts:(NSArray<NSNumber*>*)keyCounts localeCount:(NSUInteger)localeCount iterations:(NSUInteger)iterations threadCounts:(NSArray<NSNumber*>*)threadCounts;
+
+/**
+ * Directory where .lproj folders are generated. The default is the resource path of the main bundle.
+ */
+@property (nonatomic, copy) NSString* resourcesPath;
+
+/**
+ * Generates the tables, runs all the benchmarks and removes the tables.
+ *
+ * @return A report with the configuration, the results and the statistics of the manager, ready to be serialized as JSON.
+ */
+- (NSDictionary*) run;
+
+@end
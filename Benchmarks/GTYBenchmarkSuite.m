@@ -0,0 +1,541 @@
+// Copyright 2017 Sysdata S.p.A.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#import "GTYBenchmarkSuite.h"
+#import "SDLocalizationManager.h"
+#import "GTYStringsParser.h"
+#import "GTYCompactTable.h"
+#import "GTYStringInternPool.h"
+#import <time.h>
+#import <unistd.h>
+#import <fcntl.h>
+
+#define kSelectedLocale         @"en-GB"
+#define kGenericLocale          @"en"
+#define kDefaultLocale          @"it"
+#define kOtherLocales           @[@"de", @"fr", @"es", @"pt", @"nl", @"sv", @"pl", @"ja"]
+
+// tables loaded by the first-load benchmark, for each size
+#define kFirstLoadRepetitions   3
+// distinct keys looked up in a loop
+#define kLookupKeysCount        1024
+#define kPrefixArrayCount       100
+#define kAddedStringsBatchSize  100
+
+// sink for the results of the measured operations, so that they are not optimized away
+static volatile NSUInteger GTYBenchmarkSink;
+
+static uint64_t GTYBenchmarkNanoseconds(void)
+{
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return (uint64_t)time.tv_sec * NSEC_PER_SEC + (uint64_t)time.tv_nsec;
+}
+
+@interface GTYBenchmarkSuite ()
+@property (nonatomic, copy) NSArray<NSNumber*>* keyCounts;
+@property (nonatomic, assign) NSUInteger localeCount;
+@property (nonatomic, assign) NSUInteger iterations;
+@property (nonatomic, copy) NSArray<NSNumber*>* threadCounts;
+@property (nonatomic, strong) NSMutableArray<NSString*>* generatedPaths;
+@property (nonatomic, strong) NSMutableArray<NSDictionary*>* results;
+@end
+
+@implementation GTYBenchmarkSuite
+
+- (instancetype) initWithKeyCounts:(NSArray<NSNumber*>*)keyCounts localeCount:(NSUInteger)localeCount iterations:(NSUInteger)iterations threadCounts:(NSArray<NSNumber*>*)threadCounts
+{
+    self = [super init];
+    if (self)
+    {
+        _keyCounts = [keyCounts copy];
+        _localeCount = MIN(MAX(localeCount, 3), 3 + kOtherLocales.count);
+        _iterations = MAX(iterations, 100);
+        _threadCounts = [threadCounts copy];
+        _resourcesPath = [[NSBundle mainBundle] resourcePath];
+        _generatedPaths = [NSMutableArray array];
+        _results = [NSMutableArray array];
+    }
+    return self;
+}
+
+- (NSArray<NSString*>*) locales
+{
+    NSArray* locales = [@[kSelectedLocale, kGenericLocale, kDefaultLocale] arrayByAddingObjectsFromArray:kOtherLocales];
+    return [locales subarrayWithRange:NSMakeRange(0, self.localeCount)];
+}
+
+#pragma mark - Run
+
+- (NSDictionary*) run
+{
+    // tables are written before the manager or the bundle search for them
+    [self generateFixtures];
+
+    SDLocalizationManager* manager = [SDLocalizationManager sharedManager];
+    [manager resetSavedSettings];
+    manager.allowsOnlyLocalesAvailableOnSystem = NO;
+    [manager setDefaultLocaleWithIdentifier:kDefaultLocale];
+    [manager setSupportedLocales:[self locales]];
+    [manager setSelectedLocaleWithIdentifier:kSelectedLocale];
+    [manager resetStatistics];
+
+    for (NSNumber* keyCount in self.keyCounts)
+    {
+        NSUInteger count = keyCount.unsignedIntegerValue;
+        [self measureParsersWithKeyCount:count];
+        [self measureFirstLoadWithKeyCount:count];
+        [self measureLookupsWithKeyCount:count];
+        [self measureMissesWithKeyCount:count];
+    }
+    [self measureAddedStrings];
+    [self measurePlaceholders];
+    [self measurePrefixArray];
+    [self measureFormatters];
+    [self measureConcurrentLookups];
+
+    NSDictionary* report = @{@"suite": @"Glotty",
+                             @"schemaVersion": @1,
+                             @"date": [self timestamp],
+                             @"platform": @{@"os": [[NSProcessInfo processInfo] operatingSystemVersionString],
+                                            @"processors": @([[NSProcessInfo processInfo] activeProcessorCount])},
+                             @"configuration": @{@"keyCounts": self.keyCounts,
+                                                 @"locales": [self locales],
+                                                 @"iterations": @(self.iterations),
+                                                 @"threadCounts": self.threadCounts},
+                             @"results": [self.results copy],
+                             @"statistics": [[manager statistics] dictionaryRepresentation],
+                             @"memory": @{@"loadedTablesBytes": @([manager loadedTablesByteCount]),
+                                          @"internedStrings": @([GTYStringInternPool sharedPool].count),
+                                          @"internedBytes": @([GTYStringInternPool sharedPool].byteCount)}};
+
+    [manager resetSavedSettings];
+    [self removeFixtures];
+    return report;
+}
+
+#pragma mark - Benchmarks
+
+/**
+ * Parses the same table with GTYStringsParser, into a dictionary and into a compact table, and with the property list parser, as old-style text and as binary property list.
+ */
+- (void) measureParsersWithKeyCount:(NSUInteger)keyCount
+{
+    NSString* directory = [self.resourcesPath stringByAppendingPathComponent:[kDefaultLocale stringByAppendingPathExtension:@"lproj"]];
+    NSString* textPath = [directory stringByAppendingPathComponent:[[self tableNameWithKeyCount:keyCount] stringByAppendingPathExtension:@"strings"]];
+    NSDictionary* strings = [GTYStringsParser stringsWithContentsOfFile:textPath error:nil];
+    NSData* binaryData = [NSPropertyListSerialization dataWithPropertyList:strings format:NSPropertyListBinaryFormat_v1_0 options:0 error:nil];
+    NSString* binaryPath = [NSTemporaryDirectory() stringByAppendingPathComponent:[NSString stringWithFormat:@"GTYBenchmark%lu.strings", (unsigned long)keyCount]];
+    [binaryData writeToFile:binaryPath atomically:YES];
+
+    NSUInteger repetitions = MAX(self.iterations / MAX(keyCount, 1) / 10, 3);
+    NSDictionary<NSString*, NSString*>* pathsByFormat = @{@"text": textPath, @"binary": binaryPath};
+    for (NSString* format in @[@"text", @"binary"])
+    {
+        NSString* path = pathsByFormat[format];
+        NSUInteger bytes = (NSUInteger)[[NSFileManager defaultManager] attributesOfItemAtPath:path error:nil].fileSize;
+        [self addResultWithName:@"parse.parser"
+                     parameters:@{@"keys": @(keyCount), @"format": format, @"bytes": @(bytes)}
+                     iterations:repetitions
+                          block:^(NSUInteger index) {
+            GTYBenchmarkSink += [GTYStringsParser stringsWithContentsOfFile:path error:nil].count;
+        }];
+        [self addResultWithName:@"parse.compact"
+                     parameters:@{@"keys": @(keyCount), @"format": format, @"bytes": @(bytes)}
+                     iterations:repetitions
+                          block:^(NSUInteger index) {
+            GTYBenchmarkSink += [GTYStringsParser compactTableWithContentsOfFile:path error:nil].count;
+        }];
+        [self addResultWithName:@"parse.propertyList"
+                     parameters:@{@"keys": @(keyCount), @"format": format, @"bytes": @(bytes)}
+                     iterations:repetitions
+                          block:^(NSUInteger index) {
+            GTYBenchmarkSink += [NSMutableDictionary dictionaryWithContentsOfFile:path].count;
+        }];
+    }
+    [[NSFileManager defaultManager] removeItemAtPath:binaryPath error:nil];
+}
+
+/**
+ * Time of the first lookup of tables never loaded before, which reads and parses them.
+ */
+- (void) measureFirstLoadWithKeyCount:(NSUInteger)keyCount
+{
+    SDLocalizationManager* manager = [SDLocalizationManager sharedManager];
+    SDLocalizationStatistics* before = [manager statistics];
+    uint64_t nanoseconds = 0;
+    for (NSUInteger repetition = 0; repetition < kFirstLoadRepetitions; repetition++)
+    {
+        NSString* table = [self firstLoadTableNameWithKeyCount:keyCount repetition:repetition];
+        uint64_t start = GTYBenchmarkNanoseconds();
+        GTYBenchmarkSink += [manager localizedKey:[self keyAtIndex:0] fromTable:table].length;
+        nanoseconds += GTYBenchmarkNanoseconds() - start;
+    }
+    SDLocalizationStatistics* after = [manager statistics];
+    [self addResultWithName:@"table.firstLoad"
+                 parameters:@{@"keys": @(keyCount), @"bytes": @((after.tableLoadBytes - before.tableLoadBytes) / kFirstLoadRepetitions)}
+                 operations:kFirstLoadRepetitions
+                nanoseconds:nanoseconds];
+}
+
+/**
+ * Hits served by each tier: the selected locale contains the first half of the keys, its generic language the first three quarters and the default locale all of them.
+ */
+- (void) measureLookupsWithKeyCount:(NSUInteger)keyCount
+{
+    SDLocalizationManager* manager = [SDLocalizationManager sharedManager];
+    NSString* table = [self tableNameWithKeyCount:keyCount];
+    NSDictionary<NSString*, NSArray<NSNumber*>*>* rangesByTier = @{@"selected": @[@0, @(keyCount / 2)],
+                                                                    @"fallback": @[@(keyCount / 2), @(keyCount * 3 / 4)],
+                                                                    @"default": @[@(keyCount * 3 / 4), @(keyCount)]};
+    for (NSString* tier in @[@"selected", @"fallback", @"default"])
+    {
+        NSUInteger start = rangesByTier[tier][0].unsignedIntegerValue;
+        NSUInteger end = rangesByTier[tier][1].unsignedIntegerValue;
+        if (end <= start)
+        {
+            continue;
+        }
+        NSArray<NSString*>* keys = [self keysFrom:start to:end];
+        [self addResultWithName:[@"lookup.hit." stringByAppendingString:tier]
+                     parameters:@{@"keys": @(keyCount)}
+                     iterations:self.iterations
+                          block:^(NSUInteger index) {
+            GTYBenchmarkSink += [manager localizedKey:keys[index % keys.count] fromTable:table].length;
+        }];
+    }
+}
+
+/**
+ * Misses return the default value. They are logged by the manager, so stderr is silenced while they run.
+ */
+- (void) measureMissesWithKeyCount:(NSUInteger)keyCount
+{
+    SDLocalizationManager* manager = [SDLocalizationManager sharedManager];
+    NSString* table = [self tableNameWithKeyCount:keyCount];
+    NSMutableArray<NSString*>* keys = [NSMutableArray arrayWithCapacity:kLookupKeysCount];
+    for (NSUInteger index = 0; index < kLookupKeysCount; index++)
+    {
+        [keys addObject:[NSString stringWithFormat:@"missing.%06lu", (unsigned long)index]];
+    }
+
+    int savedStderr = [self silenceStderr];
+    [self addResultWithName:@"lookup.miss"
+                 parameters:@{@"keys": @(keyCount)}
+                 iterations:self.iterations / 10
+                      block:^(NSUInteger index) {
+        GTYBenchmarkSink += [manager localizedKey:keys[index % keys.count] fromTable:table withDefaultValue:@"-"].length;
+    }];
+    [self restoreStderr:savedStderr];
+}
+
+/**
+ * Throughput of addStrings: in batches, including the flush of the journal to disk.
+ */
+- (void) measureAddedStrings
+{
+    SDLocalizationManager* manager = [SDLocalizationManager sharedManager];
+    NSString* table = @"BenchAdded";
+    NSUInteger batches = MAX(self.iterations / 1000, 10);
+    NSMutableArray<NSDictionary*>* batchStrings = [NSMutableArray arrayWithCapacity:batches];
+    for (NSUInteger batch = 0; batch < batches; batch++)
+    {
+        NSMutableDictionary* strings = [NSMutableDictionary dictionaryWithCapacity:kAddedStringsBatchSize];
+        for (NSUInteger index = 0; index < kAddedStringsBatchSize; index++)
+        {
+            NSString* key = [NSString stringWithFormat:@"added.%06lu", (unsigned long)(batch * kAddedStringsBatchSize + index)];
+            strings[key] = [key uppercaseString];
+        }
+        [batchStrings addObject:strings];
+    }
+
+    uint64_t start = GTYBenchmarkNanoseconds();
+    for (NSDictionary* strings in batchStrings)
+    {
+        [manager addStrings:strings toTableWithName:table forLocalization:kSelectedLocale];
+    }
+    [manager flushPendingWrites];
+    uint64_t nanoseconds = GTYBenchmarkNanoseconds() - start;
+    [self addResultWithName:@"addStrings"
+                 parameters:@{@"batchSize": @(kAddedStringsBatchSize), @"batches": @(batches)}
+                 operations:batches * kAddedStringsBatchSize
+                nanoseconds:nanoseconds];
+
+    [manager resetAddedStringsToTableWithName:table forLocalization:kSelectedLocale];
+    [manager flushPendingWrites];
+}
+
+- (void) measurePlaceholders
+{
+    SDLocalizationManager* manager = [SDLocalizationManager sharedManager];
+    NSDictionary* placeholders = @{@"%name%": @"Anna", @"%count%": @"12", @"%sender%": @"Marco"};
+    [self addResultWithName:@"placeholder.render"
+                 parameters:@{@"placeholders": @(placeholders.count)}
+                 iterations:self.iterations
+                      block:^(NSUInteger index) {
+        GTYBenchmarkSink += [manager localizedKey:@"greeting" fromTable:@"Localizable" placeholderDictionary:placeholders withDefaultValue:nil].length;
+    }];
+}
+
+- (void) measurePrefixArray
+{
+    SDLocalizationManager* manager = [SDLocalizationManager sharedManager];
+    [self addResultWithName:@"prefix.array"
+                 parameters:@{@"values": @(kPrefixArrayCount)}
+                 iterations:self.iterations / 100
+                      block:^(NSUInteger index) {
+        GTYBenchmarkSink += [manager arrayOfLocalizedStringsWithPrefix:@"list"].count;
+    }];
+}
+
+- (void) measureFormatters
+{
+    SDLocalizationManager* manager = [SDLocalizationManager sharedManager];
+    NSDate* date = [NSDate dateWithTimeIntervalSince1970:1500000000];
+    for (NSNumber* threadCount in self.threadCounts)
+    {
+        [self addResultWithName:@"formatter.date"
+                     parameters:@{@"threads": threadCount}
+                        threads:threadCount.unsignedIntegerValue
+                     iterations:self.iterations / 10
+                          block:^(NSUInteger index) {
+            GTYBenchmarkSink += [[manager dateFormatterWithTemplate:@"yMMMd" timeZone:nil] stringFromDate:[date dateByAddingTimeInterval:index]].length;
+        }];
+        [self addResultWithName:@"formatter.percentage"
+                     parameters:@{@"threads": threadCount}
+                        threads:threadCount.unsignedIntegerValue
+                     iterations:self.iterations / 10
+                          block:^(NSUInteger index) {
+            GTYBenchmarkSink += [manager.percentageFormatter stringFromNumber:@(index / 1000.0)].length;
+        }];
+    }
+}
+
+/**
+ * Lookups on the largest table from several threads. Each thread runs all the iterations, so the throughput should grow with the number of threads.
+ */
+- (void) measureConcurrentLookups
+{
+    SDLocalizationManager* manager = [SDLocalizationManager sharedManager];
+    NSUInteger keyCount = [[self.keyCounts valueForKeyPath:@"@max.unsignedIntegerValue"] unsignedIntegerValue];
+    NSString* table = [self tableNameWithKeyCount:keyCount];
+    NSArray<NSString*>* keys = [self keysFrom:0 to:keyCount / 2];
+    for (NSNumber* threadCount in self.threadCounts)
+    {
+        [self addResultWithName:@"lookup.concurrent"
+                     parameters:@{@"keys": @(keyCount), @"threads": threadCount}
+                        threads:threadCount.unsignedIntegerValue
+                     iterations:self.iterations
+                          block:^(NSUInteger index) {
+            GTYBenchmarkSink += [manager localizedKey:keys[index % keys.count] fromTable:table].length;
+        }];
+    }
+}
+
+#pragma mark - Measures
+
+- (void) addResultWithName:(NSString*)name parameters:(NSDictionary*)parameters iterations:(NSUInteger)iterations block:(void (^)(NSUInteger index))block
+{
+    [self addResultWithName:name parameters:parameters threads:1 iterations:iterations block:block];
+}
+
+/**
+ * Runs the block a tenth of the iterations to warm up, then measures the given iterations on each thread.
+ */
+- (void) addResultWithName:(NSString*)name parameters:(NSDictionary*)parameters threads:(NSUInteger)threads iterations:(NSUInteger)iterations block:(void (^)(NSUInteger index))block
+{
+    iterations = MAX(iterations, 1);
+    for (NSUInteger index = 0; index < iterations / 10; index++)
+    {
+        block(index);
+    }
+
+    uint64_t start = GTYBenchmarkNanoseconds();
+    if (threads <= 1)
+    {
+        for (NSUInteger index = 0; index < iterations; index++)
+        {
+            block(index);
+        }
+    }
+    else
+    {
+        dispatch_apply(threads, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^(size_t thread) {
+            for (NSUInteger index = 0; index < iterations; index++)
+            {
+                block(index + thread);
+            }
+        });
+    }
+    uint64_t nanoseconds = GTYBenchmarkNanoseconds() - start;
+    [self addResultWithName:name parameters:parameters operations:iterations * MAX(threads, 1) nanoseconds:nanoseconds];
+}
+
+- (void) addResultWithName:(NSString*)name parameters:(NSDictionary*)parameters operations:(NSUInteger)operations nanoseconds:(uint64_t)nanoseconds
+{
+    double nanosecondsPerOperation = operations > 0 ? (double)nanoseconds / operations : 0;
+    double operationsPerSecond = nanoseconds > 0 ? operations * (double)NSEC_PER_SEC / nanoseconds : 0;
+    NSDictionary* result = @{@"name": name,
+                             @"parameters": parameters ?: @{},
+                             @"operations": @(operations),
+                             @"nanoseconds": @(nanoseconds),
+                             @"nsPerOp": @(round(nanosecondsPerOperation * 10) / 10),
+                             @"opsPerSec": @(round(operationsPerSecond))};
+    [self.results addObject:result];
+    fprintf(stderr, "%-22s %-40s %12.1f ns/op %14.0f op/s\n", name.UTF8String, [self descriptionOfParameters:parameters].UTF8String, nanosecondsPerOperation, operationsPerSecond);
+}
+
+- (NSString*) descriptionOfParameters:(NSDictionary*)parameters
+{
+    NSMutableArray* components = [NSMutableArray array];
+    for (NSString* key in [parameters.allKeys sortedArrayUsingSelector:@selector(compare:)])
+    {
+        [components addObject:[NSString stringWithFormat:@"%@=%@", key, parameters[key]]];
+    }
+    return [components componentsJoinedByString:@" "];
+}
+
+- (int) silenceStderr
+{
+    fflush(stderr);
+    int savedStderr = dup(STDERR_FILENO);
+    int devNull = open("/dev/null", O_WRONLY);
+    if (devNull >= 0)
+    {
+        dup2(devNull, STDERR_FILENO);
+        close(devNull);
+    }
+    return savedStderr;
+}
+
+- (void) restoreStderr:(int)savedStderr
+{
+    if (savedStderr >= 0)
+    {
+        fflush(stderr);
+        dup2(savedStderr, STDERR_FILENO);
+        close(savedStderr);
+    }
+}
+
+- (NSString*) timestamp
+{
+    NSDateFormatter* formatter = [NSDateFormatter new];
+    formatter.locale = [NSLocale localeWithLocaleIdentifier:@"en_US_POSIX"];
+    formatter.timeZone = [NSTimeZone timeZoneForSecondsFromGMT:0];
+    formatter.dateFormat = @"yyyy-MM-dd'T'HH:mm:ss'Z'";
+    return [formatter stringFromDate:[NSDate date]];
+}
+
+#pragma mark - Fixtures
+
+- (NSString*) keyAtIndex:(NSUInteger)index
+{
+    return [NSString stringWithFormat:@"key.%06lu", (unsigned long)index];
+}
+
+/**
+ * Returns up to kLookupKeysCount keys evenly spread in the given range.
+ */
+- (NSArray<NSString*>*) keysFrom:(NSUInteger)start to:(NSUInteger)end
+{
+    NSUInteger count = MIN(end - start, kLookupKeysCount);
+    NSUInteger step = MAX((end - start) / MAX(count, 1), 1);
+    NSMutableArray<NSString*>* keys = [NSMutableArray arrayWithCapacity:count];
+    for (NSUInteger index = start; index < end && keys.count < count; index += step)
+    {
+        [keys addObject:[self keyAtIndex:index]];
+    }
+    return keys;
+}
+
+- (NSString*) tableNameWithKeyCount:(NSUInteger)keyCount
+{
+    return [NSString stringWithFormat:@"Bench%lu", (unsigned long)keyCount];
+}
+
+- (NSString*) firstLoadTableNameWithKeyCount:(NSUInteger)keyCount repetition:(NSUInteger)repetition
+{
+    return [NSString stringWithFormat:@"BenchLoad%lu_%lu", (unsigned long)keyCount, (unsigned long)repetition];
+}
+
+- (void) generateFixtures
+{
+    for (NSString* locale in [self locales])
+    {
+        NSString* directory = [self.resourcesPath stringByAppendingPathComponent:[locale stringByAppendingPathExtension:@"lproj"]];
+        if (![[NSFileManager defaultManager] fileExistsAtPath:directory])
+        {
+            [[NSFileManager defaultManager] createDirectoryAtPath:directory withIntermediateDirectories:YES attributes:nil error:nil];
+            [self.generatedPaths addObject:directory];
+        }
+
+        for (NSNumber* keyCount in self.keyCounts)
+        {
+            NSUInteger count = keyCount.unsignedIntegerValue;
+            // the selected locale has the first half of the keys, its generic language three quarters, the others all of them
+            NSUInteger localeKeyCount = [locale isEqualToString:kSelectedLocale] ? count / 2 : ([locale isEqualToString:kGenericLocale] ? count * 3 / 4 : count);
+            [self writeTableWithName:[self tableNameWithKeyCount:count] keyCount:localeKeyCount locale:locale directory:directory];
+            if ([locale isEqualToString:kSelectedLocale])
+            {
+                for (NSUInteger repetition = 0; repetition < kFirstLoadRepetitions; repetition++)
+                {
+                    [self writeTableWithName:[self firstLoadTableNameWithKeyCount:count repetition:repetition] keyCount:count locale:locale directory:directory];
+                }
+            }
+        }
+
+        if ([locale isEqualToString:kSelectedLocale])
+        {
+            NSMutableString* localizable = [NSMutableString string];
+            [localizable appendString:@"\"greeting\" = \"Hello %name%, you have %count% new messages from %sender%\";\n"];
+            for (NSUInteger index = 0; index < kPrefixArrayCount; index++)
+            {
+                [localizable appendFormat:@"\"list.%lu\" = \"Item %lu\";\n", (unsigned long)index, (unsigned long)index];
+            }
+            [self writeString:localizable toPath:[directory stringByAppendingPathComponent:@"Localizable.strings"]];
+        }
+    }
+}
+
+- (void) writeTableWithName:(NSString*)tableName keyCount:(NSUInteger)keyCount locale:(NSString*)locale directory:(NSString*)directory
+{
+    NSMutableString* content = [NSMutableString stringWithCapacity:keyCount * 48];
+    [content appendFormat:@"/* %@: %lu generated keys */\n", tableName, (unsigned long)keyCount];
+    for (NSUInteger index = 0; index < keyCount; index++)
+    {
+        [content appendFormat:@"\"key.%06lu\" = \"Value %lu for %@\";\n", (unsigned long)index, (unsigned long)index, locale];
+    }
+    [self writeString:content toPath:[directory stringByAppendingPathComponent:[tableName stringByAppendingPathExtension:@"strings"]]];
+}
+
+- (void) writeString:(NSString*)string toPath:(NSString*)path
+{
+    [string writeToFile:path atomically:YES encoding:NSUTF8StringEncoding error:nil];
+    if (![self.generatedPaths containsObject:path.stringByDeletingLastPathComponent])
+    {
+        [self.generatedPaths addObject:path];
+    }
+}
+
+- (void) removeFixtures
+{
+    for (NSString* path in self.generatedPaths)
+    {
+        [[NSFileManager defaultManager] removeItemAtPath:path error:nil];
+    }
+    [self.generatedPaths removeAllObjects];
+}
+
+@end
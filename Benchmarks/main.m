@@ -0,0 +1,86 @@
+// Copyright 2017 Sysdata S.p.A.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#import <Foundation/Foundation.h>
+#import "GTYBenchmarkSuite.h"
+
+/**
+ * Parses a comma separated list of positive integers, e.g. "1000,10000".
+ */
+static NSArray<NSNumber*>* GTYBenchmarkNumbers(NSString* argument, NSArray<NSNumber*>* defaultNumbers)
+{
+    NSMutableArray<NSNumber*>* numbers = [NSMutableArray array];
+    for (NSString* component in [argument componentsSeparatedByString:@","])
+    {
+        NSInteger value = [component integerValue];
+        if (value > 0)
+        {
+            [numbers addObject:@(value)];
+        }
+    }
+    return numbers.count > 0 ? numbers : defaultNumbers;
+}
+
+/**
+ * Usage: glotty-bench [-keys 1000,10000,100000] [-locales 4] [-iterations 100000] [-threads 1,2,4,8] [-output results.json] [-resources path]
+ *
+ * Results are printed on stderr while they are measured and written as JSON to the output file, or to stdout.
+ */
+int main(int argc, const char* argv[])
+{
+    @autoreleasepool
+    {
+        // arguments in the form -name value are parsed by NSUserDefaults
+        NSUserDefaults* arguments = [NSUserDefaults standardUserDefaults];
+        NSArray* keyCounts = GTYBenchmarkNumbers([arguments stringForKey:@"keys"], @[@1000, @10000, @100000]);
+        NSArray* threadCounts = GTYBenchmarkNumbers([arguments stringForKey:@"threads"], @[@1, @2, @4, @8]);
+        NSInteger localeCount = [arguments integerForKey:@"locales"];
+        NSInteger iterations = [arguments integerForKey:@"iterations"];
+
+        GTYBenchmarkSuite* suite = [[GTYBenchmarkSuite alloc] initWithKeyCounts:keyCounts
+                                                                    localeCount:localeCount > 0 ? localeCount : 4
+                                                                     iterations:iterations > 0 ? iterations : 100000
+                                                                   threadCounts:threadCounts];
+        NSString* resourcesPath = [arguments stringForKey:@"resources"];
+        if (resourcesPath.length > 0)
+        {
+            suite.resourcesPath = resourcesPath;
+        }
+        NSDictionary* report = [suite run];
+
+        NSError* error = nil;
+        NSData* data = [NSJSONSerialization dataWithJSONObject:report options:NSJSONWritingPrettyPrinted error:&error];
+        if (!data)
+        {
+            fprintf(stderr, "Unable to serialize the results: %s\n", error.localizedDescription.UTF8String);
+            return 1;
+        }
+
+        NSString* outputPath = [arguments stringForKey:@"output"];
+        if (outputPath.length > 0)
+        {
+            if (![data writeToFile:outputPath options:NSDataWritingAtomic error:&error])
+            {
+                fprintf(stderr, "Unable to write %s: %s\n", outputPath.UTF8String, error.localizedDescription.UTF8String);
+                return 1;
+            }
+        }
+        else
+        {
+            fwrite(data.bytes, 1, data.length, stdout);
+            fputc('\n', stdout);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,109 @@
+//
+//  GTYCompactTableTests.m
+//  Tests
+//
+
+@import XCTest;
+#import <Glotty/GTYCompactTable.h>
+
+@interface GTYCompactTableTests : XCTestCase
+
+@end
+
+@implementation GTYCompactTableTests
+
+#pragma mark - Tables
+
+- (void)testRoundTrip
+{
+    NSDictionary* strings = @{@"a": @"1", @"unicode ü": @"値 \U0001F600", @"empty": @"", @"same": @"same"};
+    GTYCompactTable* table = [GTYCompactTable tableWithStrings:strings];
+    XCTAssertEqual(table.count, strings.count);
+    XCTAssertTrue([table isEqualToDictionary:strings]);
+    XCTAssertNil(table[@"missing"]);
+    XCTAssertNil(table[@"A"]);
+    XCTAssertGreaterThan(table.byteSize, (NSUInteger)0);
+
+    // values are created once
+    XCTAssertTrue(table[@"a"] == table[@"a"]);
+
+    GTYCompactTable* emptyTable = [GTYCompactTable tableWithStrings:@{}];
+    XCTAssertEqual(emptyTable.count, (NSUInteger)0);
+    XCTAssertNil(emptyTable[@"a"]);
+}
+
+- (void)testLargeTable
+{
+    NSMutableDictionary* strings = [NSMutableDictionary dictionary];
+    for (NSUInteger index = 0; index < 5000; index++)
+    {
+        strings[[NSString stringWithFormat:@"key.%lu", (unsigned long)index]] = [NSString stringWithFormat:@"value %lu", (unsigned long)index];
+    }
+    GTYCompactTable* table = [GTYCompactTable tableWithStrings:strings];
+    XCTAssertTrue([table isEqualToDictionary:strings]);
+    XCTAssertEqual(table.allKeys.count, strings.count);
+}
+
+- (void)testKeysWithNulBytes
+{
+    GTYCompactTableBuilder* builder = [[GTYCompactTableBuilder alloc] initWithCapacity:2];
+    XCTAssertTrue([builder addKeyBytes:"a\0b" length:3 valueBytes:"nul" length:3 replacingExisting:NO]);
+    XCTAssertTrue([builder addKeyBytes:"a" length:1 valueBytes:"plain" length:5 replacingExisting:NO]);
+    GTYCompactTable* table = [builder build];
+
+    XCTAssertEqual(table.count, (NSUInteger)2);
+    XCTAssertEqualObjects(table[([NSString stringWithFormat:@"a%Cb", (unichar)0])], @"nul");
+    XCTAssertEqualObjects(table[@"a"], @"plain");
+}
+
+#pragma mark - Builder
+
+- (void)testReplacingExisting
+{
+    GTYCompactTableBuilder* builder = [[GTYCompactTableBuilder alloc] initWithCapacity:0];
+    XCTAssertTrue([builder addString:@"1" forKey:@"a" replacingExisting:NO]);
+    XCTAssertFalse([builder addString:@"2" forKey:@"a" replacingExisting:NO]);
+    XCTAssertEqual(builder.count, (NSUInteger)1);
+    XCTAssertEqualObjects([builder build][@"a"], @"1");
+
+    // the builder is emptied by build
+    XCTAssertEqual(builder.count, (NSUInteger)0);
+    XCTAssertTrue([builder addString:@"1" forKey:@"a" replacingExisting:NO]);
+    XCTAssertTrue([builder addString:@"2" forKey:@"a" replacingExisting:YES]);
+    XCTAssertEqualObjects([builder build][@"a"], @"2");
+}
+
+- (void)testSources
+{
+    GTYCompactTableBuilder* builder = [[GTYCompactTableBuilder alloc] initWithCapacity:2];
+    [builder addString:@"base" forKey:@"a" replacingExisting:NO];
+    builder.source = 2;
+    [builder addString:@"override" forKey:@"b" replacingExisting:NO];
+    GTYCompactTable* table = [builder build];
+
+    uint8_t source = UINT8_MAX;
+    XCTAssertEqualObjects([table objectForKey:@"a" source:&source], @"base");
+    XCTAssertEqual(source, 0);
+    XCTAssertEqualObjects([table objectForKey:@"b" source:&source], @"override");
+    XCTAssertEqual(source, 2);
+    XCTAssertNil([table objectForKey:@"missing" source:&source]);
+    XCTAssertEqualObjects([table objectForKey:@"a" source:NULL], @"base");
+}
+
+- (void)testAddMissingEntries
+{
+    GTYCompactTable* fallback = [GTYCompactTable tableWithStrings:@{@"a": @"fallback a", @"b": @"fallback b", @"skip.c": @"fallback c"}];
+    GTYCompactTableBuilder* builder = [[GTYCompactTableBuilder alloc] initWithCapacity:3];
+    [builder addString:@"own a" forKey:@"a" replacingExisting:NO];
+
+    NSMutableSet* addedKeys = [NSMutableSet set];
+    [builder addMissingEntriesOfTable:fallback passingTest:^BOOL(const char* keyBytes, NSUInteger keyLength) {
+        return !(keyLength >= 5 && memcmp(keyBytes, "skip.", 5) == 0);
+    } usingBlock:^(NSString* key) {
+        [addedKeys addObject:key];
+    }];
+    XCTAssertEqualObjects(addedKeys, [NSSet setWithObject:@"b"]);
+    XCTAssertEqualObjects([builder build], (@{@"a": @"own a", @"b": @"fallback b"}));
+}
+
+@end
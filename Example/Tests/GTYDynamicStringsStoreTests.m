@@ -0,0 +1,192 @@
+//
+//  GTYDynamicStringsStoreTests.m
+//  Tests
+//
+
+@import XCTest;
+#import <Glotty/GTYDynamicStringsStore.h>
+
+@interface GTYDynamicStringsStoreTests : XCTestCase
+@property (nonatomic, strong) NSString* directoryPath;
+@end
+
+@implementation GTYDynamicStringsStoreTests
+
+- (void)setUp
+{
+    [super setUp];
+    self.directoryPath = [NSTemporaryDirectory() stringByAppendingPathComponent:[NSUUID UUID].UUIDString];
+    [[NSFileManager defaultManager] createDirectoryAtPath:self.directoryPath withIntermediateDirectories:YES attributes:nil error:NULL];
+}
+
+- (void)tearDown
+{
+    [[NSFileManager defaultManager] removeItemAtPath:self.directoryPath error:NULL];
+    [super tearDown];
+}
+
+- (NSString*) pathOfFileNamed:(NSString*)fileName
+{
+    return [self.directoryPath stringByAppendingPathComponent:fileName];
+}
+
+#pragma mark - Index
+
+- (void)testIndexOfTheDirectory
+{
+    [@{@"title": @"Titolo"} writeToFile:[self pathOfFileNamed:@"Menu_it.strings"] atomically:YES];
+    [[NSData data] writeToFile:[self pathOfFileNamed:@"My_Table_it.journal"] atomically:YES];
+    [[NSData data] writeToFile:[self pathOfFileNamed:@"Other_en.strings"] atomically:YES];
+    [[NSData data] writeToFile:[self pathOfFileNamed:@"notes_it.txt"] atomically:YES];
+
+    GTYDynamicStringsStore* store = [[GTYDynamicStringsStore alloc] initWithDirectoryPath:self.directoryPath];
+    XCTAssertTrue([store hasStringsForTable:@"Menu" localization:@"it"]);
+    XCTAssertTrue([store hasStringsForTable:@"My_Table" localization:@"it"]);
+    XCTAssertFalse([store hasStringsForTable:@"Menu" localization:@"en"]);
+    XCTAssertFalse([store hasStringsForTable:@"notes" localization:@"it"]);
+    XCTAssertEqualObjects([NSSet setWithArray:[store tableNamesForLocalization:@"it"]], ([NSSet setWithObjects:@"Menu", @"My_Table", nil]));
+    XCTAssertEqualObjects([store tableNamesForLocalization:@"en"], @[@"Other"]);
+    XCTAssertEqualObjects([store tableNamesForLocalization:@"de"], @[]);
+}
+
+- (void)testIndexFollowsWrites
+{
+    GTYDynamicStringsStore* store = [[GTYDynamicStringsStore alloc] initWithDirectoryPath:self.directoryPath];
+    XCTAssertFalse([store hasStringsForTable:@"Menu" localization:@"it"]);
+
+    // known before the write reaches the disk
+    [store addStrings:@{@"title": @"Titolo"} toTable:@"Menu" localization:@"it"];
+    XCTAssertTrue([store hasStringsForTable:@"Menu" localization:@"it"]);
+    XCTAssertEqualObjects([store tableNamesForLocalization:@"it"], @[@"Menu"]);
+
+    // resetting a table without strings creates nothing
+    [store removeStringsForTable:@"Other" localization:@"it"];
+    XCTAssertFalse([store hasStringsForTable:@"Other" localization:@"it"]);
+
+    // a reset table is dropped once its files are deleted
+    [store removeStringsForTable:@"Menu" localization:@"it"];
+    [store flush];
+    XCTAssertFalse([store hasStringsForTable:@"Menu" localization:@"it"]);
+    XCTAssertFalse([[NSFileManager defaultManager] fileExistsAtPath:[self pathOfFileNamed:@"Menu_it.journal"]]);
+}
+
+#pragma mark - Journal
+
+- (NSData*) contentsOfJournalNamed:(NSString*)fileName
+{
+    return [NSData dataWithContentsOfFile:[self pathOfFileNamed:fileName]];
+}
+
+- (void) appendBytes:(const void*)bytes length:(NSUInteger)length toFileNamed:(NSString*)fileName
+{
+    NSFileHandle* handle = [NSFileHandle fileHandleForWritingAtPath:[self pathOfFileNamed:fileName]];
+    [handle seekToEndOfFile];
+    [handle writeData:[NSData dataWithBytes:bytes length:length]];
+    [handle closeFile];
+}
+
+- (void)testJournalRoundTrip
+{
+    GTYDynamicStringsStore* store = [[GTYDynamicStringsStore alloc] initWithDirectoryPath:self.directoryPath];
+    [store addStrings:@{@"title": @"Titolo", @"unicode": @"値"} toTable:@"Menu" localization:@"it"];
+    [store addStrings:@{@"title": @"Menu"} toTable:@"Menu" localization:@"it"];
+    [store flush];
+
+    NSData* journal = [self contentsOfJournalNamed:@"Menu_it.journal"];
+    XCTAssertTrue(journal.length > 8);
+    XCTAssertEqual(memcmp(journal.bytes, "GTYJ", 4), 0);
+
+    GTYDynamicStringsStore* reopenedStore = [[GTYDynamicStringsStore alloc] initWithDirectoryPath:self.directoryPath];
+    XCTAssertEqualObjects([reopenedStore stringsForTable:@"Menu" localization:@"it"], (@{@"title": @"Menu", @"unicode": @"値"}));
+    XCTAssertEqualObjects([reopenedStore stringsForTable:@"Menu" localization:@"en"], @{});
+}
+
+- (void)testReplayStopsAtATruncatedRecord
+{
+    GTYDynamicStringsStore* store = [[GTYDynamicStringsStore alloc] initWithDirectoryPath:self.directoryPath];
+    [store addStrings:@{@"title": @"Titolo"} toTable:@"Menu" localization:@"it"];
+    [store flush];
+    NSUInteger validLength = [self contentsOfJournalNamed:@"Menu_it.journal"].length;
+
+    // a set record of a 5 bytes key and value cut by a crash after 3 bytes of its key
+    uint8_t tornRecord[12] = {'S', 5, 0, 0, 0, 5, 0, 0, 0, 'a', 'b', 'c'};
+    [self appendBytes:tornRecord length:sizeof(tornRecord) toFileNamed:@"Menu_it.journal"];
+
+    GTYDynamicStringsStore* reopenedStore = [[GTYDynamicStringsStore alloc] initWithDirectoryPath:self.directoryPath];
+    XCTAssertEqualObjects([reopenedStore stringsForTable:@"Menu" localization:@"it"], @{@"title": @"Titolo"});
+    // reads leave the journal as it is
+    XCTAssertEqual([self contentsOfJournalNamed:@"Menu_it.journal"].length, validLength + sizeof(tornRecord));
+
+    // the first append drops the torn record, so that the new records are not hidden behind it
+    [reopenedStore addStrings:@{@"subtitle": @"Sottotitolo"} toTable:@"Menu" localization:@"it"];
+    [reopenedStore flush];
+    NSUInteger recordLength = 13 + @"subtitle".length + @"Sottotitolo".length;
+    XCTAssertEqual([self contentsOfJournalNamed:@"Menu_it.journal"].length, validLength + recordLength);
+
+    GTYDynamicStringsStore* lastStore = [[GTYDynamicStringsStore alloc] initWithDirectoryPath:self.directoryPath];
+    XCTAssertEqualObjects([lastStore stringsForTable:@"Menu" localization:@"it"], (@{@"title": @"Titolo", @"subtitle": @"Sottotitolo"}));
+}
+
+- (void)testReplayStopsAtACorruptedRecord
+{
+    GTYDynamicStringsStore* store = [[GTYDynamicStringsStore alloc] initWithDirectoryPath:self.directoryPath];
+    [store addStrings:@{@"title": @"Titolo"} toTable:@"Menu" localization:@"it"];
+    [store flush];
+    [store addStrings:@{@"title": @"Menu"} toTable:@"Menu" localization:@"it"];
+    [store flush];
+
+    // flips a bit of the checksum of the last record
+    NSMutableData* journal = [[self contentsOfJournalNamed:@"Menu_it.journal"] mutableCopy];
+    ((uint8_t*)journal.mutableBytes)[journal.length - 1] ^= 0x01;
+    [journal writeToFile:[self pathOfFileNamed:@"Menu_it.journal"] atomically:YES];
+
+    GTYDynamicStringsStore* reopenedStore = [[GTYDynamicStringsStore alloc] initWithDirectoryPath:self.directoryPath];
+    XCTAssertEqualObjects([reopenedStore stringsForTable:@"Menu" localization:@"it"], @{@"title": @"Titolo"});
+}
+
+- (void)testClearRecordDiscardsEarlierStrings
+{
+    GTYDynamicStringsStore* store = [[GTYDynamicStringsStore alloc] initWithDirectoryPath:self.directoryPath];
+    [store addStrings:@{@"title": @"Titolo", @"subtitle": @"Sottotitolo"} toTable:@"Menu" localization:@"it"];
+    [store flush];
+    [store removeStringsForTable:@"Menu" localization:@"it"];
+    [store addStrings:@{@"title": @"Menu"} toTable:@"Menu" localization:@"it"];
+    XCTAssertEqualObjects([store stringsForTable:@"Menu" localization:@"it"], @{@"title": @"Menu"});
+
+    // the journal containing the clear record is compacted
+    [store flush];
+    XCTAssertFalse([[NSFileManager defaultManager] fileExistsAtPath:[self pathOfFileNamed:@"Menu_it.journal"]]);
+    XCTAssertEqualObjects([NSDictionary dictionaryWithContentsOfFile:[self pathOfFileNamed:@"Menu_it.strings"]], @{@"title": @"Menu"});
+
+    GTYDynamicStringsStore* reopenedStore = [[GTYDynamicStringsStore alloc] initWithDirectoryPath:self.directoryPath];
+    XCTAssertEqualObjects([reopenedStore stringsForTable:@"Menu" localization:@"it"], @{@"title": @"Menu"});
+}
+
+- (void)testReadsSeeEveryWriteWithoutWaiting
+{
+    GTYDynamicStringsStore* store = [[GTYDynamicStringsStore alloc] initWithDirectoryPath:self.directoryPath];
+    NSUInteger writeCount = 200;
+    dispatch_group_t group = dispatch_group_create();
+    dispatch_group_async(group, dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^{
+        for (NSUInteger index = 0; index < writeCount; index++)
+        {
+            [store addStrings:@{[NSString stringWithFormat:@"key%lu", (unsigned long)index]: @"value"} toTable:@"Menu" localization:@"it"];
+            if (index % 20 == 0)
+            {
+                [store flush];
+            }
+        }
+    });
+
+    // the strings added never disappear, whether pending, being written or on disk
+    NSUInteger count = 0;
+    while (count < writeCount)
+    {
+        NSUInteger newCount = [store stringsForTable:@"Menu" localization:@"it"].count;
+        XCTAssertGreaterThanOrEqual(newCount, count);
+        count = newCount;
+    }
+    dispatch_group_wait(group, DISPATCH_TIME_FOREVER);
+}
+
+@end
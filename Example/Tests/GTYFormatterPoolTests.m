@@ -0,0 +1,102 @@
+//
+//  GTYFormatterPoolTests.m
+//  Tests
+//
+
+@import XCTest;
+#import <Glotty/GTYFormatterPool.h>
+#import <Glotty/SDLocalizationManager.h>
+
+@interface GTYFormatterPoolTests : XCTestCase
+
+@end
+
+@implementation GTYFormatterPoolTests
+
+- (id) formatterForKey:(NSString*)key pool:(GTYFormatterPool*)pool creations:(NSMutableArray<NSString*>*)creations
+{
+    return [pool formatterForKey:key creator:^id{
+        [creations addObject:key];
+        return [NSObject new];
+    }];
+}
+
+#pragma mark - Threads
+
+- (void)testEachThreadHasItsInstances
+{
+    GTYFormatterPool* pool = [GTYFormatterPool new];
+    NSMutableArray<NSString*>* creations = [NSMutableArray array];
+    id formatter = [self formatterForKey:@"a" pool:pool creations:creations];
+    XCTAssertTrue([self formatterForKey:@"a" pool:pool creations:creations] == formatter);
+    XCTAssertFalse([self formatterForKey:@"b" pool:pool creations:creations] == formatter);
+
+    __block id otherFormatter = nil;
+    NSThread* thread = [[NSThread alloc] initWithBlock:^{
+        otherFormatter = [pool formatterForKey:@"a" creator:^id{
+            return [NSObject new];
+        }];
+    }];
+    XCTestExpectation* expectation = [self expectationForNotification:NSThreadWillExitNotification object:thread handler:nil];
+    [thread start];
+    [self waitForExpectations:@[expectation] timeout:5];
+    XCTAssertNotNil(otherFormatter);
+    XCTAssertFalse(otherFormatter == formatter);
+}
+
+- (void)testInvalidationDiscardsTheInstances
+{
+    GTYFormatterPool* pool = [GTYFormatterPool new];
+    NSMutableArray<NSString*>* creations = [NSMutableArray array];
+    id formatter = [self formatterForKey:@"a" pool:pool creations:creations];
+    [pool invalidate];
+    XCTAssertFalse([self formatterForKey:@"a" pool:pool creations:creations] == formatter);
+    XCTAssertEqualObjects(creations, (@[@"a", @"a"]));
+}
+
+#pragma mark - Limit
+
+- (void)testLeastRecentlyUsedInstanceIsDiscarded
+{
+    GTYFormatterPool* pool = [GTYFormatterPool new];
+    XCTAssertEqual(pool.countLimit, (NSUInteger)32);
+    pool.countLimit = 2;
+    NSMutableArray<NSString*>* creations = [NSMutableArray array];
+    id formatter = [self formatterForKey:@"a" pool:pool creations:creations];
+    [self formatterForKey:@"b" pool:pool creations:creations];
+    XCTAssertTrue([self formatterForKey:@"a" pool:pool creations:creations] == formatter);
+
+    // "b" is the least recently used one
+    [self formatterForKey:@"c" pool:pool creations:creations];
+    XCTAssertTrue([self formatterForKey:@"a" pool:pool creations:creations] == formatter);
+    [self formatterForKey:@"b" pool:pool creations:creations];
+    XCTAssertEqualObjects(creations, (@[@"a", @"b", @"c", @"b"]));
+}
+
+- (void)testPoolWithoutLimit
+{
+    GTYFormatterPool* pool = [GTYFormatterPool new];
+    pool.countLimit = 0;
+    NSMutableArray<NSString*>* creations = [NSMutableArray array];
+    for (NSUInteger index = 0; index < 100; index++)
+    {
+        [self formatterForKey:[NSString stringWithFormat:@"%lu", (unsigned long)index] pool:pool creations:creations];
+    }
+    [self formatterForKey:@"0" pool:pool creations:creations];
+    XCTAssertEqual(creations.count, (NSUInteger)100);
+}
+
+#pragma mark - Manager
+
+- (void)testTimeZoneChangesDiscardTheFormatters
+{
+    SDLocalizationManager* manager = [SDLocalizationManager new];
+    NSDateFormatter* formatter = [manager dateFormatterWithFormat:@"HH:mm" timeZone:nil];
+    XCTAssertTrue([manager dateFormatterWithFormat:@"HH:mm" timeZone:nil] == formatter);
+
+    // formatters without an explicit zone were created with the old system one
+    [[NSNotificationCenter defaultCenter] postNotificationName:NSSystemTimeZoneDidChangeNotification object:nil];
+    XCTAssertFalse([manager dateFormatterWithFormat:@"HH:mm" timeZone:nil] == formatter);
+}
+
+@end
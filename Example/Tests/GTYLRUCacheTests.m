@@ -0,0 +1,114 @@
+//
+//  GTYLRUCacheTests.m
+//  Tests
+//
+
+@import XCTest;
+#import <Glotty/GTYLRUCache.h>
+
+@interface GTYLRUCacheTests : XCTestCase
+
+@end
+
+@implementation GTYLRUCacheTests
+
+- (void)testEvictsLeastRecentlyUsedObjects
+{
+    GTYLRUCache<NSString*, NSString*>* cache = [[GTYLRUCache alloc] initWithTotalCostLimit:10];
+    [cache setObject:@"A" forKey:@"a" cost:4];
+    [cache setObject:@"B" forKey:@"b" cost:4];
+    // reading "a" makes "b" the least recently used object
+    XCTAssertEqualObjects([cache objectForKey:@"a"], @"A");
+    [cache setObject:@"C" forKey:@"c" cost:4];
+
+    XCTAssertNil([cache objectForKey:@"b"]);
+    XCTAssertEqualObjects([cache objectForKey:@"a"], @"A");
+    XCTAssertEqualObjects([cache objectForKey:@"c"], @"C");
+    XCTAssertEqual(cache.count, (NSUInteger)2);
+    XCTAssertEqual(cache.totalCost, (NSUInteger)8);
+}
+
+- (void)testReplacingAnObjectUpdatesItsCost
+{
+    GTYLRUCache<NSString*, NSString*>* cache = [[GTYLRUCache alloc] initWithTotalCostLimit:10];
+    [cache setObject:@"A" forKey:@"a" cost:2];
+    [cache setObject:@"B" forKey:@"b" cost:2];
+    [cache setObject:@"A2" forKey:@"a" cost:7];
+
+    XCTAssertEqual(cache.count, (NSUInteger)2);
+    XCTAssertEqual(cache.totalCost, (NSUInteger)9);
+    XCTAssertEqualObjects([cache objectForKey:@"a"], @"A2");
+
+    // setting nil removes the object
+    [cache setObject:nil forKey:@"a" cost:0];
+    XCTAssertNil([cache objectForKey:@"a"]);
+    XCTAssertEqual(cache.totalCost, (NSUInteger)2);
+}
+
+- (void)testObjectExceedingTheLimitIsNotCached
+{
+    GTYLRUCache<NSString*, NSString*>* cache = [[GTYLRUCache alloc] initWithTotalCostLimit:10];
+    [cache setObject:@"A" forKey:@"a" cost:5];
+    [cache setObject:@"B" forKey:@"b" cost:5];
+    [cache setObject:@"huge" forKey:@"huge" cost:11];
+    XCTAssertNil([cache objectForKey:@"huge"]);
+    // the other objects are not evicted for it
+    XCTAssertEqual(cache.count, (NSUInteger)2);
+
+    // an oversized replacement removes the previous object
+    [cache setObject:@"A2" forKey:@"a" cost:11];
+    XCTAssertNil([cache objectForKey:@"a"]);
+    XCTAssertEqual(cache.totalCost, (NSUInteger)5);
+}
+
+- (void)testLoweringTheLimitTrims
+{
+    GTYLRUCache<NSNumber*, NSString*>* cache = [[GTYLRUCache alloc] initWithTotalCostLimit:0];
+    for (NSUInteger index = 0; index < 10; index++)
+    {
+        [cache setObject:@(index).stringValue forKey:@(index) cost:10];
+    }
+    // no limit
+    XCTAssertEqual(cache.count, (NSUInteger)10);
+
+    cache.totalCostLimit = 30;
+    XCTAssertEqual(cache.count, (NSUInteger)3);
+    XCTAssertEqual(cache.totalCost, (NSUInteger)30);
+    XCTAssertNotNil([cache objectForKey:@9]);
+    XCTAssertNil([cache objectForKey:@6]);
+}
+
+- (void)testRemovals
+{
+    GTYLRUCache<NSString*, NSString*>* cache = [[GTYLRUCache alloc] initWithTotalCostLimit:100];
+    [cache setObject:@"A" forKey:@"a" cost:1];
+    [cache setObject:@"B" forKey:@"b" cost:2];
+    [cache removeObjectForKey:@"a"];
+    [cache removeObjectForKey:@"missing"];
+    XCTAssertEqual(cache.count, (NSUInteger)1);
+    XCTAssertEqual(cache.totalCost, (NSUInteger)2);
+
+    [cache removeAllObjects];
+    XCTAssertEqual(cache.count, (NSUInteger)0);
+    XCTAssertEqual(cache.totalCost, (NSUInteger)0);
+    // the cache is still usable
+    [cache setObject:@"C" forKey:@"c" cost:3];
+    XCTAssertEqualObjects([cache objectForKey:@"c"], @"C");
+}
+
+- (void)testConcurrentAccessKeepsCostConsistent
+{
+    GTYLRUCache<NSNumber*, NSNumber*>* cache = [[GTYLRUCache alloc] initWithTotalCostLimit:64];
+    dispatch_apply(8, dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^(size_t thread) {
+        for (NSUInteger index = 0; index < 1000; index++)
+        {
+            NSNumber* key = @((thread * 1000 + index) % 100);
+            [cache setObject:key forKey:key cost:1];
+            [cache objectForKey:@(index % 100)];
+        }
+    });
+    XCTAssertLessThanOrEqual(cache.totalCost, (NSUInteger)64);
+    XCTAssertEqual(cache.totalCost, cache.count);
+}
+
+@end
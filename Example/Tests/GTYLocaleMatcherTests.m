@@ -0,0 +1,105 @@
+//
+//  GTYLocaleMatcherTests.m
+//  Tests
+//
+
+@import XCTest;
+#import <Glotty/GTYLocaleMatcher.h>
+
+@interface GTYLocaleMatcherTests : XCTestCase
+
+@end
+
+@implementation GTYLocaleMatcherTests
+
+- (void)testExactMatchIgnoresCaseAndSeparator
+{
+    GTYLocaleMatcher* matcher = [[GTYLocaleMatcher alloc] initWithSupportedIdentifiers:@[@"en", @"it", @"pt_BR"]];
+    XCTAssertEqualObjects([matcher bestSupportedIdentifierForIdentifier:@"IT"], @"it");
+    XCTAssertEqualObjects([matcher bestSupportedIdentifierForIdentifier:@"pt-br"], @"pt_BR");
+    XCTAssertNil([matcher bestSupportedIdentifierForIdentifier:@"fr"]);
+    XCTAssertNil([matcher bestSupportedIdentifierForIdentifier:@""]);
+    XCTAssertNil([matcher bestSupportedIdentifierForIdentifier:nil]);
+}
+
+- (void)testRegionPreferences
+{
+    GTYLocaleMatcher* matcher = [[GTYLocaleMatcher alloc] initWithSupportedIdentifiers:@[@"en-GB", @"en-US", @"en"]];
+    XCTAssertEqualObjects([matcher bestSupportedIdentifierForIdentifier:@"en_US"], @"en-US");
+    // the generic locale is preferred to another region
+    XCTAssertEqualObjects([matcher bestSupportedIdentifierForIdentifier:@"en-AU"], @"en");
+
+    GTYLocaleMatcher* regionalMatcher = [[GTYLocaleMatcher alloc] initWithSupportedIdentifiers:@[@"en-GB", @"en-US"]];
+    // at the same distance, the first supported identifier wins
+    XCTAssertEqualObjects([regionalMatcher bestSupportedIdentifierForIdentifier:@"en-AU"], @"en-GB");
+    XCTAssertEqualObjects([regionalMatcher bestSupportedIdentifierForIdentifier:@"en"], @"en-GB");
+}
+
+- (void)testScripts
+{
+    GTYLocaleMatcher* matcher = [[GTYLocaleMatcher alloc] initWithSupportedIdentifiers:@[@"zh-Hant", @"zh-Hans", @"sr-Latn"]];
+    XCTAssertEqualObjects([matcher bestSupportedIdentifierForIdentifier:@"zh-TW"], @"zh-Hant");
+    XCTAssertEqualObjects([matcher bestSupportedIdentifierForIdentifier:@"zh_HK"], @"zh-Hant");
+    XCTAssertEqualObjects([matcher bestSupportedIdentifierForIdentifier:@"zh-CN"], @"zh-Hans");
+    XCTAssertEqualObjects([matcher bestSupportedIdentifierForIdentifier:@"zh"], @"zh-Hans");
+    XCTAssertEqualObjects([matcher bestSupportedIdentifierForIdentifier:@"zh-Hant-TW"], @"zh-Hant");
+    // Serbian is written in Cyrillic unless the script is given
+    XCTAssertNil([matcher bestSupportedIdentifierForIdentifier:@"sr"]);
+    XCTAssertEqualObjects([matcher bestSupportedIdentifierForIdentifier:@"sr-Latn-RS"], @"sr-Latn");
+}
+
+- (void)testLanguageAliases
+{
+    GTYLocaleMatcher* matcher = [[GTYLocaleMatcher alloc] initWithSupportedIdentifiers:@[@"he", @"id", @"nb"]];
+    XCTAssertEqualObjects([matcher bestSupportedIdentifierForIdentifier:@"iw"], @"he");
+    XCTAssertEqualObjects([matcher bestSupportedIdentifierForIdentifier:@"in-ID"], @"id");
+    XCTAssertEqualObjects([matcher bestSupportedIdentifierForIdentifier:@"no"], @"nb");
+}
+
+- (void)testFirstMatchOfPreferredIdentifiers
+{
+    GTYLocaleMatcher* matcher = [[GTYLocaleMatcher alloc] initWithSupportedIdentifiers:@[@"it", @"de"]];
+    NSString* matchedIdentifier = nil;
+    XCTAssertEqualObjects([matcher bestSupportedIdentifierForIdentifiers:@[@"fr-FR", @"de-CH", @"it"] matchedIdentifier:&matchedIdentifier], @"de");
+    XCTAssertEqualObjects(matchedIdentifier, @"de-CH");
+
+    matchedIdentifier = nil;
+    XCTAssertNil([matcher bestSupportedIdentifierForIdentifiers:@[@"fr", @"es"] matchedIdentifier:&matchedIdentifier]);
+    XCTAssertNil(matchedIdentifier);
+}
+
+- (void)testFallbackChains
+{
+    GTYLocaleMatcher* matcher = [[GTYLocaleMatcher alloc] initWithSupportedIdentifiers:@[@"it", @"en", @"zh-Hant", @"zh-Hans"]];
+    XCTAssertEqualObjects([matcher fallbackChainForIdentifier:@"it_IT" defaultIdentifier:@"en"], (@[@"it-IT", @"it", @"en"]));
+    // Traditional Chinese does not fall back on "zh", which is Simplified
+    XCTAssertEqualObjects([matcher fallbackChainForIdentifier:@"zh-Hant-TW" defaultIdentifier:@"en"], (@[@"zh-Hant-TW", @"zh-Hant", @"en"]));
+    // the default locale is not repeated
+    XCTAssertEqualObjects([matcher fallbackChainForIdentifier:@"en" defaultIdentifier:@"en"], (@[@"en"]));
+    XCTAssertEqualObjects([matcher fallbackChainForIdentifier:nil defaultIdentifier:@"en"], (@[@"en"]));
+}
+
+- (void)testFallbackChainOrdersRegionalLocalesByDistance
+{
+    GTYLocaleMatcher* matcher = [[GTYLocaleMatcher alloc] initWithSupportedIdentifiers:@[@"pt-PT", @"pt", @"pt-BR"]];
+    XCTAssertEqualObjects([matcher fallbackChainForIdentifier:@"pt-BR" defaultIdentifier:@"pt-PT"], (@[@"pt-BR", @"pt", @"pt-PT"]));
+}
+
+
+/**
+ * The chains of fallback-chains.json are also checked against Scripts/glotty-pack by glotty-pack-tests.rb, so that resolved packs follow the chain used at runtime.
+ */
+- (void)testFallbackChainsMatchTheStringsPackScript
+{
+    NSURL* url = [[NSBundle bundleForClass:[self class]] URLForResource:@"fallback-chains" withExtension:@"json"];
+    NSDictionary* fixture = [NSJSONSerialization JSONObjectWithData:[NSData dataWithContentsOfURL:url] options:0 error:NULL];
+    XCTAssertNotNil(fixture);
+
+    GTYLocaleMatcher* matcher = [[GTYLocaleMatcher alloc] initWithSupportedIdentifiers:fixture[@"supported"]];
+    for (NSDictionary* entry in fixture[@"chains"])
+    {
+        XCTAssertEqualObjects([matcher fallbackChainForIdentifier:entry[@"identifier"] defaultIdentifier:fixture[@"default"]], entry[@"chain"], @"%@", entry[@"identifier"]);
+    }
+}
+
+@end
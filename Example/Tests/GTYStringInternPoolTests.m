@@ -0,0 +1,93 @@
+//
+//  GTYStringInternPoolTests.m
+//  Tests
+//
+
+@import XCTest;
+#import <Glotty/GTYCompactTable.h>
+#import <Glotty/GTYStringInternPool.h>
+
+@interface GTYStringInternPoolTests : XCTestCase
+
+@end
+
+@implementation GTYStringInternPoolTests
+
+/**
+ * Strings no other test interns, so the shared pool holds them only for the tables of the test.
+ */
+- (NSDictionary<NSString*, NSString*>*) uniqueStringsWithCount:(NSUInteger)count
+{
+    NSMutableDictionary* strings = [NSMutableDictionary dictionaryWithCapacity:count];
+    for (NSUInteger index = 0; index < count; index++)
+    {
+        strings[[NSUUID UUID].UUIDString] = [NSString stringWithFormat:@"%@ è %lu", [NSUUID UUID].UUIDString, (unsigned long)index];
+    }
+    return strings;
+}
+
+#pragma mark - Reference counting
+
+- (void)testPoolReferenceCounting
+{
+    GTYStringInternPool* pool = [GTYStringInternPool new];
+    const char* bytes = "hellohello";
+    uint32_t hash = GTYInternHash(bytes, 5);
+    GTYInternSpan spans[2] = {{0, 5, hash}, {5, 5, hash}};
+    GTYInternedString* strings[2];
+    NSUInteger addedByteCount = 0;
+    XCTAssertTrue([pool internSpans:spans count:2 inBytes:bytes strings:strings addedByteCount:&addedByteCount]);
+
+    // the same bytes are stored once
+    XCTAssertTrue(strings[0] == strings[1]);
+    XCTAssertEqual(pool.count, (NSUInteger)1);
+    XCTAssertEqual(addedByteCount, sizeof(GTYInternedString) + 5);
+    XCTAssertEqual(pool.byteCount, addedByteCount);
+    XCTAssertEqualObjects(GTYInternedStringObject(strings[0]), @"hello");
+
+    // one of the two references does not free the string
+    XCTAssertEqual([pool byteCountOfStrings:strings count:1 exclusive:YES], (NSUInteger)0);
+    XCTAssertEqual([pool byteCountOfStrings:strings count:1 exclusive:NO], addedByteCount);
+    XCTAssertEqual([pool byteCountOfStrings:strings count:2 exclusive:YES], addedByteCount);
+
+    [pool releaseStrings:strings count:1];
+    XCTAssertEqual(pool.count, (NSUInteger)1);
+    [pool releaseStrings:strings + 1 count:1];
+    XCTAssertEqual(pool.count, (NSUInteger)0);
+    XCTAssertEqual(pool.byteCount, (NSUInteger)0);
+}
+
+- (void)testTablesShareStringsAcrossRelease
+{
+    NSDictionary* strings = [self uniqueStringsWithCount:20];
+    GTYCompactTable* first = nil;
+    GTYCompactTable* second = nil;
+    NSUInteger internedByteCount = 0;
+    @autoreleasepool
+    {
+        first = [GTYCompactTable tableWithStrings:strings];
+        second = [GTYCompactTable tableWithStrings:strings];
+        internedByteCount = first.internedByteCount;
+    }
+    XCTAssertGreaterThan(internedByteCount, (NSUInteger)0);
+    // the second table adds nothing to the pool
+    XCTAssertEqual(second.internedByteCount, (NSUInteger)0);
+    XCTAssertEqual([GTYCompactTable internedByteCountOfTables:@[first] exclusive:NO], internedByteCount);
+    XCTAssertEqual([GTYCompactTable internedByteCountOfTables:@[first] exclusive:YES], (NSUInteger)0);
+    XCTAssertEqual([GTYCompactTable internedByteCountOfTables:@[first, second] exclusive:YES], internedByteCount);
+
+    // releasing the first table keeps the strings of the second one
+    first = nil;
+    XCTAssertTrue([second isEqualToDictionary:strings]);
+    XCTAssertEqual([GTYCompactTable internedByteCountOfTables:@[second] exclusive:YES], internedByteCount);
+
+    // once both are released the strings leave the pool
+    second = nil;
+    @autoreleasepool
+    {
+        GTYCompactTable* third = [GTYCompactTable tableWithStrings:strings];
+        XCTAssertEqual(third.internedByteCount, internedByteCount);
+    }
+}
+
+@end
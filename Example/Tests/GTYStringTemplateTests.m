@@ -0,0 +1,64 @@
+//
+//  GTYStringTemplateTests.m
+//  Tests
+//
+
+@import XCTest;
+#import <Glotty/GTYStringTemplate.h>
+
+@interface GTYStringTemplateTests : XCTestCase
+
+@end
+
+@implementation GTYStringTemplateTests
+
+- (NSString*) render:(NSString*)string placeholderDictionary:(NSDictionary<NSString*, NSString*>*)placeholderDictionary
+{
+    GTYStringTemplate* template = [[GTYStringTemplate alloc] initWithString:string placeholders:placeholderDictionary.allKeys];
+    return [template stringWithPlaceholderDictionary:placeholderDictionary];
+}
+
+#pragma mark - Rendering
+
+- (void)testRendering
+{
+    XCTAssertEqualObjects([self render:@"Hello {name}, you have {count} messages" placeholderDictionary:@{@"{name}": @"Anna", @"{count}": @"3"}], @"Hello Anna, you have 3 messages");
+    XCTAssertEqualObjects([self render:@"{name}{name}" placeholderDictionary:@{@"{name}": @"ab"}], @"abab");
+    XCTAssertEqualObjects([self render:@"{name}" placeholderDictionary:@{@"{name}": @""}], @"");
+    XCTAssertEqualObjects([self render:@"No placeholders" placeholderDictionary:@{@"{name}": @"Anna"}], @"No placeholders");
+    XCTAssertEqualObjects([self render:@"" placeholderDictionary:@{@"{name}": @"Anna"}], @"");
+    XCTAssertEqualObjects([self render:@"Ciao {name} \U0001F600" placeholderDictionary:@{@"{name}": @"値"}], @"Ciao 値 \U0001F600");
+}
+
+- (void)testLongestPlaceholderWins
+{
+    // the result does not depend on the order of the placeholders
+    NSDictionary* placeholders = @{@"%n": @"short", @"%name": @"long"};
+    XCTAssertEqualObjects([self render:@"%name %n" placeholderDictionary:placeholders], @"long short");
+    GTYStringTemplate* reversed = [[GTYStringTemplate alloc] initWithString:@"%name %n" placeholders:@[@"%name", @"%n"]];
+    XCTAssertEqualObjects([reversed stringWithPlaceholderDictionary:placeholders], @"long short");
+}
+
+- (void)testValuesAreNotSearchedForPlaceholders
+{
+    XCTAssertEqualObjects([self render:@"{a} {b}" placeholderDictionary:@{@"{a}": @"{b}", @"{b}": @"{a}"}], @"{b} {a}");
+}
+
+- (void)testTemplatesAreReusable
+{
+    GTYStringTemplate* template = [[GTYStringTemplate alloc] initWithString:@"Hello {name}" placeholders:@[@"{name}"]];
+    XCTAssertEqualObjects([template stringWithPlaceholderDictionary:@{@"{name}": @"Anna"}], @"Hello Anna");
+    XCTAssertEqualObjects([template stringWithPlaceholderDictionary:@{@"{name}": @"Bob"}], @"Hello Bob");
+    // placeholders missing from the dictionary are removed
+    XCTAssertEqualObjects([template stringWithPlaceholderDictionary:@{}], @"Hello ");
+}
+
+- (void)testPlaceholdersOfDictionary
+{
+    GTYStringTemplate* template = [[GTYStringTemplate alloc] initWithString:@"{a} {b}" placeholders:@[@"{a}", @"{b}"]];
+    XCTAssertTrue([template hasPlaceholdersOfDictionary:@{@"{b}": @"2", @"{a}": @"1"}]);
+    XCTAssertFalse([template hasPlaceholdersOfDictionary:@{@"{a}": @"1"}]);
+    XCTAssertFalse([template hasPlaceholdersOfDictionary:@{@"{a}": @"1", @"{c}": @"3"}]);
+}
+
+@end
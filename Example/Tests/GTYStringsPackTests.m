@@ -0,0 +1,177 @@
+//
+//  GTYStringsPackTests.m
+//  Tests
+//
+
+@import XCTest;
+#import <Glotty/GTYStringsPack.h>
+
+@interface GTYStringsPackTests : XCTestCase
+
+@end
+
+@implementation GTYStringsPackTests
+
+/**
+ * Builds a pack by hand with the given header version, 24 bytes for version 1 and 28 for version 2, and the given entries already sorted by key bytes.
+ */
+- (NSMutableData*) packDataWithVersion:(uint16_t)version keys:(NSArray<NSString*>*)keys values:(NSArray<NSString*>*)values
+{
+    uint32_t headerLength = version >= 2 ? 28 : 24;
+    NSMutableData* blob = [NSMutableData data];
+    NSMutableData* index = [NSMutableData data];
+    for (NSUInteger position = 0; position < keys.count; position++)
+    {
+        NSData* keyData = [keys[position] dataUsingEncoding:NSUTF8StringEncoding];
+        NSData* valueData = [values[position] dataUsingEncoding:NSUTF8StringEncoding];
+        uint32_t entry[4] = {(uint32_t)blob.length, (uint32_t)keyData.length, (uint32_t)(blob.length + keyData.length), (uint32_t)valueData.length};
+        [blob appendData:keyData];
+        [blob appendData:valueData];
+        [index appendBytes:entry length:sizeof(entry)];
+    }
+
+    uint16_t versionAndFlags[2] = {version, 0};
+    uint32_t fields[5] = {(uint32_t)keys.count, headerLength, (uint32_t)(headerLength + index.length), (uint32_t)blob.length, 0};
+    NSMutableData* data = [NSMutableData dataWithBytes:"GTYP" length:4];
+    [data appendBytes:versionAndFlags length:sizeof(versionAndFlags)];
+    [data appendBytes:fields length:headerLength - 8];
+    [data appendData:index];
+    [data appendData:blob];
+    return data;
+}
+
+- (NSString*) temporaryPathWithName:(NSString*)name
+{
+    NSString* directory = [NSTemporaryDirectory() stringByAppendingPathComponent:[NSUUID UUID].UUIDString];
+    [[NSFileManager defaultManager] createDirectoryAtPath:directory withIntermediateDirectories:YES attributes:nil error:NULL];
+    [self addTeardownBlock:^{
+        [[NSFileManager defaultManager] removeItemAtPath:directory error:NULL];
+    }];
+    return [directory stringByAppendingPathComponent:name];
+}
+
+#pragma mark - Reading
+
+- (void)testRoundTrip
+{
+    NSDictionary* strings = @{@"b": @"2", @"a": @"1", @"ab": @"12", @"unicode ü": @"値 \U0001F600", @"empty": @""};
+    GTYStringsPack* pack = [[GTYStringsPack alloc] initWithData:[GTYStringsPack dataWithStrings:strings]];
+    XCTAssertNotNil(pack);
+    XCTAssertEqual(pack.count, strings.count);
+    XCTAssertEqual(pack.flags, (uint16_t)0);
+    for (NSString* key in strings)
+    {
+        XCTAssertEqualObjects([pack stringForKey:key], strings[key]);
+        XCTAssertTrue([pack containsStringForKey:key]);
+    }
+    XCTAssertNil([pack stringForKey:@"missing"]);
+    XCTAssertNil([pack stringForKey:@""]);
+    XCTAssertFalse([pack containsStringForKeyBytes:"aa" length:2]);
+    XCTAssertTrue([pack containsStringForKeyBytes:"ab" length:2]);
+
+    // keys are sorted by UTF-8 bytes, shorter keys first
+    NSArray* keys = @[@"a", @"ab", @"b", @"empty", @"unicode ü"];
+    XCTAssertEqualObjects([pack allKeysWithStrings], keys);
+    XCTAssertEqualObjects([pack keyAtIndex:1], @"ab");
+    XCTAssertNil([pack keyAtIndex:keys.count]);
+
+    NSMutableDictionary* enumerated = [NSMutableDictionary dictionary];
+    [pack enumerateKeysAndStringsUsingBlock:^(NSString* key, NSString* string, BOOL* stop) {
+        enumerated[key] = string;
+    }];
+    XCTAssertEqualObjects(enumerated, strings);
+}
+
+- (void)testMappedFile
+{
+    NSString* path = [self temporaryPathWithName:@"Localizable.strpack"];
+    XCTAssertTrue([GTYStringsPack writeStrings:@{@"title": @"Titolo"} toFile:path]);
+
+    GTYStringsPack* pack = [GTYStringsPack packWithContentsOfFile:path];
+    XCTAssertEqualObjects([pack stringForKey:@"title"], @"Titolo");
+    NSDictionary* attributes = [[NSFileManager defaultManager] attributesOfItemAtPath:path error:NULL];
+    XCTAssertEqual(pack.byteSize, (NSUInteger)attributes.fileSize);
+
+    XCTAssertNil([GTYStringsPack packWithContentsOfFile:[path stringByAppendingString:@".missing"]]);
+    XCTAssertNil([GTYStringsPack packWithContentsOfFile:@""]);
+}
+
+- (void)testVersion1Pack
+{
+    NSData* data = [self packDataWithVersion:1 keys:@[@"a", @"b"] values:@[@"uno", @"due"]];
+    XCTAssertEqual(data.length, (NSUInteger)(24 + 2 * 16 + 8));
+
+    GTYStringsPack* pack = [[GTYStringsPack alloc] initWithData:data];
+    XCTAssertNotNil(pack);
+    XCTAssertEqual(pack.count, (NSUInteger)2);
+    XCTAssertEqual(pack.keySetHash, (uint32_t)0);
+    XCTAssertEqualObjects([pack stringForKey:@"a"], @"uno");
+    XCTAssertEqualObjects([pack stringForKey:@"b"], @"due");
+}
+
+- (void)testVersion2Pack
+{
+    NSData* data = [self packDataWithVersion:2 keys:@[@"a", @"b"] values:@[@"uno", @"due"]];
+    GTYStringsPack* pack = [[GTYStringsPack alloc] initWithData:data];
+    XCTAssertEqual(pack.count, (NSUInteger)2);
+    XCTAssertEqualObjects([pack stringForKey:@"b"], @"due");
+
+    // the pack compiled from the same strings has the same layout, plus the hash of its keys
+    GTYStringsPack* compiled = [[GTYStringsPack alloc] initWithData:[GTYStringsPack dataWithStrings:@{@"a": @"uno", @"b": @"due"}]];
+    XCTAssertEqual(compiled.byteSize, data.length);
+    XCTAssertNotEqual(compiled.keySetHash, (uint32_t)0);
+}
+
+#pragma mark - Validation
+
+- (void)testInvalidHeaders
+{
+    NSData* valid = [self packDataWithVersion:2 keys:@[@"a"] values:@[@"1"]];
+    XCTAssertNotNil([[GTYStringsPack alloc] initWithData:valid]);
+
+    XCTAssertNil([[GTYStringsPack alloc] initWithData:[NSData data]]);
+    XCTAssertNil([[GTYStringsPack alloc] initWithData:[valid subdataWithRange:NSMakeRange(0, 20)]]);
+    // a version 2 header cut to the length of a version 1 header
+    NSMutableData* header = [[valid subdataWithRange:NSMakeRange(0, 24)] mutableCopy];
+    uint32_t noEntries[3] = {0, 24, 24};
+    [header replaceBytesInRange:NSMakeRange(8, sizeof(noEntries)) withBytes:noEntries];
+    XCTAssertNil([[GTYStringsPack alloc] initWithData:header]);
+
+    NSMutableData* magic = [valid mutableCopy];
+    [magic replaceBytesInRange:NSMakeRange(0, 4) withBytes:"GTYX"];
+    XCTAssertNil([[GTYStringsPack alloc] initWithData:magic]);
+
+    NSMutableData* version = [valid mutableCopy];
+    uint16_t futureVersion = 3;
+    [version replaceBytesInRange:NSMakeRange(4, sizeof(futureVersion)) withBytes:&futureVersion];
+    XCTAssertNil([[GTYStringsPack alloc] initWithData:version]);
+
+    NSMutableData* count = [valid mutableCopy];
+    uint32_t tooManyEntries = 1000;
+    [count replaceBytesInRange:NSMakeRange(8, sizeof(tooManyEntries)) withBytes:&tooManyEntries];
+    XCTAssertNil([[GTYStringsPack alloc] initWithData:count]);
+
+    NSMutableData* blob = [valid mutableCopy];
+    uint32_t blobLength = (uint32_t)valid.length;
+    [blob replaceBytesInRange:NSMakeRange(20, sizeof(blobLength)) withBytes:&blobLength];
+    XCTAssertNil([[GTYStringsPack alloc] initWithData:blob]);
+
+    XCTAssertNil([[GTYStringsPack alloc] initWithData:[valid subdataWithRange:NSMakeRange(0, valid.length - 1)]]);
+}
+
+- (void)testEntriesOutsideTheBlob
+{
+    NSMutableData* data = [self packDataWithVersion:2 keys:@[@"a", @"b"] values:@[@"1", @"2"]];
+    // the value of "b" points past the end of the blob
+    uint32_t valueOffset = 100;
+    [data replaceBytesInRange:NSMakeRange(28 + 16 + 8, sizeof(valueOffset)) withBytes:&valueOffset];
+
+    GTYStringsPack* pack = [[GTYStringsPack alloc] initWithData:data];
+    XCTAssertNotNil(pack);
+    XCTAssertEqualObjects([pack stringForKey:@"a"], @"1");
+    XCTAssertNil([pack stringForKey:@"b"]);
+    XCTAssertFalse([pack containsStringForKey:@"b"]);
+    XCTAssertEqualObjects([pack allKeysWithStrings], @[@"a"]);
+}
+
+@end
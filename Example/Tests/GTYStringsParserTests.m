@@ -0,0 +1,197 @@
+//
+//  GTYStringsParserTests.m
+//  Tests
+//
+
+@import XCTest;
+#import <Glotty/GTYStringsParser.h>
+#import <Glotty/GTYCompactTable.h>
+
+@interface GTYStringsParserTests : XCTestCase
+
+@end
+
+@implementation GTYStringsParserTests
+
+- (NSDictionary<NSString*, NSString*>*) stringsWithText:(NSString*)text error:(NSError**)error
+{
+    return [GTYStringsParser stringsWithData:[text dataUsingEncoding:NSUTF8StringEncoding] error:error];
+}
+
+#pragma mark - Text
+
+- (void)testEscapes
+{
+    NSString* text = @"\"quotes\" = \"say \\\"hi\\\" \\\\ done\";\n"
+                     @"\"controls\" = \"a\\nb\\tc\\rd\";\n"
+                     @"\"unicode\" = \"\\U00e8\\u00C9\";\n"
+                     @"\"pair\" = \"\\UD83D\\UDE00\";\n"
+                     @"\"lonely\" = \"\\UDE00\";\n"
+                     @"\"octal\" = \"\\101\\60\";\n"
+                     @"\"other\" = \"\\'\\q\";\n";
+    NSError* error = nil;
+    NSDictionary* strings = [self stringsWithText:text error:&error];
+    XCTAssertNil(error);
+    XCTAssertEqualObjects(strings[@"quotes"], @"say \"hi\" \\ done");
+    XCTAssertEqualObjects(strings[@"controls"], @"a\nb\tc\rd");
+    XCTAssertEqualObjects(strings[@"unicode"], @"\u00e8\u00c9");
+    XCTAssertEqualObjects(strings[@"pair"], @"\U0001F600");
+    XCTAssertEqualObjects(strings[@"lonely"], @"\uFFFD");
+    XCTAssertEqualObjects(strings[@"octal"], @"A0");
+    XCTAssertEqualObjects(strings[@"other"], @"'q");
+}
+
+- (void)testEmbeddedNul
+{
+    NSDictionary* strings = [self stringsWithText:@"\"a\\0b\" = \"x\\0y\";\n\"a\" = \"plain\";" error:NULL];
+    NSString* key = [NSString stringWithFormat:@"a%Cb", (unichar)0];
+    XCTAssertEqual(strings.count, (NSUInteger)2);
+    XCTAssertEqualObjects(strings[key], ([NSString stringWithFormat:@"x%Cy", (unichar)0]));
+    XCTAssertEqualObjects(strings[@"a"], @"plain");
+}
+
+- (void)testCommentsAndUnquotedTokens
+{
+    NSString* text = @"/* header\n   comment */\n"
+                     @"\"a\" = \"1\"; // trailing comment\n"
+                     @"\"b\" /* inner */ = /* inner */ \"2\";\n"
+                     @"unquoted = token;\n"
+                     @"\"single\";\n"
+                     @"\"slashes\" = \"// not a comment /* either */\";\n";
+    NSDictionary* strings = [self stringsWithText:text error:NULL];
+    NSDictionary* expected = @{@"a": @"1", @"b": @"2", @"unquoted": @"token", @"single": @"single", @"slashes": @"// not a comment /* either */"};
+    XCTAssertEqualObjects(strings, expected);
+}
+
+- (void)testBracesAndEmptyTable
+{
+    XCTAssertEqualObjects([self stringsWithText:@"{\n  \"a\" = \"1\";\n}\n" error:NULL], @{@"a": @"1"});
+    XCTAssertEqualObjects([self stringsWithText:@"" error:NULL], @{});
+    XCTAssertEqualObjects([self stringsWithText:@"  /* only a comment */  " error:NULL], @{});
+}
+
+- (void)testUTF8ByteOrderMark
+{
+    NSMutableData* data = [NSMutableData dataWithBytes:"\xEF\xBB\xBF" length:3];
+    [data appendData:[@"\"k\" = \"v\u00e8\";" dataUsingEncoding:NSUTF8StringEncoding]];
+    XCTAssertEqualObjects([GTYStringsParser stringsWithData:data error:NULL], @{@"k": @"v\u00e8"});
+}
+
+- (void)testUTF16
+{
+    NSString* text = @"/* comment */\n\"chiave\" = \"\u5024 \U0001F600\";\n";
+    NSDictionary* expected = @{@"chiave": @"\u5024 \U0001F600"};
+
+    NSMutableData* littleEndian = [NSMutableData dataWithBytes:"\xFF\xFE" length:2];
+    [littleEndian appendData:[text dataUsingEncoding:NSUTF16LittleEndianStringEncoding]];
+    XCTAssertEqualObjects([GTYStringsParser stringsWithData:littleEndian error:NULL], expected);
+
+    NSMutableData* bigEndian = [NSMutableData dataWithBytes:"\xFE\xFF" length:2];
+    [bigEndian appendData:[text dataUsingEncoding:NSUTF16BigEndianStringEncoding]];
+    XCTAssertEqualObjects([GTYStringsParser stringsWithData:bigEndian error:NULL], expected);
+
+    // without a byte order mark, the zero bytes of ASCII characters tell the byte order
+    NSData* noMark = [text dataUsingEncoding:NSUTF16LittleEndianStringEncoding];
+    XCTAssertEqualObjects([GTYStringsParser stringsWithData:noMark error:NULL], expected);
+
+    GTYCompactTable* table = [GTYStringsParser compactTableWithData:littleEndian error:NULL];
+    XCTAssertEqualObjects(table[@"chiave"], expected[@"chiave"]);
+}
+
+- (void)testOddLengthUTF16
+{
+    NSMutableData* data = [NSMutableData dataWithBytes:"\xFF\xFE" length:2];
+    [data appendData:[@"\"a\" = \"1\";" dataUsingEncoding:NSUTF16LittleEndianStringEncoding]];
+    [data appendBytes:"\x00" length:1];
+    NSError* error = nil;
+    XCTAssertNil([GTYStringsParser stringsWithData:data error:&error]);
+    XCTAssertEqual(error.code, GTYStringsParserErrorInvalidEncoding);
+}
+
+#pragma mark - Binary property lists
+
+- (void)testBinaryPropertyList
+{
+    NSDictionary* expected = @{@"ascii": @"value", @"unicode \u00fc": @"\u5024 \U0001F600", @"empty": @""};
+    NSData* data = [NSPropertyListSerialization dataWithPropertyList:expected format:NSPropertyListBinaryFormat_v1_0 options:0 error:NULL];
+    XCTAssertNotNil(data);
+
+    NSError* error = nil;
+    XCTAssertEqualObjects([GTYStringsParser stringsWithData:data error:&error], expected);
+    XCTAssertNil(error);
+
+    GTYCompactTable* table = [GTYStringsParser compactTableWithData:data error:NULL];
+    XCTAssertEqual(table.count, expected.count);
+    for (NSString* key in expected)
+    {
+        XCTAssertEqualObjects(table[key], expected[key]);
+    }
+}
+
+- (void)testInvalidBinaryPropertyList
+{
+    NSMutableData* data = [NSMutableData dataWithBytes:"bplist00" length:8];
+    [data appendBytes:"\x01\x02\x03\x04" length:4];
+    NSError* error = nil;
+    XCTAssertNil([GTYStringsParser stringsWithData:data error:&error]);
+    XCTAssertEqualObjects(error.domain, GTYStringsParserErrorDomain);
+    XCTAssertEqual(error.code, GTYStringsParserErrorInvalidBinaryPropertyList);
+
+    // a valid property list whose values are not strings
+    NSData* numbers = [NSPropertyListSerialization dataWithPropertyList:@{@"a": @1} format:NSPropertyListBinaryFormat_v1_0 options:0 error:NULL];
+    XCTAssertNil([GTYStringsParser stringsWithData:numbers error:&error]);
+    XCTAssertEqual(error.code, GTYStringsParserErrorInvalidBinaryPropertyList);
+}
+
+#pragma mark - Malformed tables
+
+- (void)testMissingSemicolonReportsLine
+{
+    NSError* error = nil;
+    XCTAssertNil([self stringsWithText:@"\"a\" = \"1\";\n\"b\" = \"2\"\n\"c\" = \"3\";\n" error:&error]);
+    XCTAssertEqualObjects(error.domain, GTYStringsParserErrorDomain);
+    XCTAssertEqual(error.code, GTYStringsParserErrorUnexpectedCharacter);
+    XCTAssertEqualObjects(error.userInfo[GTYStringsParserLineErrorKey], @3);
+}
+
+- (void)testUnterminatedTokens
+{
+    NSError* error = nil;
+    XCTAssertNil([self stringsWithText:@"\"a\" = \"1\";\n/* never closed" error:&error]);
+    XCTAssertEqual(error.code, GTYStringsParserErrorUnterminatedComment);
+    XCTAssertEqualObjects(error.userInfo[GTYStringsParserLineErrorKey], @2);
+
+    XCTAssertNil([self stringsWithText:@"\"a\" = \"1" error:&error]);
+    XCTAssertEqual(error.code, GTYStringsParserErrorUnterminatedString);
+
+    XCTAssertNil([self stringsWithText:@"\"a\" = \"\\Uzz\";" error:&error]);
+    XCTAssertEqual(error.code, GTYStringsParserErrorInvalidEscape);
+
+    XCTAssertNil([self stringsWithText:@"{ \"a\" = \"1\";" error:&error]);
+    XCTAssertEqual(error.code, GTYStringsParserErrorUnexpectedCharacter);
+}
+
+- (void)testInvalidUTF8
+{
+    NSData* data = [NSData dataWithBytes:"\"a\" = \"\xC3\x28\";" length:11];
+    NSError* error = nil;
+    XCTAssertNil([GTYStringsParser stringsWithData:data error:&error]);
+    XCTAssertEqual(error.code, GTYStringsParserErrorInvalidEncoding);
+}
+
+- (void)testXMLPropertyListIsUnsupported
+{
+    NSData* data = [NSPropertyListSerialization dataWithPropertyList:@{@"a": @"1"} format:NSPropertyListXMLFormat_v1_0 options:0 error:NULL];
+    NSError* error = nil;
+    XCTAssertNil([GTYStringsParser stringsWithData:data error:&error]);
+    XCTAssertEqual(error.code, GTYStringsParserErrorUnsupportedFormat);
+}
+
+- (void)testUnreadableFile
+{
+    NSError* error = nil;
+    XCTAssertNil([GTYStringsParser stringsWithContentsOfFile:@"/nonexistent/Localizable.strings" error:&error]);
+    XCTAssertEqual(error.code, GTYStringsParserErrorUnreadableFile);
+}
+
+@end
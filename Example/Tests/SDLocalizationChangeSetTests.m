@@ -0,0 +1,83 @@
+//
+//  SDLocalizationChangeSetTests.m
+//  Tests
+//
+
+@import XCTest;
+#import <Glotty/SDLocalizationChangeSet.h>
+
+@interface SDLocalizationChangeSetTests : XCTestCase
+
+@end
+
+@implementation SDLocalizationChangeSetTests
+
+- (void)testLanguageChangeSetContainsEverything
+{
+    SDLocalizationChangeSet* changeSet = [SDLocalizationChangeSet languageChangeSet];
+    XCTAssertEqual(changeSet.kinds, SDLocalizationChangeKindLanguage);
+    XCTAssertNil(changeSet.tableNames);
+    XCTAssertNil(changeSet.localizations);
+    XCTAssertTrue([changeSet containsTableWithName:@"Localizable"]);
+    XCTAssertTrue([changeSet containsKey:@"title" inTableWithName:@"Localizable"]);
+    XCTAssertNil([changeSet keysOfTableWithName:@"Localizable"]);
+}
+
+- (void)testKnownKeys
+{
+    SDLocalizationChangeSet* changeSet = [[SDLocalizationChangeSet alloc] initWithKinds:SDLocalizationChangeKindStringsAdded tableNames:[NSSet setWithObject:@"Localizable"] localizations:[NSSet setWithObject:@"it"] keys:[NSSet setWithObjects:@"title", @"subtitle", nil]];
+    XCTAssertTrue([changeSet containsTableWithName:@"Localizable"]);
+    XCTAssertFalse([changeSet containsTableWithName:@"Other"]);
+    XCTAssertTrue([changeSet containsKey:@"title" inTableWithName:@"Localizable"]);
+    XCTAssertFalse([changeSet containsKey:@"footer" inTableWithName:@"Localizable"]);
+    XCTAssertFalse([changeSet containsKey:@"title" inTableWithName:@"Other"]);
+    XCTAssertEqualObjects([changeSet keysOfTableWithName:@"Localizable"], ([NSSet setWithObjects:@"title", @"subtitle", nil]));
+    // a table that did not change has no changed keys
+    XCTAssertEqualObjects([changeSet keysOfTableWithName:@"Other"], [NSSet set]);
+}
+
+- (void)testUnknownKeys
+{
+    SDLocalizationChangeSet* changeSet = [[SDLocalizationChangeSet alloc] initWithKinds:SDLocalizationChangeKindStringsReset tableNames:[NSSet setWithObject:@"Localizable"] localizations:nil keys:nil];
+    XCTAssertNil([changeSet keysOfTableWithName:@"Localizable"]);
+    XCTAssertTrue([changeSet containsKey:@"anything" inTableWithName:@"Localizable"]);
+    XCTAssertFalse([changeSet containsKey:@"anything" inTableWithName:@"Other"]);
+}
+
+- (void)testMergingKnownKeys
+{
+    SDLocalizationChangeSet* first = [[SDLocalizationChangeSet alloc] initWithKinds:SDLocalizationChangeKindStringsAdded tableNames:[NSSet setWithObject:@"A"] localizations:[NSSet setWithObject:@"it"] keys:[NSSet setWithObject:@"one"]];
+    SDLocalizationChangeSet* second = [[SDLocalizationChangeSet alloc] initWithKinds:SDLocalizationChangeKindStringsReset tableNames:[NSSet setWithObjects:@"A", @"B", nil] localizations:[NSSet setWithObject:@"en"] keys:[NSSet setWithObject:@"two"]];
+    SDLocalizationChangeSet* merged = [first changeSetByMergingChangeSet:second];
+
+    XCTAssertEqual(merged.kinds, SDLocalizationChangeKindStringsAdded | SDLocalizationChangeKindStringsReset);
+    XCTAssertEqualObjects(merged.tableNames, ([NSSet setWithObjects:@"A", @"B", nil]));
+    XCTAssertEqualObjects(merged.localizations, ([NSSet setWithObjects:@"it", @"en", nil]));
+    XCTAssertEqualObjects([merged keysOfTableWithName:@"A"], ([NSSet setWithObjects:@"one", @"two", nil]));
+    XCTAssertEqualObjects([merged keysOfTableWithName:@"B"], [NSSet setWithObject:@"two"]);
+    XCTAssertFalse([merged containsTableWithName:@"C"]);
+
+    XCTAssertTrue([first changeSetByMergingChangeSet:nil] == first);
+}
+
+- (void)testMergingUnknownParts
+{
+    SDLocalizationChangeSet* known = [[SDLocalizationChangeSet alloc] initWithKinds:SDLocalizationChangeKindStringsAdded tableNames:[NSSet setWithObject:@"A"] localizations:[NSSet setWithObject:@"it"] keys:[NSSet setWithObject:@"one"]];
+    SDLocalizationChangeSet* reset = [[SDLocalizationChangeSet alloc] initWithKinds:SDLocalizationChangeKindStringsReset tableNames:[NSSet setWithObject:@"A"] localizations:nil keys:nil];
+
+    // the keys of a table stay known only if both change sets know them
+    SDLocalizationChangeSet* merged = [known changeSetByMergingChangeSet:reset];
+    XCTAssertNil([merged keysOfTableWithName:@"A"]);
+    XCTAssertTrue([merged containsKey:@"other" inTableWithName:@"A"]);
+    XCTAssertNil(merged.localizations);
+
+    // a change of all the tables absorbs the others
+    SDLocalizationChangeSet* language = [known changeSetByMergingChangeSet:[SDLocalizationChangeSet languageChangeSet]];
+    XCTAssertEqual(language.kinds, SDLocalizationChangeKindLanguage | SDLocalizationChangeKindStringsAdded);
+    XCTAssertNil(language.tableNames);
+    XCTAssertNil(language.localizations);
+    XCTAssertNil([language keysOfTableWithName:@"A"]);
+    XCTAssertTrue([language containsKey:@"other" inTableWithName:@"B"]);
+}
+
+@end
@@ -0,0 +1,164 @@
+//
+//  SDLocalizationDataSourceTests.m
+//  Tests
+//
+
+@import XCTest;
+#import <Glotty/SDLocalizationManagerModels.h>
+#import <Glotty/GTYStringsPack.h>
+
+#define kBundleIdentifier   @"com.sysdata.glotty.tests"
+
+@interface SDLocalizationDataSourceTests : XCTestCase
+
+@end
+
+@implementation SDLocalizationDataSourceTests
+
+- (SDResolvedTable*) resolvedTableWithName:(NSString*)name strings:(NSDictionary<NSString*, NSString*>*)strings
+{
+    SDResolvedTable* table = [SDResolvedTable new];
+    table.name = name;
+    table.bundleIdentifier = kBundleIdentifier;
+    table.content = strings;
+    return table;
+}
+
+#pragma mark - Snapshots
+
+- (void)testTiersAreDistinct
+{
+    SDLocalizationDataSource* dataSource = [[SDLocalizationDataSource alloc] initWithLanguageIDs:@[@"it-IT", @"it", @"", @"en", @"it"] reusingLocalesOfDataSource:nil];
+    XCTAssertEqualObjects([dataSource.tiers valueForKey:@"languageID"], (@[@"it-IT", @"it", @"en"]));
+}
+
+- (void)testReadersKeepTheirSnapshot
+{
+    SDLocalizationDataSource* dataSource = [[SDLocalizationDataSource alloc] initWithLanguageIDs:@[@"it", @"en"] reusingLocalesOfDataSource:nil];
+    SDResolvedTable* menu = [self resolvedTableWithName:@"Menu" strings:@{@"title": @"Menu"}];
+    [dataSource addResolvedTable:menu];
+    NSDictionary* snapshot = dataSource.resolvedTablesByBundleId;
+
+    [dataSource addResolvedTable:[self resolvedTableWithName:@"Other" strings:@{@"title": @"Other"}]];
+    [dataSource invalidateTableWithName:@"Menu" forLocalization:@"it"];
+
+    // the snapshot read before the changes is never mutated
+    XCTAssertEqualObjects([snapshot[kBundleIdentifier] allKeys], @[@"Menu"]);
+    XCTAssertTrue(snapshot[kBundleIdentifier][@"Menu"] == menu);
+    XCTAssertNil([dataSource resolvedTableWithName:@"Menu" bundleIdentifier:kBundleIdentifier]);
+    XCTAssertNotNil([dataSource resolvedTableWithName:@"Other" bundleIdentifier:kBundleIdentifier]);
+    XCTAssertFalse(dataSource.resolvedTablesByBundleId == snapshot);
+}
+
+- (void)testGenerationChangesWithInvalidations
+{
+    SDLocalizationDataSource* dataSource = [[SDLocalizationDataSource alloc] initWithLanguageIDs:@[@"it", @"en"] reusingLocalesOfDataSource:nil];
+    NSUInteger generation = dataSource.generation;
+
+    // tables loaded meanwhile are recognized as stale
+    [dataSource invalidateTableWithName:@"Menu" forLocalization:@"en"];
+    XCTAssertNotEqual(dataSource.generation, generation);
+
+    // nothing depends on a localization that is not a tier
+    generation = dataSource.generation;
+    [dataSource invalidateTableWithName:@"Menu" forLocalization:@"de"];
+    XCTAssertEqual(dataSource.generation, generation);
+
+    // a data source sharing the locale sees its invalidations
+    SDLocalizationDataSource* sharingDataSource = [[SDLocalizationDataSource alloc] initWithLanguageIDs:@[@"de", @"en"] reusingLocalesOfDataSource:dataSource];
+    XCTAssertTrue(sharingDataSource.tiers[1] == dataSource.tiers[1]);
+    generation = sharingDataSource.generation;
+    [dataSource invalidateTableWithName:@"Menu" forLocalization:@"en"];
+    XCTAssertNotEqual(sharingDataSource.generation, generation);
+}
+
+#pragma mark - Invalidation
+
+- (void)testInvalidationKeepsTheOtherTables
+{
+    SDLocalizationDataSource* dataSource = [[SDLocalizationDataSource alloc] initWithLanguageIDs:@[@"it", @"en"] reusingLocalesOfDataSource:nil];
+    SDResolvedTable* menu = [self resolvedTableWithName:@"Menu" strings:@{@"title": @"Menu"}];
+    SDResolvedTable* other = [self resolvedTableWithName:@"Other" strings:@{@"title": @"Other"}];
+    SDResolvedTable* settings = [self resolvedTableWithName:@"Settings" strings:@{@"title": @"Impostazioni"}];
+    [dataSource addResolvedTable:menu];
+    [dataSource addResolvedTable:other];
+    [dataSource addResolvedTable:settings];
+
+    [dataSource invalidateTableWithName:@"Menu" forLocalization:@"it"];
+    XCTAssertNil([dataSource resolvedTableWithName:@"Menu" bundleIdentifier:kBundleIdentifier]);
+    XCTAssertTrue([dataSource resolvedTableWithName:@"Other" bundleIdentifier:kBundleIdentifier] == other);
+    XCTAssertTrue([dataSource resolvedTableWithName:@"Settings" bundleIdentifier:kBundleIdentifier] == settings);
+
+    // tables of localizations that are not tiers are not merged in any table
+    [dataSource invalidateTablesWithNames:@[@"Other", @"Settings"] forLocalization:@"de"];
+    XCTAssertTrue([dataSource resolvedTableWithName:@"Other" bundleIdentifier:kBundleIdentifier] == other);
+
+    [dataSource invalidateTablesWithNames:@[@"Other", @"Missing"] forLocalization:@"en"];
+    XCTAssertNil([dataSource resolvedTableWithName:@"Other" bundleIdentifier:kBundleIdentifier]);
+    XCTAssertTrue([dataSource resolvedTableWithName:@"Settings" bundleIdentifier:kBundleIdentifier] == settings);
+}
+
+#pragma mark - Eviction
+
+- (void)testEvictionDropsTheLeastRecentlyUsedTables
+{
+    SDLocalizationDataSource* dataSource = [[SDLocalizationDataSource alloc] initWithLanguageIDs:@[@"it", @"en"] reusingLocalesOfDataSource:nil];
+    SDResolvedTable* menu = [self resolvedTableWithName:@"Menu" strings:@{@"title": @"Menu"}];
+    SDResolvedTable* other = [self resolvedTableWithName:@"Other" strings:@{@"title": @"Altro"}];
+    SDResolvedTable* settings = [self resolvedTableWithName:@"Settings" strings:@{@"title": @"Impostazioni"}];
+    menu.lastAccessTick = 3;
+    other.lastAccessTick = 1;
+    settings.lastAccessTick = 2;
+    [dataSource addResolvedTable:menu];
+    [dataSource addResolvedTable:other];
+    [dataSource addResolvedTable:settings];
+
+    NSUInteger tableByteCount = menu.residentByteCount;
+    XCTAssertGreaterThan(tableByteCount, (NSUInteger)0);
+    XCTAssertEqual(dataSource.residentByteCount, 3 * tableByteCount);
+    XCTAssertEqual([dataSource evictTablesToFitByteLimit:3 * tableByteCount sharingTablesWithDataSources:@[]], (NSUInteger)0);
+
+    XCTAssertEqual([dataSource evictTablesToFitByteLimit:2 * tableByteCount sharingTablesWithDataSources:@[]], (NSUInteger)1);
+    XCTAssertNil([dataSource resolvedTableWithName:@"Other" bundleIdentifier:kBundleIdentifier]);
+    XCTAssertEqual(dataSource.residentByteCount, 2 * tableByteCount);
+
+    // the most recently used table is kept even if it exceeds the limit alone
+    XCTAssertEqual([dataSource evictTablesToFitByteLimit:0 sharingTablesWithDataSources:@[]], (NSUInteger)1);
+    XCTAssertNil([dataSource resolvedTableWithName:@"Settings" bundleIdentifier:kBundleIdentifier]);
+    XCTAssertTrue([dataSource resolvedTableWithName:@"Menu" bundleIdentifier:kBundleIdentifier] == menu);
+    XCTAssertEqual(dataSource.residentByteCount, tableByteCount);
+}
+
+- (void)testSharedContentIsNotCounted
+{
+    SDLocalizationDataSource* dataSource = [[SDLocalizationDataSource alloc] initWithLanguageIDs:@[@"it", @"en"] reusingLocalesOfDataSource:nil];
+    SDResolvedTable* menu = [self resolvedTableWithName:@"Menu" strings:@{@"title": @"Menu", @"subtitle": @"Sottotitolo"}];
+    menu.sharesContent = YES;
+    [dataSource addResolvedTable:menu];
+
+    XCTAssertEqual(menu.residentByteCount, (NSUInteger)0);
+    XCTAssertEqual(dataSource.residentByteCount, (NSUInteger)0);
+    XCTAssertEqual([dataSource residentByteCountOfTableWithName:@"Menu" bundleIdentifier:kBundleIdentifier], (NSUInteger)0);
+    XCTAssertEqual([dataSource residentByteCountOfTableWithName:@"Missing" bundleIdentifier:kBundleIdentifier], (NSUInteger)0);
+}
+
+#pragma mark - Key IDs
+
+- (void)testKeyIDsIndexTheKeysOfThePack
+{
+    // the IDs are the indexes of the keys sorted by the pack: "a" 0, "b" 1, "c" 2
+    GTYStringsPack* pack = [[GTYStringsPack alloc] initWithData:[GTYStringsPack dataWithStrings:@{@"c": @"3", @"a": @"1", @"b": @"2"}]];
+    SDResolvedTable* table = [self resolvedTableWithName:@"Menu" strings:@{@"a": @"uno", @"c": @"tre", @"d": @"quattro"}];
+    table.keyIDPack = pack;
+
+    // values come from the merged table, so added strings override the pack
+    XCTAssertEqualObjects([table stringForKeyID:0], @"uno");
+    XCTAssertEqualObjects([table stringForKeyID:2], @"tre");
+    XCTAssertNil([table stringForKeyID:1]);
+    XCTAssertNil([table stringForKeyID:3]);
+
+    SDResolvedTable* tableWithoutPack = [self resolvedTableWithName:@"Menu" strings:@{@"a": @"uno"}];
+    XCTAssertNil([tableWithoutPack stringForKeyID:0]);
+}
+
+@end
@@ -0,0 +1,455 @@
+//
+//  SDLocalizationManagerTests.m
+//  Tests
+//
+
+@import XCTest;
+#import <Glotty/SDLocalizationManager.h>
+#import <Glotty/GTYDynamicStringsStore.h>
+#import <Glotty/NSLocale+Glotty.h>
+
+// localized in en.lproj and it.lproj of the test bundle
+#define kTestTable          @"GlottyTests"
+#define kSavedLocaleKey     @"APP_LANGUAGE_SETTING"
+
+@interface SDLocalizationManagerTests : XCTestCase
+@property (nonatomic, strong) id savedLocale;
+@end
+
+@implementation SDLocalizationManagerTests
+
+- (void)setUp
+{
+    [super setUp];
+    self.savedLocale = [[NSUserDefaults standardUserDefaults] objectForKey:kSavedLocaleKey];
+}
+
+- (void)tearDown
+{
+    // the managers of the tests save their selection where the one of the host app does
+    [[NSUserDefaults standardUserDefaults] setObject:self.savedLocale forKey:kSavedLocaleKey];
+    [super tearDown];
+}
+
+/**
+ * Returns a manager supporting en (the default locale), it and de, that keeps the strings added by the test in a temporary directory and posts notifications synchronously.
+ */
+- (SDLocalizationManager*) managerWithSelectedLocale:(NSString*)identifier
+{
+    SDLocalizationManager* manager = [SDLocalizationManager new];
+    NSString* directory = [NSTemporaryDirectory() stringByAppendingPathComponent:[NSUUID UUID].UUIDString];
+    [[NSFileManager defaultManager] createDirectoryAtPath:directory withIntermediateDirectories:YES attributes:nil error:NULL];
+    [manager setValue:directory forKey:@"pathForDynamicStrings"];
+    [manager setValue:[[GTYDynamicStringsStore alloc] initWithDirectoryPath:directory] forKey:@"dynamicStringsStore"];
+    [self addTeardownBlock:^{
+        [manager flushPendingWrites];
+        [[NSFileManager defaultManager] removeItemAtPath:directory error:NULL];
+    }];
+
+    manager.notificationCoalescingInterval = 0;
+    [manager setSupportedLocales:@[@"en", @"it", @"de"]];
+    [manager setSelectedLocaleWithIdentifier:identifier];
+    return manager;
+}
+
+- (NSString*) manager:(SDLocalizationManager*)manager localizedKey:(NSString*)key
+{
+    return [manager localizedKey:key fromTable:kTestTable inBundleForClass:[self class] withDefaultValue:nil];
+}
+
+#pragma mark - Fallback chain
+
+- (void)testSelectedLocaleOverridesTheFallbackChain
+{
+    SDLocalizationManager* manager = [self managerWithSelectedLocale:@"it"];
+    XCTAssertEqualObjects([self manager:manager localizedKey:@"greeting"], @"Ciao");
+    // missing in Italian, found in the default locale
+    XCTAssertEqualObjects([self manager:manager localizedKey:@"fallback.only"], @"Only in English");
+    XCTAssertEqualObjects([self manager:manager localizedKey:@"missing"], @"missing");
+    XCTAssertEqualObjects([manager localizedKey:@"missing" fromTable:kTestTable inBundleForClass:[self class] withDefaultValue:@"default"], @"default");
+
+    // a locale without tables is served entirely by the default one
+    [manager setSelectedLocaleWithIdentifier:@"de"];
+    XCTAssertEqualObjects([self manager:manager localizedKey:@"greeting"], @"Hello");
+}
+
+- (void)testAddedStringsOverrideTheTablesOfTheirLocale
+{
+    SDLocalizationManager* manager = [self managerWithSelectedLocale:@"it"];
+    XCTAssertEqualObjects([self manager:manager localizedKey:@"greeting"], @"Ciao");
+
+    [manager addStrings:@{@"greeting": @"Ciao a tutti"} toTableWithName:kTestTable forLocalization:@"it"];
+    [manager addStrings:@{@"greeting": @"Hello everyone", @"fallback.only": @"Added in English"} toTableWithName:kTestTable forLocalization:@"en"];
+    XCTAssertEqualObjects([self manager:manager localizedKey:@"greeting"], @"Ciao a tutti");
+    // strings added to the default locale override its tables, not the selected locale
+    XCTAssertEqualObjects([self manager:manager localizedKey:@"fallback.only"], @"Added in English");
+    XCTAssertEqualObjects([self manager:manager localizedKey:@"farewell"], @"Arrivederci");
+
+    [manager resetAddedStringsToTableWithName:kTestTable forLocalization:@"it"];
+    XCTAssertEqualObjects([self manager:manager localizedKey:@"greeting"], @"Ciao");
+    XCTAssertEqualObjects([self manager:manager localizedKey:@"fallback.only"], @"Added in English");
+}
+
+#pragma mark - Batch lookups
+
+- (void)testBatchLookupsMatchSingleLookups
+{
+    SDLocalizationManager* manager = [self managerWithSelectedLocale:@"it"];
+    NSArray<NSString*>* keys = @[@"greeting", @"fallback.only", @"missing", @"menu.1"];
+    NSDictionary* values = [manager localizedKeys:keys fromTable:kTestTable inBundleForClass:[self class]];
+    XCTAssertEqualObjects(values, (@{@"greeting": @"Ciao", @"fallback.only": @"Only in English", @"missing": @"missing", @"menu.1": @"Cerca"}));
+    for (NSString* key in keys)
+    {
+        XCTAssertEqualObjects(values[key], [self manager:manager localizedKey:key]);
+    }
+
+    NSDictionary* valuesByTable = [manager localizedKeysByTable:@{kTestTable: @[@"farewell"], @"GlottyTestsAdded": @[@"title"]} inBundleForClass:[self class]];
+    XCTAssertEqualObjects(valuesByTable, (@{kTestTable: @{@"farewell": @"Arrivederci"}, @"GlottyTestsAdded": @{@"title": @"title"}}));
+
+    NSString* const cKeys[] = {@"greeting", @"missing", @"menu.2"};
+    NSString* cValues[3];
+    [manager getLocalizedValues:cValues forKeys:cKeys count:3 fromTable:kTestTable inBundleForClass:[self class]];
+    XCTAssertEqualObjects(cValues[0], @"Ciao");
+    XCTAssertEqualObjects(cValues[1], @"missing");
+    XCTAssertEqualObjects(cValues[2], @"Impostazioni");
+}
+
+#pragma mark - Preloading
+
+- (void) preloadTablesWithNames:(NSArray<NSString*>*)tableNames manager:(SDLocalizationManager*)manager
+{
+    XCTestExpectation* expectation = [self expectationWithDescription:@"Tables preloaded"];
+    [manager preloadTablesWithNames:tableNames inBundleForClass:[self class] completion:^{
+        XCTAssertTrue([NSThread isMainThread]);
+        [expectation fulfill];
+    }];
+    [self waitForExpectationsWithTimeout:5 handler:nil];
+}
+
+- (void)testPreloadedTablesServeLookupsWithoutLoads
+{
+    SDLocalizationManager* manager = [self managerWithSelectedLocale:@"it"];
+    XCTAssertEqual([manager loadedByteCountOfTableWithName:kTestTable inBundleForClass:[self class]], (NSUInteger)0);
+    [self preloadTablesWithNames:@[kTestTable] manager:manager];
+
+    XCTAssertGreaterThan([manager loadedByteCountOfTableWithName:kTestTable inBundleForClass:[self class]], (NSUInteger)0);
+    uint64_t tableLoads = manager.statistics.tableLoads;
+    XCTAssertGreaterThan(tableLoads, (uint64_t)0);
+    XCTAssertEqualObjects([self manager:manager localizedKey:@"greeting"], @"Ciao");
+    XCTAssertEqual(manager.statistics.tableLoads, tableLoads);
+}
+
+- (void)testPreloadingFindsTheTablesOfTheBundle
+{
+    SDLocalizationManager* manager = [self managerWithSelectedLocale:@"it"];
+    [self preloadTablesWithNames:nil manager:manager];
+    XCTAssertGreaterThan([manager loadedByteCountOfTableWithName:kTestTable inBundleForClass:[self class]], (NSUInteger)0);
+}
+
+#pragma mark - Added strings updates
+
+- (void)testAddedStringsReloadOnlyTheirTable
+{
+    SDLocalizationManager* manager = [self managerWithSelectedLocale:@"it"];
+    XCTAssertEqualObjects([self manager:manager localizedKey:@"greeting"], @"Ciao");
+    uint64_t tableLoads = manager.statistics.tableLoads;
+
+    NSMutableArray<NSNotification*>* notifications = [NSMutableArray array];
+    id updateObserver = [[NSNotificationCenter defaultCenter] addObserverForName:SDLocalizationManagerStringsDidUpdateNotification object:manager queue:nil usingBlock:^(NSNotification* notification) {
+        [notifications addObject:notification];
+    }];
+    id languageObserver = [[NSNotificationCenter defaultCenter] addObserverForName:SDLocalizationManagerLanguageDidChangeNotification object:manager queue:nil usingBlock:^(NSNotification* notification) {
+        XCTFail(@"The language did not change");
+    }];
+    [self addTeardownBlock:^{
+        [[NSNotificationCenter defaultCenter] removeObserver:updateObserver];
+        [[NSNotificationCenter defaultCenter] removeObserver:languageObserver];
+    }];
+
+    [manager addStrings:@{@"title": @"Titolo"} toTableWithName:@"GlottyTestsAdded" forLocalization:@"it"];
+    XCTAssertEqual(notifications.count, (NSUInteger)1);
+    XCTAssertEqualObjects(notifications.firstObject.userInfo[SDLocalizationManagerUpdatedTableNamesKey], @[@"GlottyTestsAdded"]);
+
+    // the tables already loaded are not read again
+    XCTAssertEqualObjects([self manager:manager localizedKey:@"greeting"], @"Ciao");
+    XCTAssertEqual(manager.statistics.tableLoads, tableLoads);
+
+    // nor are they when the strings of another table are reset
+    [manager resetAddedStringsToTableWithName:@"GlottyTestsAdded" forLocalization:@"it"];
+    XCTAssertEqual(notifications.count, (NSUInteger)2);
+    XCTAssertEqualObjects([self manager:manager localizedKey:@"greeting"], @"Ciao");
+    XCTAssertEqual(manager.statistics.tableLoads, tableLoads);
+}
+
+#pragma mark - Placeholders
+
+- (void)testCachedTemplatesFollowTheirTable
+{
+    SDLocalizationManager* manager = [self managerWithSelectedLocale:@"it"];
+    NSString* table = @"GlottyTestsAdded";
+    [manager addStrings:@{@"welcome": @"Benvenuto {name}"} toTableWithName:table forLocalization:@"it"];
+    XCTAssertEqualObjects([manager localizedKey:@"welcome" fromTable:table placeholderDictionary:@{@"{name}": @"Anna"} withDefaultValue:nil], @"Benvenuto Anna");
+    XCTAssertEqualObjects([manager localizedKey:@"welcome" fromTable:table placeholderDictionary:@{@"{name}": @"Bob"} withDefaultValue:nil], @"Benvenuto Bob");
+    // a different set of placeholders is parsed again
+    XCTAssertEqualObjects([manager localizedKey:@"welcome" fromTable:table placeholderDictionary:@{@"{name}": @"Anna", @"Benvenuto": @"Ciao"} withDefaultValue:nil], @"Ciao Anna");
+
+    // the template is dropped with the table
+    [manager addStrings:@{@"welcome": @"Bentornato {name}"} toTableWithName:table forLocalization:@"it"];
+    XCTAssertEqualObjects([manager localizedKey:@"welcome" fromTable:table placeholderDictionary:@{@"{name}": @"Anna"} withDefaultValue:nil], @"Bentornato Anna");
+}
+
+#pragma mark - Key index
+
+- (void)testPrefixAndRangeQueries
+{
+    SDLocalizationManager* manager = [self managerWithSelectedLocale:@"it"];
+    Class bundleClass = [self class];
+    NSArray* menuKeys = @[@"menu.0", @"menu.1", @"menu.2"];
+    XCTAssertEqualObjects([manager localizedKeysWithPrefix:@"menu." fromTable:kTestTable inBundleForClass:bundleClass], menuKeys);
+    XCTAssertEqualObjects([manager localizedStringsWithPrefix:@"menu." fromTable:kTestTable inBundleForClass:bundleClass], (@{@"menu.0": @"Home", @"menu.1": @"Cerca", @"menu.2": @"Impostazioni"}));
+    XCTAssertEqualObjects([manager localizedKeysWithPrefix:@"missing." fromTable:kTestTable inBundleForClass:bundleClass], @[]);
+
+    // the keys of all the tiers, in ordinal order
+    NSArray* allKeys = @[@"fallback.only", @"farewell", @"greeting", @"menu.0", @"menu.1", @"menu.2", @"welcome"];
+    XCTAssertEqualObjects([manager localizedKeysWithPrefix:@"" fromTable:kTestTable inBundleForClass:bundleClass], allKeys);
+    XCTAssertEqualObjects([manager localizedKeysFromKey:@"f" toKey:@"g" fromTable:kTestTable inBundleForClass:bundleClass], (@[@"fallback.only", @"farewell"]));
+    XCTAssertEqualObjects([manager localizedKeysFromKey:@"menu.1" toKey:nil fromTable:kTestTable inBundleForClass:bundleClass], (@[@"menu.1", @"menu.2", @"welcome"]));
+    XCTAssertEqualObjects([manager localizedKeysFromKey:nil toKey:@"farewell" fromTable:kTestTable inBundleForClass:bundleClass], @[@"fallback.only"]);
+
+    // added keys join the index of the table
+    [manager addStrings:@{@"menu.3": @"Profilo"} toTableWithName:kTestTable forLocalization:@"it"];
+    XCTAssertEqualObjects([manager localizedKeysWithPrefix:@"menu." fromTable:kTestTable inBundleForClass:bundleClass], ([menuKeys arrayByAddingObject:@"menu.3"]));
+}
+
+- (void)testArraysOfLocalizedStringsStopAtTheFirstGap
+{
+    SDLocalizationManager* manager = [self managerWithSelectedLocale:@"it"];
+    [manager addStrings:@{@"glottytests.list.0": @"zero",
+                          @"glottytests.list.1": @"uno",
+                          @"glottytests.list.2": @"due",
+                          @"glottytests.list.4": @"quattro",
+                          @"glottytests.list.01": @"not an index",
+                          @"glottytests.list.x": @"not an index",
+                          @"glottytests.list.99999999999999999999999": @"too long for an index"}
+        toTableWithName:@"Localizable" forLocalization:@"it"];
+    XCTAssertEqualObjects([manager arrayOfLocalizedStringsWithPrefix:@"glottytests.list"], (@[@"zero", @"uno", @"due"]));
+    XCTAssertEqualObjects([manager arrayOfLocalizedStringsWithPrefix:@"glottytests.missing"], @[]);
+}
+
+#pragma mark - Key IDs
+
+- (void)testKeyIDLookupsWithoutPacksUseTheKeys
+{
+    SDLocalizationManager* manager = [self managerWithSelectedLocale:@"it"];
+    [manager addStrings:@{@"glottytests.title": @"Titolo"} toTableWithName:@"Localizable" forLocalization:@"it"];
+    XCTAssertEqualObjects([manager localizedStringWithKeyID:0 key:@"glottytests.title" keySetHash:0x1234 fromTable:@"Localizable"], @"Titolo");
+    XCTAssertEqualObjects([manager localizedStringWithKeyID:7 key:@"glottytests.missing" keySetHash:0x1234 fromTable:@"Localizable.strings"], @"glottytests.missing");
+    XCTAssertEqual(manager.statistics.keyIDLookups, (uint64_t)0);
+}
+
+#pragma mark - Supported locales
+
+- (void)testSupportedLocalesAreMemoized
+{
+    SDLocalizationManager* manager = [self managerWithSelectedLocale:@"it"];
+    NSLocale* locale = [manager supportedLocaleWithIdentifier:@"it-IT"];
+    XCTAssertEqualObjects(locale.localeIdentifier, @"it");
+    XCTAssertTrue([manager supportedLocaleWithIdentifier:@"it-IT"] == locale);
+    XCTAssertNil([manager supportedLocaleWithIdentifier:@"fr"]);
+    XCTAssertFalse([manager supportsLocaleWithIdentifier:@"fr"]);
+    XCTAssertNil([manager supportedLocaleWithIdentifier:nil]);
+
+    // the memoized results are dropped with the supported locales
+    [manager setSupportedLocales:@[@"en", @"it", @"fr"]];
+    XCTAssertTrue([manager supportsLocaleWithIdentifier:@"fr"]);
+    XCTAssertEqualObjects([manager supportedLocaleWithIdentifier:@"fr-CA"].localeIdentifier, @"fr");
+}
+
+- (void)testLocalesAvailableOnSystem
+{
+    XCTAssertTrue([NSLocale isLocaleIdentifierAvailableOnSystem:@"it_IT"]);
+    XCTAssertTrue([NSLocale isLocaleIdentifierAvailableOnSystem:@"it-IT"]);
+    XCTAssertFalse([NSLocale isLocaleIdentifierAvailableOnSystem:@"xx_YY"]);
+}
+
+#pragma mark - Statistics
+
+- (void)testLookupsAreCountedByTierAndSource
+{
+    SDLocalizationManager* manager = [self managerWithSelectedLocale:@"it"];
+    [manager addStrings:@{@"farewell": @"A presto"} toTableWithName:kTestTable forLocalization:@"it"];
+    [manager resetStatistics];
+
+    [self manager:manager localizedKey:@"greeting"];
+    [self manager:manager localizedKey:@"farewell"];
+    [self manager:manager localizedKey:@"fallback.only"];
+    [self manager:manager localizedKey:@"missing"];
+    [manager localizedKey:@"missing" fromTable:kTestTable inBundleForClass:[self class] withDefaultValue:@"default"];
+
+    SDLocalizationStatistics* statistics = manager.statistics;
+    XCTAssertEqual([statistics lookupsServedByTier:SDLocalizationTierSelected source:SDLocalizationSourceBundle], (uint64_t)1);
+    XCTAssertEqual([statistics lookupsServedByTier:SDLocalizationTierSelected source:SDLocalizationSourceDynamic], (uint64_t)1);
+    XCTAssertEqual([statistics lookupsServedByTier:SDLocalizationTierDefault source:SDLocalizationSourceBundle], (uint64_t)1);
+    XCTAssertEqual([statistics valueOfCounter:SDLocalizationCounterForLookup(SDLocalizationTierDefault, SDLocalizationSourceBundle)], (uint64_t)1);
+    XCTAssertEqual(statistics.lookupsServed, (uint64_t)3);
+    XCTAssertEqual(statistics.keyReturns, (uint64_t)1);
+    XCTAssertEqual(statistics.defaultValueReturns, (uint64_t)1);
+
+    [manager resetStatistics];
+    XCTAssertEqual(manager.statistics.lookupsServed, (uint64_t)0);
+    XCTAssertEqual(manager.statistics.keyReturns, (uint64_t)0);
+}
+
+- (void)testBatchLookupsAreCountedLikeSingleLookups
+{
+    SDLocalizationManager* manager = [self managerWithSelectedLocale:@"it"];
+    [manager resetStatistics];
+    [manager localizedKeys:@[@"greeting", @"fallback.only", @"missing"] fromTable:kTestTable inBundleForClass:[self class]];
+
+    SDLocalizationStatistics* statistics = manager.statistics;
+    XCTAssertEqual([statistics lookupsServedByTier:SDLocalizationTierSelected source:SDLocalizationSourceBundle], (uint64_t)1);
+    XCTAssertEqual([statistics lookupsServedByTier:SDLocalizationTierDefault source:SDLocalizationSourceBundle], (uint64_t)1);
+    XCTAssertEqual(statistics.keyReturns, (uint64_t)1);
+
+    NSString* const keys[] = {@"greeting", @"missing", @"other.missing"};
+    NSString* values[3];
+    [manager getLocalizedValues:values forKeys:keys count:3 fromTable:kTestTable inBundleForClass:[self class]];
+    statistics = manager.statistics;
+    XCTAssertEqual(statistics.lookupsServed, (uint64_t)3);
+    XCTAssertEqual(statistics.keyReturns, (uint64_t)3);
+}
+
+#pragma mark - Loaded tables
+
+- (void)testLeastRecentlyUsedTablesAreUnloaded
+{
+    SDLocalizationManager* manager = [self managerWithSelectedLocale:@"it"];
+    [manager addStrings:@{@"title": @"Titolo"} toTableWithName:@"GlottyTestsAdded" forLocalization:@"it"];
+    [manager resetStatistics];
+    XCTAssertEqualObjects([self manager:manager localizedKey:@"greeting"], @"Ciao");
+
+    // load statistics count the size of the files read, not the memory of the tables
+    NSString* path = [[NSBundle bundleForClass:[self class]] pathForResource:kTestTable ofType:@"strings" inDirectory:nil forLocalization:@"it"];
+    uint64_t fileByteCount = [[NSFileManager defaultManager] attributesOfItemAtPath:path error:NULL].fileSize;
+    XCTAssertGreaterThanOrEqual(manager.statistics.tableLoadBytes, fileByteCount);
+
+    // the table being used is kept, even beyond the limit
+    manager.loadedTablesByteLimit = 1;
+    XCTAssertEqual(manager.statistics.tableEvictions, (uint64_t)0);
+    XCTAssertGreaterThan([manager loadedByteCountOfTableWithName:kTestTable inBundleForClass:[self class]], (NSUInteger)0);
+
+    XCTAssertEqualObjects([manager localizedKey:@"title" fromTable:@"GlottyTestsAdded" inBundleForClass:[self class] withDefaultValue:nil], @"Titolo");
+    XCTAssertEqual(manager.statistics.tableEvictions, (uint64_t)1);
+    XCTAssertEqual([manager loadedByteCountOfTableWithName:kTestTable inBundleForClass:[self class]], (NSUInteger)0);
+    XCTAssertGreaterThan([manager loadedByteCountOfTableWithName:@"GlottyTestsAdded" inBundleForClass:[self class]], (NSUInteger)0);
+
+    // unloaded tables are loaded again by the next lookup
+    uint64_t tableLoads = manager.statistics.tableLoads;
+    XCTAssertEqualObjects([self manager:manager localizedKey:@"greeting"], @"Ciao");
+    XCTAssertGreaterThan(manager.statistics.tableLoads, tableLoads);
+}
+
+- (void)testUnloadingAllTables
+{
+    SDLocalizationManager* manager = [self managerWithSelectedLocale:@"it"];
+    XCTAssertEqualObjects([self manager:manager localizedKey:@"greeting"], @"Ciao");
+    XCTAssertGreaterThan(manager.loadedTablesByteCount, (NSUInteger)0);
+
+    [manager unloadTables];
+    XCTAssertEqual(manager.loadedTablesByteCount, (NSUInteger)0);
+    XCTAssertEqual([manager loadedByteCountOfTableWithName:kTestTable inBundleForClass:[self class]], (NSUInteger)0);
+    XCTAssertEqualObjects([self manager:manager localizedKey:@"farewell"], @"Arrivederci");
+}
+
+#pragma mark - Asynchronous switch
+
+- (void)testAsynchronousSwitchPreloadsTheTables
+{
+    SDLocalizationManager* manager = [self managerWithSelectedLocale:@"it"];
+    XCTestExpectation* expectation = [self expectationWithDescription:@"switch"];
+    [manager setSelectedLocaleWithIdentifier:@"de" preloadingTablesWithNames:@[kTestTable] inBundleForClass:[self class] completion:^(BOOL selected) {
+        XCTAssertTrue(selected);
+        XCTAssertTrue([NSThread isMainThread]);
+        [expectation fulfill];
+    }];
+    [self waitForExpectationsWithTimeout:5 handler:nil];
+
+    XCTAssertEqualObjects(manager.selectedLocale.localeIdentifier, @"de");
+    XCTAssertGreaterThan([manager loadedByteCountOfTableWithName:kTestTable inBundleForClass:[self class]], (NSUInteger)0);
+    // no German strings: the default locale serves the lookups
+    XCTAssertEqualObjects([self manager:manager localizedKey:@"greeting"], @"Hello");
+}
+
+- (void)testStaleAsynchronousSwitchIsDropped
+{
+    SDLocalizationManager* manager = [self managerWithSelectedLocale:@"it"];
+    XCTestExpectation* expectation = [self expectationWithDescription:@"switch"];
+    [manager setSelectedLocaleWithIdentifier:@"de" preloadingTablesWithNames:@[kTestTable] inBundleForClass:[self class] completion:^(BOOL selected) {
+        XCTAssertFalse(selected);
+        [expectation fulfill];
+    }];
+
+    // a synchronous switch started later supersedes the asynchronous one
+    [manager setSelectedLocaleWithIdentifier:@"en"];
+    [self waitForExpectationsWithTimeout:5 handler:nil];
+
+    XCTAssertEqualObjects(manager.selectedLocale.localeIdentifier, @"en");
+    XCTAssertEqualObjects([self manager:manager localizedKey:@"greeting"], @"Hello");
+}
+
+#pragma mark - Concurrency
+
+- (void)testLookupsDuringUpdatesSeeOldOrNewValues
+{
+    SDLocalizationManager* manager = [self managerWithSelectedLocale:@"it"];
+    NSUInteger updateCount = 50;
+    NSLock* lock = [NSLock new];
+    NSMutableSet<NSString*>* unexpectedValues = [NSMutableSet set];
+
+    dispatch_group_t group = dispatch_group_create();
+    for (NSUInteger reader = 0; reader < 4; reader++)
+    {
+        dispatch_group_async(group, dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^{
+            for (NSUInteger index = 0; index < 1000; index++)
+            {
+                NSString* value = [self manager:manager localizedKey:@"greeting"];
+                if (![value hasPrefix:@"Ciao"])
+                {
+                    [lock lock];
+                    [unexpectedValues addObject:value ?: @"nil"];
+                    [lock unlock];
+                }
+            }
+        });
+    }
+    for (NSUInteger update = 0; update < updateCount; update++)
+    {
+        [manager addStrings:@{@"greeting": [NSString stringWithFormat:@"Ciao %lu", (unsigned long)update]} toTableWithName:kTestTable forLocalization:@"it"];
+    }
+    dispatch_group_wait(group, DISPATCH_TIME_FOREVER);
+
+    XCTAssertEqualObjects(unexpectedValues, [NSSet set]);
+    XCTAssertEqualObjects([self manager:manager localizedKey:@"greeting"], ([NSString stringWithFormat:@"Ciao %lu", (unsigned long)(updateCount - 1)]));
+}
+
+#pragma mark - Missing tables
+
+- (void)testAddedStringsFillATableMissingFromTheBundles
+{
+    SDLocalizationManager* manager = [self managerWithSelectedLocale:@"it"];
+    NSString* table = @"GlottyTestsAdded";
+    XCTAssertEqualObjects([manager localizedKey:@"title" fromTable:table inBundleForClass:[self class] withDefaultValue:nil], @"title");
+
+    // the table is remembered as missing only until strings are added to it
+    [manager addStrings:@{@"title": @"Titolo"} toTableWithName:table forLocalization:@"it"];
+    XCTAssertEqualObjects([manager localizedKey:@"title" fromTable:table inBundleForClass:[self class] withDefaultValue:nil], @"Titolo");
+
+    // a new manager finds the table in the directory of added strings
+    [manager flushPendingWrites];
+    GTYDynamicStringsStore* store = [manager valueForKey:@"dynamicStringsStore"];
+    GTYDynamicStringsStore* reopenedStore = [[GTYDynamicStringsStore alloc] initWithDirectoryPath:store.directoryPath];
+    XCTAssertTrue([reopenedStore hasStringsForTable:table localization:@"it"]);
+    XCTAssertFalse([reopenedStore hasStringsForTable:table localization:@"en"]);
+}
+
+@end
@@ -0,0 +1,113 @@
+//
+//  SDLocalizationSettingsTests.m
+//  Tests
+//
+
+@import XCTest;
+#import <Glotty/SDLocalizationManager.h>
+
+#define kDateFormatKey      @"LM_USER_DEF_DATE_FORMAT"
+#define kDistanceUnitKey    @"LM_USER_DEF_DISTANCE_UNIT"
+
+@interface SDLocalizationSettingsTests : XCTestCase
+@property (nonatomic, strong) NSDictionary<NSString*, id>* savedSettings;
+@end
+
+@implementation SDLocalizationSettingsTests
+
+- (void)setUp
+{
+    [super setUp];
+    NSUserDefaults* userDefaults = [NSUserDefaults standardUserDefaults];
+    NSMutableDictionary* savedSettings = [NSMutableDictionary dictionary];
+    for (NSString* key in @[kDateFormatKey, kDistanceUnitKey])
+    {
+        savedSettings[key] = [userDefaults objectForKey:key];
+        [userDefaults removeObjectForKey:key];
+    }
+    self.savedSettings = savedSettings;
+}
+
+- (void)tearDown
+{
+    NSUserDefaults* userDefaults = [NSUserDefaults standardUserDefaults];
+    for (NSString* key in @[kDateFormatKey, kDistanceUnitKey])
+    {
+        [userDefaults setObject:self.savedSettings[key] forKey:key];
+    }
+    [super tearDown];
+}
+
+- (NSUInteger) settingsVersionOfManager:(SDLocalizationManager*)manager
+{
+    return [[[manager valueForKey:@"formattingSettings"] valueForKey:@"version"] unsignedIntegerValue];
+}
+
+#pragma mark - Formatting settings
+
+- (void)testFormattersChangeOnlyWithTheSettings
+{
+    SDLocalizationManager* manager = [SDLocalizationManager new];
+    manager.userDefaultDateFormat = @"yyyy-MM-dd";
+    NSDateFormatter* formatter = manager.userDefaultDateFormatter;
+    XCTAssertEqualObjects(formatter.dateFormat, @"yyyy-MM-dd");
+    XCTAssertTrue(manager.userDefaultDateFormatter == formatter);
+
+    // an unchanged value publishes no new settings
+    NSUInteger version = [self settingsVersionOfManager:manager];
+    manager.userDefaultDateFormat = @"yyyy-MM-dd";
+    XCTAssertEqual([self settingsVersionOfManager:manager], version);
+
+    // a changed format gives another formatter, the one in use is not mutated
+    manager.userDefaultDateFormat = @"dd.MM.yy";
+    XCTAssertNotEqual([self settingsVersionOfManager:manager], version);
+    XCTAssertEqualObjects(manager.userDefaultDateFormatter.dateFormat, @"dd.MM.yy");
+    XCTAssertFalse(manager.userDefaultDateFormatter == formatter);
+    XCTAssertEqualObjects(formatter.dateFormat, @"yyyy-MM-dd");
+}
+
+- (void)testSettingsFollowTheUserDefaults
+{
+    SDLocalizationManager* manager = [SDLocalizationManager new];
+    XCTAssertEqualObjects(manager.userDefaultDateFormat, @"dd/MM/yyyy");
+
+    // values written to user defaults by other code are observed
+    [[NSUserDefaults standardUserDefaults] setObject:@"MM/dd/yyyy" forKey:kDateFormatKey];
+    [[NSUserDefaults standardUserDefaults] setObject:@" mi" forKey:kDistanceUnitKey];
+    XCTAssertEqualObjects(manager.userDefaultDateFormat, @"MM/dd/yyyy");
+    XCTAssertEqualObjects(manager.userDefaultDistanceUnit, @" mi");
+
+    [[NSUserDefaults standardUserDefaults] removeObjectForKey:kDateFormatKey];
+    XCTAssertEqualObjects(manager.userDefaultDateFormat, @"dd/MM/yyyy");
+}
+
+#pragma mark - Persistence
+
+- (void)testSettingsAreSynchronizedLater
+{
+    SDLocalizationManager* manager = [SDLocalizationManager new];
+    manager.userDefaultDistanceUnit = @" km";
+    // visible immediately, written to disk later
+    XCTAssertEqualObjects([[NSUserDefaults standardUserDefaults] objectForKey:kDistanceUnitKey], @" km");
+    XCTAssertTrue([[manager valueForKey:@"hasUnsynchronizedSettings"] boolValue]);
+
+    NSPredicate* synchronized = [NSPredicate predicateWithBlock:^BOOL(SDLocalizationManager* evaluatedManager, NSDictionary* bindings) {
+        return ![[evaluatedManager valueForKey:@"hasUnsynchronizedSettings"] boolValue];
+    }];
+    [self waitForExpectations:@[[[XCTNSPredicateExpectation alloc] initWithPredicate:synchronized object:manager]] timeout:5];
+}
+
+- (void)testFlushSynchronizesThePendingSettings
+{
+    SDLocalizationManager* manager = [SDLocalizationManager new];
+    manager.userDefaultDistanceUnit = @" km";
+    manager.userDefaultDateFormat = @"yyyy-MM-dd";
+    [manager flushPendingWrites];
+    XCTAssertFalse([[manager valueForKey:@"hasUnsynchronizedSettings"] boolValue]);
+
+    // unchanged values are not written again
+    manager.userDefaultDistanceUnit = @" km";
+    XCTAssertFalse([[manager valueForKey:@"hasUnsynchronizedSettings"] boolValue]);
+}
+
+@end
@@ -1,35 +0,0 @@
-//
-//  Tests.m
-//  Tests
-//
-//  Created by francescoceravolo on 06/26/2017.
-//  Copyright (c) 2017 francescoceravolo. All rights reserved.
-//
-
-@import XCTest;
-
-@interface Tests : XCTestCase
-
-@end
-
-@implementation Tests
-
-- (void)setUp
-{
-    [super setUp];
-    // Put setup code here. This method is called before the invocation of each test method in the class.
-}
-
-- (void)tearDown
-{
-    // Put teardown code here. This method is called after the invocation of each test method in the class.
-    [super tearDown];
-}
-
-- (void)testExample
-{
-    XCTFail(@"No implementation for \"%s\"", __PRETTY_FUNCTION__);
-}
-
-@end
-
@@ -0,0 +1,38 @@
+#!/usr/bin/env ruby
+#
+# Tests of Scripts/glotty-pack. Run with: ruby Example/Tests/glotty-pack-tests.rb
+
+require 'minitest/autorun'
+require 'json'
+
+load File.expand_path('../../Scripts/glotty-pack', __dir__)
+
+class GlottyPackTests < Minitest::Test
+  # the same chains are checked against GTYLocaleMatcher by GTYLocaleMatcherTests
+  def test_fallback_chains_match_the_locale_matcher
+    fixture = JSON.parse(File.read(File.expand_path('fallback-chains.json', __dir__)))
+    fixture['chains'].each do |entry|
+      assert_equal entry['chain'], fallback_chain(entry['identifier'], fixture['default'], fixture['supported']), entry['identifier']
+    end
+  end
+
+  def test_fallback_chain_without_localization
+    assert_equal ['en'], fallback_chain(nil, 'en', %w[en it])
+    assert_equal ['it'], fallback_chain('it', nil, [])
+  end
+
+  def test_subtags
+    assert_equal({ identifier: 'zh_Hant_TW', language: 'zh', script: 'Hant', explicit_script: true, region: 'TW', variant: '' }, subtags('zh_Hant_TW'))
+    assert_equal 'Latn', subtags('sr-ME')[:script]
+    assert_equal '419', subtags('es-419')[:region]
+    assert_equal 'POSIX', subtags('en__POSIX')[:variant]
+    assert_equal 'he', subtags('iw')[:language]
+  end
+
+  def test_packs_of_the_same_keys_share_the_hash
+    keys = sorted_keys(%w[b a ab])
+    assert_equal %w[a ab b], keys
+    assert_equal key_set_hash(keys), key_set_hash(sorted_keys(%w[ab b a]))
+    refute_equal key_set_hash(keys), key_set_hash(sorted_keys(%w[a b]))
+  end
+end
@@ -0,0 +1,85 @@
+// Copyright 2017 Sysdata S.p.A.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#import <Foundation/Foundation.h>
+
+/**
+ * The kinds of change described by an SDLocalizationChangeSet. Coalesced change sets may combine several of them.
+ */
+typedef NS_OPTIONS(NSUInteger, SDLocalizationChangeKind)
+{
+    /** The selected locale changed: every table may have changed. */
+    SDLocalizationChangeKindLanguage        = 1 << 0,
+    /** Strings were added by code. */
+    SDLocalizationChangeKindStringsAdded    = 1 << 1,
+    /** Strings added by code were removed. */
+    SDLocalizationChangeKindStringsReset    = 1 << 2,
+};
+
+/**
+ * An immutable description of what changed in the strings of SDLocalizationManager, posted with its notifications under SDLocalizationManagerChangeSetKey.
+ *
+ * Observers can refresh only what is affected, e.g. the labels bound to the changed keys:
+ *
+ *     if ([changeSet containsKey:@"title" inTableWithName:@"Localizable"]) { ... }
+ *
+ * Unknown parts are nil and mean "any": a language change affects all the tables, a reset all the keys of its tables.
+ */
+@interface SDLocalizationChangeSet : NSObject
+
+/**
+ * @param tableNames Names of the affected tables, nil for all the tables.
+ * @param localizations Ids of the affected localizations, nil for all of them.
+ * @param keys Keys affected in each of the given tables, nil if unknown.
+ */
+- (instancetype) initWithKinds:(SDLocalizationChangeKind)kinds tableNames:(NSSet<NSString*>*)tableNames localizations:(NSSet<NSString*>*)localizations keys:(NSSet<NSString*>*)keys;
+
+/**
+ * Returns a change set for a change of the selected locale.
+ */
++ (instancetype) languageChangeSet;
+
+@property (nonatomic, readonly) SDLocalizationChangeKind kinds;
+
+/**
+ * Names of the affected tables, or nil if all the tables may have changed.
+ */
+@property (nonatomic, readonly) NSSet<NSString*>* tableNames;
+
+/**
+ * Ids of the affected localizations, or nil if all of them may have changed.
+ */
+@property (nonatomic, readonly) NSSet<NSString*>* localizations;
+
+/**
+ * Returns the keys changed in the given table: an empty set if the table did not change, nil if any of its keys may have changed.
+ */
+- (NSSet<NSString*>*) keysOfTableWithName:(NSString*)tableName;
+
+/**
+ * Returns YES if the given table changed.
+ */
+- (BOOL) containsTableWithName:(NSString*)tableName;
+
+/**
+ * Returns YES if the string with the given key may have changed in the given table.
+ */
+- (BOOL) containsKey:(NSString*)key inTableWithName:(NSString*)tableName;
+
+/**
+ * Returns a change set describing both the receiver and the given one.
+ */
+- (SDLocalizationChangeSet*) changeSetByMergingChangeSet:(SDLocalizationChangeSet*)changeSet;
+
+@end
@@ -0,0 +1,120 @@
+// Copyright 2017 Sysdata S.p.A.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#import "SDLocalizationChangeSet.h"
+
+@interface SDLocalizationChangeSet ()
+/**
+ * Changed keys by table name. Tables with unknown keys are missing.
+ */
+@property (nonatomic, strong) NSDictionary<NSString*, NSSet<NSString*>*>* keysByTableName;
+@end
+
+@implementation SDLocalizationChangeSet
+
+- (instancetype) initWithKinds:(SDLocalizationChangeKind)kinds tableNames:(NSSet<NSString*>*)tableNames localizations:(NSSet<NSString*>*)localizations keys:(NSSet<NSString*>*)keys
+{
+    NSMutableDictionary<NSString*, NSSet<NSString*>*>* keysByTableName = [NSMutableDictionary dictionary];
+    if (keys)
+    {
+        for (NSString* tableName in tableNames)
+        {
+            keysByTableName[tableName] = [keys copy];
+        }
+    }
+    return [self initWithKinds:kinds tableNames:tableNames localizations:localizations keysByTableName:keysByTableName];
+}
+
+- (instancetype) initWithKinds:(SDLocalizationChangeKind)kinds tableNames:(NSSet<NSString*>*)tableNames localizations:(NSSet<NSString*>*)localizations keysByTableName:(NSDictionary<NSString*, NSSet<NSString*>*>*)keysByTableName
+{
+    self = [super init];
+    if (self)
+    {
+        _kinds = kinds;
+        _tableNames = [tableNames copy];
+        _localizations = [localizations copy];
+        _keysByTableName = [keysByTableName copy];
+    }
+    return self;
+}
+
++ (instancetype) languageChangeSet
+{
+    return [[self alloc] initWithKinds:SDLocalizationChangeKindLanguage tableNames:nil localizations:nil keys:nil];
+}
+
+#pragma mark - Queries
+
+- (NSSet<NSString*>*) keysOfTableWithName:(NSString*)tableName
+{
+    if (![self containsTableWithName:tableName])
+    {
+        return [NSSet set];
+    }
+    return self.keysByTableName[tableName];
+}
+
+- (BOOL) containsTableWithName:(NSString*)tableName
+{
+    return !self.tableNames || [self.tableNames containsObject:tableName];
+}
+
+- (BOOL) containsKey:(NSString*)key inTableWithName:(NSString*)tableName
+{
+    if (![self containsTableWithName:tableName])
+    {
+        return NO;
+    }
+    NSSet<NSString*>* keys = self.keysByTableName[tableName];
+    return !keys || [keys containsObject:key];
+}
+
+#pragma mark - Merging
+
+- (SDLocalizationChangeSet*) changeSetByMergingChangeSet:(SDLocalizationChangeSet*)changeSet
+{
+    if (!changeSet)
+    {
+        return self;
+    }
+
+    SDLocalizationChangeKind kinds = self.kinds | changeSet.kinds;
+    NSSet<NSString*>* localizations = (self.localizations && changeSet.localizations) ? [self.localizations setByAddingObjectsFromSet:changeSet.localizations] : nil;
+    if (!self.tableNames || !changeSet.tableNames)
+    {
+        // all the tables, with any of their keys
+        return [[SDLocalizationChangeSet alloc] initWithKinds:kinds tableNames:nil localizations:localizations keysByTableName:nil];
+    }
+
+    NSSet<NSString*>* tableNames = [self.tableNames setByAddingObjectsFromSet:changeSet.tableNames];
+    NSMutableDictionary<NSString*, NSSet<NSString*>*>* keysByTableName = [NSMutableDictionary dictionary];
+    for (NSString* tableName in tableNames)
+    {
+        // keys stay known only if they are known in both change sets
+        NSSet<NSString*>* keys = [self keysOfTableWithName:tableName];
+        NSSet<NSString*>* otherKeys = [changeSet keysOfTableWithName:tableName];
+        if (keys && otherKeys)
+        {
+            keysByTableName[tableName] = [keys setByAddingObjectsFromSet:otherKeys];
+        }
+    }
+    return [[SDLocalizationChangeSet alloc] initWithKinds:kinds tableNames:tableNames localizations:localizations keysByTableName:keysByTableName];
+}
+
+- (NSString*) description
+{
+    return [NSString stringWithFormat:@"<%@: %p; kinds = %lu; tables = %@; localizations = %@; keys = %@>", NSStringFromClass(self.class), self, (unsigned long)self.kinds, self.tableNames.allObjects ?: @"all", self.localizations.allObjects ?: @"all", self.keysByTableName];
+}
+
+@end
@@ -1,6 +1,13 @@
 
 
+#if __has_include(<UIKit/UIKit.h>)
 #import <UIKit/UIKit.h>
+#define GLOTTY_UIKIT 1
+#else
+// headless builds, like the benchmarks built with GNUstep: localized images and app notifications are not available
+#import <Foundation/Foundation.h>
+#define GLOTTY_UIKIT 0
+#endif
 
 // This code is compatible with our logger "Blabber".
 #define kLocalizationManagerLogModuleName @"Glotty"
@@ -15,6 +15,8 @@
 #import <Foundation/Foundation.h>
 #import "NSLocale+Glotty.h"
 #import "SDLocalizationLogger.h"
+#import "SDLocalizationStatistics.h"
+#import "SDLocalizationChangeSet.h"
 
 
 #ifdef SDLocalizedString
@@ -49,8 +51,24 @@ NSString* SDLocalizedStringFromTableInBundleForClass(NSString * key, NSString *t
 
 NSString* SDLocalizedStringFromTableInBundleForClassWithDefault(NSString * key, NSString *table, Class bundleClass, NSString *val);
 
+/**
+ * Returns the localized value of a key identified by the ID generated by glotty-pack --header. Usually called through the functions of the generated header.
+ */
+NSString* SDLocalizedStringWithKeyID(uint32_t keyID, NSString* key, uint32_t keySetHash, NSString* table);
+
+#if GLOTTY_UIKIT
+/**
+ * Returns the image with the given name localized in the selected locale, trying the png, jpg and jpeg extensions and then the name as it is.
+ *
+ * Resolved paths and decoded images are cached, see imageCacheByteLimit.
+ */
 UIImage* SDLocalizedImage(NSString * key);
 UIImage* SDLocalizedImageWithNameAndExtension(NSString * key, NSString *type);
+/**
+ * Like SDLocalizedImage, but the image is loaded and decoded on a background queue. The completion is called on the main queue, with nil if the image is not found.
+ */
+void SDLocalizedImageAsync(NSString * key, void (^completion)(UIImage* image));
+#endif
 
 
 @protocol SDLocalizationManagerDelegate <NSObject>
@@ -65,8 +83,20 @@ UIImage* SDLocalizedImageWithNameAndExtension(NSString * key, NSString *type);
 - (NSString*)ISOLocaleIdentifierForNonStandardLocale:(NSString*)locale;
 @end
 
+/**
+ * Posted when the selected locale changes, with the locale as object. The userInfo contains an SDLocalizationChangeSet of kind SDLocalizationChangeKindLanguage, merged with the strings updates still to be posted.
+ */
 #define SDLocalizationManagerLanguageDidChangeNotification @"SDLocalizationManagerLanguageDidChangeNotification"
 
+/**
+ * Posted when strings are added or reset, while the selected language does not change. Updates close in time are coalesced into a single notification, see notificationCoalescingInterval.
+ * The userInfo contains the SDLocalizationChangeSet of the updates, the names of the updated tables and, if the updates concern a single localization, its id.
+ */
+#define SDLocalizationManagerStringsDidUpdateNotification   @"SDLocalizationManagerStringsDidUpdateNotification"
+#define SDLocalizationManagerUpdatedTableNamesKey           @"SDLocalizationManagerUpdatedTableNamesKey"    // NSArray<NSString*>
+#define SDLocalizationManagerUpdatedLocalizationKey         @"SDLocalizationManagerUpdatedLocalizationKey"  // NSString
+#define SDLocalizationManagerChangeSetKey                   @"SDLocalizationManagerChangeSetKey"            // SDLocalizationChangeSet
+
 @class SDLocalizationManager;
 
 /**
@@ -91,14 +121,14 @@ UIImage* SDLocalizedImageWithNameAndExtension(NSString * key, NSString *type);
  *
  * Before setting up the supported locales is nil, but immediately after it is the same as the operating system (if supported) or the default one. The selected locale is saved in user defaults.
  */
-@property (nonatomic, readonly) NSLocale *selectedLocale;
+@property (atomic, readonly) NSLocale *selectedLocale;
 
 /**
  * The default locale.
  *
  * Is selected during initialization if the operating system locale is not one of the supported ones. It is also used as the last resource if a string is not localized in the selected locale.
  */
-@property (nonatomic, readonly) NSLocale *defaultLocale;
+@property (atomic, readonly) NSLocale *defaultLocale;
 
 /**
  * Indicates whether the manager can accept only the recognized premises by the operating system.
@@ -119,6 +149,20 @@ UIImage* SDLocalizedImageWithNameAndExtension(NSString * key, NSString *type);
  */
 - (void) setSelectedLocaleWithIdentifier:(NSString*)identifier;
 
+/**
+ * Selects the locale with the given identifier like setSelectedLocaleWithIdentifier:, without blocking the caller.
+ *
+ * The tables of the new fallback chain are loaded and the formatting data of the locale is warmed on a background queue, while the current locale keeps serving lookups. Then the locale, its tables and the formatters are swapped in at once on the main queue, and SDLocalizationManagerLanguageDidChangeNotification is posted, so the UI reloads against warm tables.
+ *
+ * A switch started later, synchronous or not, supersedes this one, which is dropped.
+ *
+ * @param identifier The locale identifier to be set as selected.
+ * @param tableNames Names of the tables to load before the switch. If nil, all the tables found in the main bundle, in the given bundle and among the added strings are loaded.
+ * @param bundleClass A class contained in the same bundle of the tables. Can be nil.
+ * @param completion Block called on the main queue after the switch, with NO if the locale is not supported or the switch was superseded. Can be nil.
+ */
+- (void) setSelectedLocaleWithIdentifier:(NSString*)identifier preloadingTablesWithNames:(NSArray<NSString*>*)tableNames inBundleForClass:(Class)bundleClass completion:(void (^)(BOOL selected))completion;
+
 /**
  * Check if the selectedLocale has an identifier equal to the previous one.
  *
@@ -135,6 +179,13 @@ UIImage* SDLocalizedImageWithNameAndExtension(NSString * key, NSString *type);
  */
 - (void) setDefaultLocaleWithIdentifier:(NSString*)identifier;
 
+/**
+ * Writes to disk the settings and the added strings that are still pending.
+ *
+ * Setters of persisted settings and addStrings methods update memory immediately and write to disk later on a background queue, coalescing close writes. Pending writes are flushed automatically when the app enters background or terminates; call this method to flush them earlier.
+ */
+- (void) flushPendingWrites;
+
 /**
  * Erases saved settings in user defaults so that the local selection is recalculated.
  * This method must be called before making any setting in the SDLocalizationManager.
@@ -179,8 +230,8 @@ UIImage* SDLocalizedImageWithNameAndExtension(NSString * key, NSString *type);
 - (BOOL) supportsLocaleWithIdentifier:(NSString*)identifier;
 
 /**
- * Returns the most specific supported locale corresponding to the past argument in the topic.
- * If the past string identifies a country-specific locale (eg "es_ES") and this is not supported, then this method verifies whether the app supports its generic locale (eg "es"). In that case returns it, otherwise it returns nil.
+ * Returns the supported locale that best matches the past identifier.
+ * Identifiers are matched by language, script and region, accepting both "-" and "_" as separators: if a country-specific locale (eg "es_ES") is not supported, then this method returns its generic locale (eg "es") or, failing that, a supported locale of another country (eg "es_MX"). Locales written in a different script never match (eg "zh-Hant-TW" does not match "zh", which is written in simplified Chinese). If no supported locale matches, it returns nil.
  *
  * @param identifier The locale identifier to be returned.
  *
@@ -287,7 +338,7 @@ UIImage* SDLocalizedImageWithNameAndExtension(NSString * key, NSString *type);
  *
  * @param key The localized key.
  * @param tableName The .strings name that contains the key.
- * @param placeholderDictionary A dictionary that has the keys as strings to look for in localizedString and to be replaced with its values.
+ * @param placeholderDictionary A dictionary that has the keys as strings to look for in localizedString and to be replaced with its values. All placeholders are replaced in a single pass, preferring the longest one when more match at the same position.
  * @param defaultValue The default value to be returned if the key does not exist.
  *
  * @return The value associated with the localized key or the default value passed.
@@ -311,16 +362,175 @@ UIImage* SDLocalizedImageWithNameAndExtension(NSString * key, NSString *type);
 /**
  * Retrieves and returns all localized strings associated with keys that have the format "<prefix>.% D"
  *
+ * The keys are found with a single scan of the ordered key index of Localizable, and are returned in order starting from "<prefix>.0" up to the first missing index.
+ *
  * @param prefix The prefix of the localized key list to retrieve.
  *
  * @return The list of all keys associated with the past prefix.
  */
 - (NSArray*) arrayOfLocalizedStringsWithPrefix:(NSString*)prefix;
 
+#pragma mark - Batch Localized Strings
+
+/**
+ * Returns the localized values of the given keys in Localizable.strings associated with the selectedLocale.
+ *
+ * Like localizedKeys:fromTable:inBundleForClass:.
+ *
+ * @param keys The localized keys.
+ *
+ * @return A dictionary with the value associated with each key.
+ */
+- (NSDictionary<NSString*, NSString*>*) localizedKeys:(NSArray<NSString*>*)keys;
+
+/**
+ * Returns the localized values of the given keys in the past strings associated with the selectedLocale.
+ *
+ * The table and the bundle are resolved once for the whole batch, and each key costs a single lookup in the table already merged for all locales. If a key does not exist, the key itself is returned as its value.
+ *
+ * @param keys The localized keys.
+ * @param tableName The .strings name that contains the keys.
+ * @param bundleClass A class contained in the same bundle of the table. Can be nil.
+ *
+ * @return A dictionary with the value associated with each key.
+ */
+- (NSDictionary<NSString*, NSString*>*) localizedKeys:(NSArray<NSString*>*)keys fromTable:(NSString*)tableName inBundleForClass:(Class)bundleClass;
+
+/**
+ * Returns the localized values of keys belonging to different tables.
+ *
+ * @param keysByTable The localized keys grouped by the name of the table that contains them.
+ * @param bundleClass A class contained in the same bundle of the tables. Can be nil.
+ *
+ * @return A dictionary with the values of the keys of each table, grouped by table name.
+ */
+- (NSDictionary<NSString*, NSDictionary<NSString*, NSString*>*>*) localizedKeysByTable:(NSDictionary<NSString*, NSArray<NSString*>*>*)keysByTable inBundleForClass:(Class)bundleClass;
+
+/**
+ * Writes the localized values of the given keys in a C array, without building intermediate collections.
+ *
+ * Typical use:
+ *
+ *     NSString* keys[] = { @"title", @"subtitle" };
+ *     __strong NSString* values[2];
+ *     [manager getLocalizedValues:values forKeys:keys count:2 fromTable:@"Localizable" inBundleForClass:nil];
+ *
+ * @param values An array of at least count elements that receives the values. If a key does not exist, the key itself is written.
+ * @param keys An array of count localized keys.
+ * @param count The number of keys.
+ * @param tableName The .strings name that contains the keys.
+ * @param bundleClass A class contained in the same bundle of the table. Can be nil.
+ */
+- (void) getLocalizedValues:(NSString* __strong *)values forKeys:(NSString* const *)keys count:(NSUInteger)count fromTable:(NSString*)tableName inBundleForClass:(Class)bundleClass;
+
+#pragma mark - Key IDs
+
+/**
+ * Returns the localized value of the key with the given ID, in the main bundle.
+ *
+ * IDs are generated by glotty-pack --resolve --header together with the strings packs: each merged table keeps an array of values indexed by ID, so a lookup is an array access instead of a string hash. Strings added by code for keys of the header override the packed values like in string lookups; keys that are not in the header are looked up with the string methods.
+ *
+ * If the packs were generated from a different set of keys, or no locale is selected, the key is looked up like with localizedKey:fromTable:inBundleForClass:withDefaultValue:.
+ *
+ * @param keyID The ID of the key.
+ * @param key The key with the given ID.
+ * @param keySetHash The hash of the keys of the generated header, compared with the one stored in the packs.
+ * @param tableName The .strings name that contains the key.
+ *
+ * @return The value associated with the key. If the key has no value, the key itself is returned.
+ */
+- (NSString*) localizedStringWithKeyID:(uint32_t)keyID key:(NSString*)key keySetHash:(uint32_t)keySetHash fromTable:(NSString*)tableName;
+
+#pragma mark - Key Queries
+
+/**
+ * Returns the keys of the table that start with the given prefix, for example all the keys of a namespace like "settings.".
+ *
+ * Each table merged for the selected locale keeps its keys sorted, so the query is a binary search and a scan of the matching keys. Without a selected locale no keys are returned.
+ *
+ * @param prefix The prefix of the keys. An empty prefix returns all keys.
+ * @param tableName The .strings name that contains the keys.
+ * @param bundleClass A class contained in the same bundle of the table. Can be nil.
+ *
+ * @return The matching keys in ordinal order.
+ */
+- (NSArray<NSString*>*) localizedKeysWithPrefix:(NSString*)prefix fromTable:(NSString*)tableName inBundleForClass:(Class)bundleClass;
+
+/**
+ * Like localizedKeysWithPrefix:fromTable:inBundleForClass:, returning also the localized values.
+ *
+ * @return A dictionary with the value associated with each matching key.
+ */
+- (NSDictionary<NSString*, NSString*>*) localizedStringsWithPrefix:(NSString*)prefix fromTable:(NSString*)tableName inBundleForClass:(Class)bundleClass;
+
+/**
+ * Returns the keys of the table in the given range, for example the keys from "a" to "n" of an alphabetical index.
+ *
+ * Like localizedKeysWithPrefix:fromTable:inBundleForClass:, the query is a binary search on the sorted keys of the merged table. Without a selected locale no keys are returned.
+ *
+ * @param fromKey The first key of the range, included. nil to start from the first key.
+ * @param toKey The end of the range, excluded. nil to end with the last key.
+ * @param tableName The .strings name that contains the keys.
+ * @param bundleClass A class contained in the same bundle of the table. Can be nil.
+ *
+ * @return The keys greater than or equal to fromKey and less than toKey, in ordinal order.
+ */
+- (NSArray<NSString*>*) localizedKeysFromKey:(NSString*)fromKey toKey:(NSString*)toKey fromTable:(NSString*)tableName inBundleForClass:(Class)bundleClass;
+
+/**
+ * Enumerates all the keys of the table with their localized values, in ordinal order of keys.
+ *
+ * @param tableName The .strings name.
+ * @param bundleClass A class contained in the same bundle of the table. Can be nil.
+ * @param block The block called for each key. Set stop to YES to end the enumeration.
+ */
+- (void) enumerateLocalizedKeysAndStringsFromTable:(NSString*)tableName inBundleForClass:(Class)bundleClass usingBlock:(void (^)(NSString* key, NSString* string, BOOL* stop))block;
+
+#pragma mark - Preloading
+
+/**
+ * Loads the given tables for the locales of the fallback chain of the selected locale on a background queue, so that the first lookups do not need to read them.
+ *
+ * Tables are loaded in parallel. Lookups issued in the meantime wait only if they need a table that is still loading.
+ *
+ * @param tableNames Names of the tables to load. If nil, all the tables found in the main bundle, in the given bundle and among the added strings are loaded.
+ * @param bundleClass A class contained in the same bundle of the tables. Can be nil.
+ * @param completion Block called on the main queue when all the tables are loaded. Can be nil.
+ */
+- (void) preloadTablesWithNames:(NSArray<NSString*>*)tableNames inBundleForClass:(Class)bundleClass completion:(void (^)(void))completion;
+
+#pragma mark - Loaded tables
+
+/**
+ * Maximum memory, in bytes, used by loaded tables. When a table is loaded beyond the limit, the least recently used tables are unloaded; the table being used is always kept. 0 means no limit, which is the default.
+ *
+ * Sizes are estimated from the length of keys and values. Compiled strings packs are mapped in memory, which the system can reclaim, so they are not counted.
+ */
+@property (atomic, assign) NSUInteger loadedTablesByteLimit;
+
+/**
+ * Estimated memory, in bytes, used by the tables loaded for all the locales of the fallback chain.
+ */
+- (NSUInteger) loadedTablesByteCount;
+
+/**
+ * Estimated memory, in bytes, used by the given table in all the locales of the fallback chain, or 0 if it is not loaded.
+ *
+ * @param tableName The .strings name.
+ * @param bundleClass A class contained in the same bundle of the table. Can be nil.
+ */
+- (NSUInteger) loadedByteCountOfTableWithName:(NSString*)tableName inBundleForClass:(Class)bundleClass;
+
+/**
+ * Unloads all the tables. They are loaded again, transparently, by the next lookups. Called on memory warnings.
+ */
+- (void) unloadTables;
+
 #pragma mark - Adding/Removing strings
 
 /**
  * Adds the given strings to the specific table and localization. Added strings will be maintained permanently. To remove them use resetAddedStringXXX methods.
+ * Only the given table is reloaded, then an SDLocalizationManagerStringsDidUpdateNotification is posted, whose change set contains the keys of the given strings.
  *
  * @param strings dictionary with keys and values for the translations
  * @param tableName Name of the table to which the strings are to be added
@@ -338,6 +548,7 @@ UIImage* SDLocalizedImageWithNameAndExtension(NSString * key, NSString *type);
 
 /**
  * Removes added strings to the specific table and localization.
+ * Like addStrings methods, these methods reload only the affected tables and post an SDLocalizationManagerStringsDidUpdateNotification.
  *
  * @param tableName Name of the table to which the strings are to be added
  * @param localization id of localization of strings.
@@ -346,16 +557,86 @@ UIImage* SDLocalizedImageWithNameAndExtension(NSString * key, NSString *type);
 - (void) resetAllAddedStringsForLocalization:(NSString*)localization;
 - (void) resetAllAddedStrings;
 
+/**
+ * Time, in seconds, during which updates of added strings are collected before posting a single SDLocalizationManagerStringsDidUpdateNotification on the main queue, so that bulk imports do not reload the UI for each call. The default is 0.05 seconds.
+ *
+ * 0 posts a notification for each update, synchronously on the thread of the update.
+ */
+@property (atomic, assign) NSTimeInterval notificationCoalescingInterval;
+
+
+#pragma mark - Statistics
+
+/**
+ * Returns a snapshot of the counters of the manager: lookups served by each tier of the fallback chain and source, lookups that returned the default value or the key, table loads with their size and duration, and locale switches with their duration.
+ *
+ * Counters are always on: each lookup increments a counter without locks.
+ */
+- (SDLocalizationStatistics*) statistics;
+
+/**
+ * Sets all the counters to zero.
+ */
+- (void) resetStatistics;
+
+/**
+ * If greater than 0, table loads and locale switches are traced, together with one lookup out of traceSamplingInterval. Traces are logged with verbose level and, on iOS 12 or later, emitted as signposts visible in Instruments. The default is 0 (no tracing).
+ */
+@property (atomic, assign) NSUInteger traceSamplingInterval;
+
+#if GLOTTY_UIKIT
+#pragma mark - Localized Images
+
+/**
+ * Maximum memory, in bytes, used by the decoded images cached by SDLocalizedImage functions. The least recently used images are evicted first. 0 means no limit; the default is 16 MB.
+ *
+ * The cache is emptied when the selected locale changes and on memory warnings.
+ */
+@property (atomic, assign) NSUInteger imageCacheByteLimit;
+
+/**
+ * Removes all the decoded images from the cache.
+ */
+- (void) removeCachedImages;
+
+/**
+ * Returns the image with the given name localized in the selected locale, trying the given extensions in order. An empty extension looks for the name as it is.
+ */
+- (UIImage*) localizedImageWithKey:(NSString*)key types:(NSArray<NSString*>*)types;
+
+/**
+ * Loads and decodes the localized image on a background queue, like SDLocalizedImageAsync.
+ */
+- (void) loadLocalizedImageWithKey:(NSString*)key completion:(void (^)(UIImage* image))completion;
+#endif
 
 #pragma mark - Formatters & Calendars Management
 
 /**
  * This method resets all formatters and calendars.
  *
+ * Unless a formatter property has been set, each thread receives its own formatter instances, created once per configuration (template or format, locale and time zone) and reused until this method is called. Formatters can therefore be used on background queues without locks; set formatters are shared by all threads.
+ *
  * Subclasses that add formatters or calendars must overwrite this method and call it super.
  */
 - (void)resetFormattersAndCalendars;
 
+/**
+ * Returns a formatter of the calling thread with the format obtained from the given template for the formatterLocale.
+ *
+ * @param dateTemplate The template, e.g. "dd/MM/yyyy".
+ * @param timeZone The time zone of the formatter. If nil, the system one.
+ */
+- (NSDateFormatter*) dateFormatterWithTemplate:(NSString*)dateTemplate timeZone:(NSTimeZone*)timeZone;
+
+/**
+ * Returns a formatter of the calling thread with the given fixed format and the formatterLocale.
+ *
+ * @param dateFormat The format, used as is.
+ * @param timeZone The time zone of the formatter. If nil, the system one.
+ */
+- (NSDateFormatter*) dateFormatterWithFormat:(NSString*)dateFormat timeZone:(NSTimeZone*)timeZone;
+
 #pragma mark - Date Formatters
 
 /**
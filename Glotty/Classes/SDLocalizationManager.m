@@ -15,6 +15,29 @@
 #import "SDLocalizationManager.h"
 #import "SDLocalizationManagerModels.h"
 #import "GTYFileManager.h"
+#import "GTYStringsPack.h"
+#import "GTYStringsParser.h"
+#import "GTYCompactTable.h"
+#import "GTYDynamicStringsStore.h"
+#import "GTYStringTemplate.h"
+#import "GTYFormatterPool.h"
+#import "GTYLocaleMatcher.h"
+#import "GTYLRUCache.h"
+#import <stdatomic.h>
+#if __APPLE__
+#import <mach/mach_time.h>
+#else
+#import <time.h>
+#endif
+#ifndef QOS_CLASS_UTILITY
+// libdispatch builds without quality of service classes
+#define QOS_CLASS_UTILITY               DISPATCH_QUEUE_PRIORITY_LOW
+#define QOS_CLASS_USER_INITIATED        DISPATCH_QUEUE_PRIORITY_HIGH
+#endif
+#if __has_include(<os/signpost.h>)
+#import <os/signpost.h>
+#define SD_SIGNPOSTS 1
+#endif
 
 #define USER_DEF_LOCALE_KEY             @"APP_LANGUAGE_SETTING"
 #define USER_DEF_DATE_FORMAT            @"LM_USER_DEF_DATE_FORMAT"
@@ -25,8 +48,24 @@
 #define USER_DEF_TIME_ZONE              @"LM_USER_DEF_TIME_ZONE"
 #define USER_DEF_CALENDAR_ID            @"LM_USER_DEF_CALENDAR_ID"
 
+// settings written within this interval from each other are saved to disk together
+#define kSettingsSynchronizationDelay   0.5
+
+#define kFormattingSettingsKeys         @[USER_DEF_DATE_FORMAT, USER_DEF_TIME_FORMAT, USER_DEF_DISTANCE_UNIT, USER_DEF_SPEED_UNIT, USER_DEF_CURRENCY_SYMBOL, USER_DEF_TIME_ZONE, USER_DEF_CALENDAR_ID]
+
+// context of the observations of the formatting settings in user defaults
+static void* SDFormattingSettingsContext = &SDFormattingSettingsContext;
+
 #define kDisplayNameLocalizedKeyPrefix  @"LM_locale_name"
 
+// digits of the indexes of arrayOfLocalizedStringsWithPrefix: that always fit an NSInteger, 64-bit or 32-bit
+#define kMaxArrayIndexDigits            (NSIntegerMax > INT32_MAX ? 18 : 9)
+
+// extensions tried by SDLocalizedImage, in order; the empty one looks for the name as it is
+#define kLocalizedImageTypes            @[@"png", @"jpg", @"jpeg", @""]
+#define kDefaultImageCacheByteLimit     (16 * 1024 * 1024)
+#define kDefaultNotificationCoalescingInterval  0.05
+
 #define kSelectedLocaleTablesKey        @"selectedLocalesTables"
 #define kBaseLocaleTablesKey            @"baseLocalesTables"
 #define kDefaultLocaleTablesKey         @"defaultLocaleTables"
@@ -68,60 +107,218 @@ NSString* SDLocalizedStringFromTableInBundleForClassWithDefault(NSString * key,
     return [[SDLocalizationManager sharedManager] localizedKey:key fromTable:table inBundleForClass:bundleClass withDefaultValue:val];
 }
 
+NSString* SDLocalizedStringWithKeyID(uint32_t keyID, NSString* key, uint32_t keySetHash, NSString* table)
+{
+    return [[SDLocalizationManager sharedManager] localizedStringWithKeyID:keyID key:key keySetHash:keySetHash fromTable:table];
+}
+
+#if GLOTTY_UIKIT
 UIImage* SDLocalizedImage(NSString * key)
 {
-    UIImage *image = SDLocalizedImageWithNameAndExtension(key, @"png");
-    
-    if (!image)
+    return [[SDLocalizationManager sharedManager] localizedImageWithKey:key types:kLocalizedImageTypes];
+}
+
+UIImage* SDLocalizedImageWithNameAndExtension(NSString * key, NSString *type)
+{
+    return [[SDLocalizationManager sharedManager] localizedImageWithKey:key types:@[type ?: @""]];
+}
+
+void SDLocalizedImageAsync(NSString * key, void (^completion)(UIImage* image))
+{
+    [[SDLocalizationManager sharedManager] loadLocalizedImageWithKey:key completion:completion];
+}
+
+/**
+ * Returns the memory used by the bitmap of the given image.
+ */
+static NSUInteger SDImageCost(UIImage* image)
+{
+    CGImageRef imageRef = image.CGImage;
+    if (imageRef)
     {
-        image =  SDLocalizedImageWithNameAndExtension(key, @"jpg");
+        return CGImageGetBytesPerRow(imageRef) * CGImageGetHeight(imageRef);
     }
-    if (!image)
+    return (NSUInteger)(image.size.width * image.scale * image.size.height * image.scale * 4);
+}
+
+/**
+ * Returns a copy of the given image with its bitmap already decoded, so that drawing it on the main thread does not decode it again.
+ */
+static UIImage* SDDecodedImage(UIImage* image)
+{
+    CGImageRef imageRef = image.CGImage;
+    if (!imageRef)
     {
-        image =  SDLocalizedImageWithNameAndExtension(key, @"jpeg");
+        return image;
     }
-    if (!image)
+    
+    size_t width = CGImageGetWidth(imageRef);
+    size_t height = CGImageGetHeight(imageRef);
+    CGImageAlphaInfo alphaInfo = CGImageGetAlphaInfo(imageRef);
+    BOOL hasAlpha = !(alphaInfo == kCGImageAlphaNone || alphaInfo == kCGImageAlphaNoneSkipFirst || alphaInfo == kCGImageAlphaNoneSkipLast);
+    CGBitmapInfo bitmapInfo = kCGBitmapByteOrder32Host | (hasAlpha ? kCGImageAlphaPremultipliedFirst : kCGImageAlphaNoneSkipFirst);
+    CGColorSpaceRef colorSpace = CGColorSpaceCreateDeviceRGB();
+    CGContextRef context = CGBitmapContextCreate(NULL, width, height, 8, 0, colorSpace, bitmapInfo);
+    CGColorSpaceRelease(colorSpace);
+    if (!context)
+    {
+        return image;
+    }
+    
+    CGContextDrawImage(context, CGRectMake(0, 0, width, height), imageRef);
+    CGImageRef decodedImageRef = CGBitmapContextCreateImage(context);
+    CGContextRelease(context);
+    if (!decodedImageRef)
     {
-        image =  SDLocalizedImageWithNameAndExtension(key, nil);
+        return image;
     }
-    return image;
+    UIImage* decodedImage = [UIImage imageWithCGImage:decodedImageRef scale:image.scale orientation:image.imageOrientation];
+    CGImageRelease(decodedImageRef);
+    return decodedImage;
 }
+#endif
 
-
-
-UIImage* SDLocalizedImageWithNameAndExtension(NSString * key, NSString *type)
+static uint64_t SDCurrentNanoseconds(void)
 {
-    UIImage *image;
-    
-    NSString *imagePath = [[NSBundle mainBundle] pathForResource:key ofType:type inDirectory:nil forLocalization:[SDLocalizationManager sharedManager].selectedLocale.localeIdentifier];
-    if (!imagePath)
-    {
-        SDLogError(@"Path image nil for key: %@ and type: %@", key, type);
-        
-    }else
-    {
-        image = [UIImage imageWithContentsOfFile:imagePath];
-    }
-    return image;
+#if __APPLE__
+    static mach_timebase_info_data_t timebase;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        mach_timebase_info(&timebase);
+    });
+    return mach_absolute_time() * timebase.numer / timebase.denom;
+#else
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return (uint64_t)time.tv_sec * NSEC_PER_SEC + (uint64_t)time.tv_nsec;
+#endif
 }
 
+#if SD_SIGNPOSTS
+static os_log_t SDSignpostLog(void) API_AVAILABLE(ios(12.0))
+{
+    static os_log_t log;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        log = os_log_create("com.sysdata.glotty", "Localization");
+    });
+    return log;
+}
+#endif
 
 
 @interface SDLocalizationManager ()
 
+@property (atomic, strong, readwrite) NSLocale *selectedLocale;
+@property (atomic, strong, readwrite) NSLocale *defaultLocale;
+
 @property (nonatomic, strong) NSMutableOrderedSet *locales; // NSString
-@property (nonatomic, strong) SDLocalizationDataSource* dataSource;
+
+/**
+ * Results of supportedLocaleWithIdentifier: by identifier, with NSNull for unsupported identifiers, guarded by supportedLocalesLock. It is emptied when supported locales change.
+ */
+@property (nonatomic, strong) NSMutableDictionary<NSString*, id>* supportedLocalesByIdentifier;
+/**
+ * Matching table of the supported locales, rebuilt when they change. Replaced holding supportedLocalesLock, together with the emptying of supportedLocalesByIdentifier.
+ */
+@property (atomic, strong) GTYLocaleMatcher* localeMatcher;
+@property (nonatomic, strong) NSLock* supportedLocalesLock;
+
+/**
+ * The data source is published atomically: lookups read it and its resolved tables without locks, while loads and resets replace them with new snapshots.
+ */
+@property (atomic, strong) SDLocalizationDataSource* dataSource;
+
+/**
+ * Serializes the writers of the data source: publication of loaded tables, invalidations and resets. It is never held while reading files.
+ */
+@property (nonatomic, strong) NSRecursiveLock* dataSourceLock;
+
+/**
+ * Incremented by every locale switch, under dataSourceLock: an asynchronous switch is dropped if another one started after it.
+ */
+@property (nonatomic, assign) NSUInteger localeSwitchSequence;
+
+/**
+ * Data sources being prepared by asynchronous switches, guarded by dataSourceLock. Changes of the added strings are applied to them too, since they share locales with the current one.
+ */
+@property (nonatomic, strong) NSMutableSet<SDLocalizationDataSource*>* preparedDataSources;
+
+/**
+ * Locks held while a merged table is being built, by data source, bundle identifier and table name, guarded by dataSourceLock. Lookups of a table being loaded wait only on its lock.
+ */
+@property (nonatomic, strong) NSMutableDictionary<NSString*, NSLock*>* tableLoadingLocks;
+
+/**
+ * Keys of tableLoadingLocks counted once per thread using or waiting for the lock, so that a lock is removed once the last one is done with it.
+ */
+@property (nonatomic, strong) NSCountedSet<NSString*>* tableLoadingLockUsers;
 
 /**
  * This locale is only used if the selectedLocale is not an ISO standard and is the standard alternative for localization and formatting.
  */
-@property (nonatomic, strong) NSLocale* correspondingStandardLocale;
+@property (atomic, strong) NSLocale* correspondingStandardLocale;
 
 @property (nonatomic, strong) NSString* pathForDynamicStrings;
 
+/**
+ * Journaled store of the strings added by code, kept in pathForDynamicStrings. It knows which tables have added strings without accessing the file system.
+ */
+@property (nonatomic, strong) GTYDynamicStringsStore* dynamicStringsStore;
+
+/**
+ * Updates of added strings not posted yet, merged until the end of the coalescing interval. Guarded by pendingChangeSetLock.
+ */
+@property (nonatomic, strong) SDLocalizationChangeSet* pendingChangeSet;
+@property (nonatomic, strong) NSLock* pendingChangeSetLock;
+
+/**
+ * Formatters of each thread, by configuration. Formatter properties that have not been set return instances of this pool.
+ */
+@property (nonatomic, strong) GTYFormatterPool* formatterPool;
+
+/**
+ * The formatting preferences saved in user defaults, read once and then refreshed by key-value observation of their keys only, so that other writes to user defaults cost nothing.
+ */
+@property (atomic, strong) SDFormattingSettings* formattingSettings;
+@property (nonatomic, strong) NSLock* formattingSettingsLock;
+
+/**
+ * Serial queue on which user defaults are synchronized. Writes are counted, so that only the last one of a burst schedules the synchronization.
+ */
+@property (nonatomic, strong) dispatch_queue_t settingsQueue;
+@property (atomic, assign) BOOL hasUnsynchronizedSettings;
+
+/**
+ * Version of the formatting settings applied to userDefaultCalendar.
+ */
+@property (nonatomic, assign) NSUInteger userDefaultCalendarSettingsVersion;
+
+#if GLOTTY_UIKIT
+/**
+ * Resolved paths of localized images by localization, name and extensions tried, with NSNull for images not found.
+ */
+@property (nonatomic, strong) NSMutableDictionary<NSString*, id>* localizedImagePaths;
+@property (nonatomic, strong) NSLock* localizedImagePathsLock;
+
+/**
+ * Decoded localized images by path, within imageCacheByteLimit.
+ */
+@property (nonatomic, strong) GTYLRUCache<NSString*, UIImage*>* imageCache;
+#endif
+
 @end
 
 @implementation SDLocalizationManager
+{
+    // counters of SDLocalizationStatistics, updated without locks
+    _Atomic(uint64_t) _counters[SDLocalizationCounterCount];
+    _Atomic(uint64_t) _traceSequence;
+    // residency clock: advanced when a merged table is published, read by lookups to mark the tables they use
+    _Atomic(uint64_t) _residencyTick;
+    // writes of settings, incremented from any thread: see settingsQueue
+    _Atomic(NSUInteger) _settingsWriteCount;
+}
 
 #pragma mark - Singleton Pattern
 + (instancetype) sharedManager
@@ -154,6 +351,30 @@ UIImage* SDLocalizedImageWithNameAndExtension(NSString * key, NSString *type)
         
         _defaultLocale = nil;
         _selectedLocale = nil;
+        _dataSourceLock = [NSRecursiveLock new];
+        _preparedDataSources = [NSMutableSet set];
+        _pendingChangeSetLock = [NSLock new];
+        _notificationCoalescingInterval = kDefaultNotificationCoalescingInterval;
+        _tableLoadingLocks = [NSMutableDictionary new];
+        _tableLoadingLockUsers = [NSCountedSet new];
+        _formatterPool = [GTYFormatterPool new];
+        _supportedLocalesByIdentifier = [NSMutableDictionary new];
+        _localeMatcher = [GTYLocaleMatcher new];
+        _supportedLocalesLock = [NSLock new];
+        _formattingSettingsLock = [NSLock new];
+        _settingsQueue = dispatch_queue_create("com.sysdata.glotty.settings", DISPATCH_QUEUE_SERIAL);
+#if GLOTTY_UIKIT
+        _localizedImagePaths = [NSMutableDictionary new];
+        _localizedImagePathsLock = [NSLock new];
+        _imageCache = [[GTYLRUCache alloc] initWithTotalCostLimit:kDefaultImageCacheByteLimit];
+        [[NSNotificationCenter defaultCenter] addObserver:self selector:@selector(removeCachedImagesAndPaths) name:UIApplicationDidReceiveMemoryWarningNotification object:nil];
+        [[NSNotificationCenter defaultCenter] addObserver:self selector:@selector(unloadTables) name:UIApplicationDidReceiveMemoryWarningNotification object:nil];
+#endif
+        [self refreshFormattingSettings];
+        for (NSString* key in kFormattingSettingsKeys)
+        {
+            [[NSUserDefaults standardUserDefaults] addObserver:self forKeyPath:key options:0 context:SDFormattingSettingsContext];
+        }
         _allowsOnlyLocalesAvailableOnSystem = YES;
         [[NSNotificationCenter defaultCenter] addObserver:self selector:@selector(resetTimeZone) name:NSSystemTimeZoneDidChangeNotification object:nil];
         
@@ -162,7 +383,12 @@ UIImage* SDLocalizedImageWithNameAndExtension(NSString * key, NSString *type)
         {
             self.pathForDynamicStrings = path;
         }
-        
+        _dynamicStringsStore = [[GTYDynamicStringsStore alloc] initWithDirectoryPath:self.pathForDynamicStrings];
+#if GLOTTY_UIKIT
+        // pending settings and added strings are written before the app may be terminated
+        [[NSNotificationCenter defaultCenter] addObserver:self selector:@selector(flushPendingWrites) name:UIApplicationDidEnterBackgroundNotification object:nil];
+        [[NSNotificationCenter defaultCenter] addObserver:self selector:@selector(flushPendingWrites) name:UIApplicationWillTerminateNotification object:nil];
+#endif
     }
     return self;
 }
@@ -170,6 +396,10 @@ UIImage* SDLocalizedImageWithNameAndExtension(NSString * key, NSString *type)
 - (void)dealloc
 {
     [[NSNotificationCenter defaultCenter] removeObserver:self];
+    for (NSString* key in kFormattingSettingsKeys)
+    {
+        [[NSUserDefaults standardUserDefaults] removeObserver:self forKeyPath:key context:SDFormattingSettingsContext];
+    }
 }
 
 #pragma mark - SDLoggerModuleProtocol
@@ -197,49 +427,137 @@ UIImage* SDLocalizedImageWithNameAndExtension(NSString * key, NSString *type)
 - (void)resetTimeZone
 {
     [NSTimeZone resetSystemTimeZone];
+    // the calendar and the pooled formatters without an explicit zone keep the one they were created with
+    self.userDefaultCalendar = nil;
+    [self.formatterPool invalidate];
+}
+
+- (void)observeValueForKeyPath:(NSString *)keyPath ofObject:(id)object change:(NSDictionary<NSKeyValueChangeKey, id> *)change context:(void *)context
+{
+    if (context == SDFormattingSettingsContext)
+    {
+        [self refreshFormattingSettings];
+    }
+    else
+    {
+        [super observeValueForKeyPath:keyPath ofObject:object change:change context:context];
+    }
+}
+
+
+#pragma mark - Persistence
+
+/**
+ * Saves the given value in user defaults, which are synchronized later on a background queue. Nothing is written if the value did not change.
+ */
+- (void) setPersistentObject:(id)object forKey:(NSString*)key
+{
+    NSUserDefaults* userDefaults = [NSUserDefaults standardUserDefaults];
+    id currentObject = [userDefaults objectForKey:key];
+    if (currentObject == object || [currentObject isEqual:object])
+    {
+        return;
+    }
+    
+    // the value is immediately visible to readers of user defaults, while the disk write is debounced; formatting settings are refreshed by their observation
+    [userDefaults setObject:object forKey:key];
+    
+    self.hasUnsynchronizedSettings = YES;
+    NSUInteger writeCount = atomic_fetch_add(&_settingsWriteCount, 1) + 1;
+    dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(kSettingsSynchronizationDelay * NSEC_PER_SEC)), self.settingsQueue, ^{
+        if (atomic_load(&self->_settingsWriteCount) == writeCount)
+        {
+            [self synchronizeSettings];
+        }
+    });
+}
+
+/**
+ * Must be called on settingsQueue.
+ */
+- (void) synchronizeSettings
+{
+    if (self.hasUnsynchronizedSettings)
+    {
+        self.hasUnsynchronizedSettings = NO;
+        [[NSUserDefaults standardUserDefaults] synchronize];
+    }
+}
+
+- (void) flushPendingWrites
+{
+    dispatch_sync(self.settingsQueue, ^{
+        [self synchronizeSettings];
+    });
+    [self.dynamicStringsStore flush];
 }
 
 #pragma mark - Selected Locale & Default Locale
 
 - (void) setSelectedLocaleWithIdentifier:(NSString *)identifier persistingSelection:(BOOL)persisting
 {
-    if ([self.selectedLocale.localeIdentifier isEqualToString:identifier])
+    // Verify if the past locale is supported
+    NSLocale *locale = [self supportedLocaleWithIdentifier:identifier];
+    // an identifier matched to the selected locale, e.g. "it-IT" for "it", does not change it
+    if (locale && [self.selectedLocale.localeIdentifier isEqualToString:locale.localeIdentifier])
     {
         SDLogModuleVerbose(kLocalizationManagerLogModuleName, @"The selected locale did not change: %@", identifier);
+        // an asynchronous switch still in progress would select another locale
+        [self.dataSourceLock lock];
+        self.localeSwitchSequence++;
+        [self.dataSourceLock unlock];
         if (persisting)
         {
-            [[NSUserDefaults standardUserDefaults] setObject:identifier forKey:USER_DEF_LOCALE_KEY];
-            [[NSUserDefaults standardUserDefaults] synchronize];
+            [self setPersistentObject:identifier forKey:USER_DEF_LOCALE_KEY];
         }
         return;
     }
     
-    // Verify if the past locale is supported
-    NSLocale *locale = [self supportedLocaleWithIdentifier:identifier];
     if (locale)
     {
+        uint64_t start = SDCurrentNanoseconds();
+#if SD_SIGNPOSTS
+        os_signpost_id_t signpostID = 0;
+        if (self.traceSamplingInterval > 0)
+        {
+            if (@available(iOS 12.0, *))
+            {
+                signpostID = os_signpost_id_generate(SDSignpostLog());
+                os_signpost_interval_begin(SDSignpostLog(), signpostID, "LocaleSwitch", "%{public}@", identifier);
+            }
+        }
+#endif
+
         // save selected locale only if requested
-        _selectedLocale = locale;
+        self.selectedLocale = locale;
         if (persisting)
         {
-            [[NSUserDefaults standardUserDefaults] setObject:identifier forKey:USER_DEF_LOCALE_KEY];
-            [[NSUserDefaults standardUserDefaults] synchronize];
+            [self setPersistentObject:identifier forKey:USER_DEF_LOCALE_KEY];
         }
         
         SDLogModuleVerbose(kLocalizationManagerLogModuleName, @"New locale selected: %@", locale.localeIdentifier);
         
-        // If the manager adopts no-standard locales and is a no-standard locale, ask the delegate the standard fee
-        self.correspondingStandardLocale = nil;
-        if (!self.allowsOnlyLocalesAvailableOnSystem && ![NSLocale isLocaleIdentifierAvailableOnSystem:identifier])
-        {
-            [self setupCorrespondingStandardLocaleFromIdentifier:identifier];
-        }
+        self.correspondingStandardLocale = [self correspondingStandardLocaleForIdentifier:identifier];
         
-        // reinit label structure
-        [self resetLocalizedTables];
+        // reinit label structure, keeping the tables already loaded for the locales still in use
+        [self resetLocalizedTablesKeepingLoadedLocales:YES];
         
         // reset formatters
         [self resetFormattersAndCalendars];
+        
+        uint64_t duration = SDCurrentNanoseconds() - start;
+        [self incrementCounter:SDLocalizationCounterLocaleSwitches by:1];
+        [self incrementCounter:SDLocalizationCounterLocaleSwitchNanoseconds by:duration];
+        if (self.traceSamplingInterval > 0)
+        {
+            SDLogModuleVerbose(kLocalizationManagerLogModuleName, @"Locale switch to %@ took %.3f ms", identifier, duration / (double)NSEC_PER_MSEC);
+#if SD_SIGNPOSTS
+            if (@available(iOS 12.0, *))
+            {
+                os_signpost_interval_end(SDSignpostLog(), signpostID, "LocaleSwitch");
+            }
+#endif
+        }
     }
     else
     {
@@ -249,13 +567,25 @@ UIImage* SDLocalizedImageWithNameAndExtension(NSString * key, NSString *type)
 
 - (void) resetLocalizedTables
 {
-    self.dataSource = [SDLocalizationDataSource new];
-    self.dataSource.selectedLocale.languageID = [self ISOSelectedLocale].languageID;
-    self.dataSource.baseLocale.languageID = [self ISOSelectedLocale].baseLanguageLocale.languageID;
-    self.dataSource.defaultLocale.languageID = self.defaultLocale.languageID;
+    [self resetLocalizedTablesKeepingLoadedLocales:NO];
+}
+
+- (void) resetLocalizedTablesKeepingLoadedLocales:(BOOL)keepLoadedLocales
+{
+    [self.dataSourceLock lock];
+    NSArray* languageIDs = [self.localeMatcher fallbackChainForIdentifier:[self ISOSelectedLocale].localeIdentifier defaultIdentifier:self.defaultLocale.localeIdentifier];
+    SDLogModuleVerbose(kLocalizationManagerLogModuleName, @"Localization fallback chain: %@", [languageIDs componentsJoinedByString:@" > "]);
+    self.dataSource = [[SDLocalizationDataSource alloc] initWithLanguageIDs:languageIDs reusingLocalesOfDataSource:(keepLoadedLocales ? self.dataSource : nil)];
+    self.localeSwitchSequence++;
+    [self.dataSourceLock unlock];
+    
+#if GLOTTY_UIKIT
+    // images of the previous locale are not needed anymore, while resolved paths are kept by localization
+    [self removeCachedImages];
+#endif
     
     // fire the notification
-    [[NSNotificationCenter defaultCenter] postNotificationName:SDLocalizationManagerLanguageDidChangeNotification object:self.selectedLocale];
+    [self postLanguageDidChangeNotification];
 }
 
 - (void)setSelectedLocaleWithIdentifier:(NSString *)identifier
@@ -263,6 +593,109 @@ UIImage* SDLocalizedImageWithNameAndExtension(NSString * key, NSString *type)
     [self setSelectedLocaleWithIdentifier:identifier persistingSelection:YES];
 }
 
+- (void) setSelectedLocaleWithIdentifier:(NSString*)identifier preloadingTablesWithNames:(NSArray<NSString*>*)tableNames inBundleForClass:(Class)bundleClass completion:(void (^)(BOOL selected))completion
+{
+    [self setSelectedLocaleWithIdentifier:identifier persistingSelection:YES preloadingTablesWithNames:tableNames inBundleForClass:bundleClass completion:completion];
+}
+
+/**
+ * Asynchronous locale switch: a new data source is prepared on a background queue, while the current one keeps serving lookups, and then swapped in on the main queue.
+ */
+- (void) setSelectedLocaleWithIdentifier:(NSString*)identifier persistingSelection:(BOOL)persisting preloadingTablesWithNames:(NSArray<NSString*>*)tableNames inBundleForClass:(Class)bundleClass completion:(void (^)(BOOL selected))completion
+{
+    NSLocale* locale = [self supportedLocaleWithIdentifier:identifier];
+    if (!locale || [self.selectedLocale.localeIdentifier isEqualToString:locale.localeIdentifier])
+    {
+        // nothing to prepare: the synchronous switch logs the error or persists the selection, superseding pending switches
+        [self setSelectedLocaleWithIdentifier:identifier persistingSelection:persisting];
+        if (completion)
+        {
+            BOOL selected = locale != nil;
+            dispatch_async(dispatch_get_main_queue(), ^{
+                completion(selected);
+            });
+        }
+        return;
+    }
+    
+    uint64_t start = SDCurrentNanoseconds();
+    // the delegate is asked for the standard locale on the calling thread, as by the synchronous switch
+    NSLocale* standardLocale = [self correspondingStandardLocaleForIdentifier:identifier];
+    NSLocale* isoLocale = standardLocale ?: locale;
+    NSBundle* bundle = [self bundleForClass:bundleClass];
+    
+    [self.dataSourceLock lock];
+    NSUInteger sequence = ++self.localeSwitchSequence;
+    NSArray* languageIDs = [self.localeMatcher fallbackChainForIdentifier:isoLocale.localeIdentifier defaultIdentifier:self.defaultLocale.localeIdentifier];
+    // locales still in use are shared with the current data source, together with their loaded tables
+    SDLocalizationDataSource* dataSource = [[SDLocalizationDataSource alloc] initWithLanguageIDs:languageIDs reusingLocalesOfDataSource:self.dataSource];
+    [self.preparedDataSources addObject:dataSource];
+    [self.dataSourceLock unlock];
+    SDLogModuleVerbose(kLocalizationManagerLogModuleName, @"Preparing locale %@, fallback chain: %@", identifier, [languageIDs componentsJoinedByString:@" > "]);
+    
+    dispatch_queue_t queue = dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0);
+    dispatch_async(queue, ^{
+        NSArray<NSString*>* names = tableNames ?: [self availableTableNamesInBundle:bundle dataSource:dataSource];
+        dispatch_apply(names.count, queue, ^(size_t index) {
+            NSString* table = [names[index] stringByReplacingOccurrencesOfString:@".strings" withString:@""];
+            [self resolvedTableWithName:table inBundle:bundle dataSource:dataSource];
+        });
+        [self warmFormattersForLocale:isoLocale];
+        
+        dispatch_async(dispatch_get_main_queue(), ^{
+            BOOL selected = [self swapInLocale:locale identifier:identifier standardLocale:standardLocale dataSource:dataSource sequence:sequence persisting:persisting];
+            if (selected)
+            {
+                uint64_t duration = SDCurrentNanoseconds() - start;
+                [self incrementCounter:SDLocalizationCounterLocaleSwitches by:1];
+                [self incrementCounter:SDLocalizationCounterLocaleSwitchNanoseconds by:duration];
+                if (self.traceSamplingInterval > 0)
+                {
+                    SDLogModuleVerbose(kLocalizationManagerLogModuleName, @"Asynchronous locale switch to %@ took %.3f ms", identifier, duration / (double)NSEC_PER_MSEC);
+                }
+            }
+            if (completion)
+            {
+                completion(selected);
+            }
+        });
+    });
+}
+
+/**
+ * Publishes the locale and the data source prepared by an asynchronous switch, then resets formatters and posts SDLocalizationManagerLanguageDidChangeNotification.
+ *
+ * @return NO if another switch started after the given one, which is dropped.
+ */
+- (BOOL) swapInLocale:(NSLocale*)locale identifier:(NSString*)identifier standardLocale:(NSLocale*)standardLocale dataSource:(SDLocalizationDataSource*)dataSource sequence:(NSUInteger)sequence persisting:(BOOL)persisting
+{
+    [self.dataSourceLock lock];
+    [self.preparedDataSources removeObject:dataSource];
+    if (self.localeSwitchSequence != sequence)
+    {
+        [self.dataSourceLock unlock];
+        SDLogModuleVerbose(kLocalizationManagerLogModuleName, @"Locale switch to %@ superseded by a later one", identifier);
+        return NO;
+    }
+    self.dataSource = dataSource;
+    self.selectedLocale = locale;
+    self.correspondingStandardLocale = standardLocale;
+    [self.dataSourceLock unlock];
+    
+    if (persisting)
+    {
+        [self setPersistentObject:identifier forKey:USER_DEF_LOCALE_KEY];
+    }
+    SDLogModuleVerbose(kLocalizationManagerLogModuleName, @"New locale selected: %@", locale.localeIdentifier);
+    
+    [self resetFormattersAndCalendars];
+#if GLOTTY_UIKIT
+    [self removeCachedImages];
+#endif
+    [self postLanguageDidChangeNotification];
+    return YES;
+}
+
 - (BOOL)isLocaleWithIdentifierSelected:(NSString *)identifier
 {
     return [self.selectedLocale.localeIdentifier isEqualToString:identifier];
@@ -277,32 +710,37 @@ UIImage* SDLocalizedImageWithNameAndExtension(NSString * key, NSString *type)
     }
     
     NSLocale *locale = [NSLocale localeWithLocaleIdentifier:identifier];
-    _defaultLocale = locale;
+    self.defaultLocale = locale;
     SDLogModuleVerbose(kLocalizationManagerLogModuleName, @"Default Locale setted to %@", identifier);
 }
 
-- (void) setupCorrespondingStandardLocaleFromIdentifier:(NSString*)identifier
+/**
+ * Returns the standard locale to use for localization and formatting when the locale with the given identifier is not an ISO standard, or nil if it is.
+ *
+ * If the manager adopts no-standard locales, the delegate is asked for the standard locale; the default locale is used if it does not answer or answers with an invalid one.
+ */
+- (NSLocale*) correspondingStandardLocaleForIdentifier:(NSString*)identifier
 {
+    if (self.allowsOnlyLocalesAvailableOnSystem || [NSLocale isLocaleIdentifierAvailableOnSystem:identifier])
+    {
+        return nil;
+    }
+    
     if ([self.delegate respondsToSelector:@selector(ISOLocaleIdentifierForNonStandardLocale:)])
     {
         NSString *standardLocale = [self.delegate ISOLocaleIdentifierForNonStandardLocale:identifier];
-        self.correspondingStandardLocale = [NSLocale localeWithLocaleIdentifier:standardLocale];
+        NSLocale* correspondingStandardLocale = [NSLocale localeWithLocaleIdentifier:standardLocale];
         
         // Verify that the indicated locale is valid and standard
-        if (![NSLocale isLocaleIdentifierAvailableOnSystem:standardLocale] || !self.correspondingStandardLocale)
+        if (![NSLocale isLocaleIdentifierAvailableOnSystem:standardLocale] || !correspondingStandardLocale)
         {
             SDLogModuleError(kLocalizationManagerLogModuleName, @"The indicated standard locale (%@) is not valid. Fallback to default", standardLocale);
-            self.correspondingStandardLocale = self.defaultLocale;
-        }
-        else
-        {
-            SDLogModuleVerbose(kLocalizationManagerLogModuleName, @"New standard locale %@ indicated for the non standard locale %@", standardLocale, identifier);
+            return self.defaultLocale;
         }
+        SDLogModuleVerbose(kLocalizationManagerLogModuleName, @"New standard locale %@ indicated for the non standard locale %@", standardLocale, identifier);
+        return correspondingStandardLocale;
     }
-    else
-    {
-        self.correspondingStandardLocale = self.defaultLocale;
-    }
+    return self.defaultLocale;
 }
 
 - (NSLocale*)ISOSelectedLocale
@@ -328,6 +766,13 @@ UIImage* SDLocalizedImageWithNameAndExtension(NSString * key, NSString *type)
         [self addSupportedLocale:supportedLocale];
     }
     
+    // precompute the matching table once, and forget the results of the previous one
+    GTYLocaleMatcher* localeMatcher = [[GTYLocaleMatcher alloc] initWithSupportedIdentifiers:self.locales.array];
+    [self.supportedLocalesLock lock];
+    self.localeMatcher = localeMatcher;
+    [self.supportedLocalesByIdentifier removeAllObjects];
+    [self.supportedLocalesLock unlock];
+    
     if (self.locales.count > 0)
     {
         // if the defaultLocale has not yet been set from the outside
@@ -427,8 +872,7 @@ UIImage* SDLocalizedImageWithNameAndExtension(NSString * key, NSString *type)
         {
             // if it does not delete the setting from the user defaults and refit the setupLocalization
             SDLogModuleVerbose(kLocalizationManagerLogModuleName, @"Saved preferred language is not supported anymore: %@", preferredLangCode);
-            [userDefaults removeObjectForKey:USER_DEF_LOCALE_KEY];
-            [userDefaults synchronize];
+            [self setPersistentObject:nil forKey:USER_DEF_LOCALE_KEY];
             [self setupLocalization];
         }
         else
@@ -440,31 +884,14 @@ UIImage* SDLocalizedImageWithNameAndExtension(NSString * key, NSString *type)
     // if there are no saved settings
     else
     {
-        NSArray* soLanguages = [NSLocale preferredLanguages];
-        
-        // language loop for the operating system
-        for (NSString *soLanguage in soLanguages)
+        // a single walk of the languages of the operating system, matching each of them by language, script and region
+        NSString* soLanguage = nil;
+        NSString* supportedIdentifier = [self.localeMatcher bestSupportedIdentifierForIdentifiers:[NSLocale preferredLanguages] matchedIdentifier:&soLanguage];
+        if (supportedIdentifier)
         {
-            // if the language is supported then set as selectedLocale
-            if ([self supportsLocaleWithIdentifier:soLanguage])
-            {
-                SDLogModuleVerbose(kLocalizationManagerLogModuleName, @"User language supported: %@", soLanguage);
-                [self setSelectedLocaleWithIdentifier:soLanguage persistingSelection:NO];
-                return;
-            }
-            // else verifies if the app supports the basic language version
-            else
-            {
-                NSLocale *locale = [NSLocale localeWithLocaleIdentifier:soLanguage];
-                
-                // if the base language is supported the set as selectedLocale
-                if ([self supportsLocaleWithIdentifier:locale.languageCode])
-                {
-                    SDLogModuleVerbose(kLocalizationManagerLogModuleName, @"User language not supported, but is supported his generic version: %@", locale.languageCode);
-                    [self setSelectedLocaleWithIdentifier:locale.languageCode persistingSelection:NO];
-                    return;
-                }
-            }
+            SDLogModuleVerbose(kLocalizationManagerLogModuleName, @"User language %@ supported as %@", soLanguage, supportedIdentifier);
+            [self setSelectedLocaleWithIdentifier:supportedIdentifier persistingSelection:NO];
+            return;
         }
         
         // if I still do not have a selectedLocale then I choose the defaultLocale
@@ -482,26 +909,37 @@ UIImage* SDLocalizedImageWithNameAndExtension(NSString * key, NSString *type)
 
 - (NSLocale *)supportedLocaleWithIdentifier:(NSString *)identifier
 {
-    NSLocale *locale = [NSLocale localeWithLocaleIdentifier:identifier];
-    
-    if (locale.languageCode.length == 0)
+    if (!identifier)
     {
         return nil;
     }
     
-    if ([self.locales containsObject:locale.localeIdentifier])
+    // memoized: repeated checks are a hash lookup returning always the same locale instance
+    [self.supportedLocalesLock lock];
+    id memo = self.supportedLocalesByIdentifier[identifier];
+    GTYLocaleMatcher* localeMatcher = self.localeMatcher;
+    [self.supportedLocalesLock unlock];
+    if (memo)
     {
-        return locale;
+        return memo == [NSNull null] ? nil : memo;
     }
-    else
+    
+    NSLocale *locale = [self resolveSupportedLocaleWithIdentifier:identifier matcher:localeMatcher];
+    
+    [self.supportedLocalesLock lock];
+    // the supported locales may have changed while matching: the result of the old ones is not memoized
+    if (self.localeMatcher == localeMatcher)
     {
-        NSLocale *baseLocale = locale.baseLanguageLocale;
-        if ([self.locales containsObject:baseLocale.localeIdentifier])
-        {
-            return baseLocale;
-        }
-        return nil;
+        self.supportedLocalesByIdentifier[identifier] = locale ?: [NSNull null];
     }
+    [self.supportedLocalesLock unlock];
+    return locale;
+}
+
+- (NSLocale *)resolveSupportedLocaleWithIdentifier:(NSString *)identifier matcher:(GTYLocaleMatcher*)localeMatcher
+{
+    NSString *supportedIdentifier = [localeMatcher bestSupportedIdentifierForIdentifier:identifier];
+    return supportedIdentifier ? [NSLocale localeWithLocaleIdentifier:supportedIdentifier] : nil;
 }
 
 #pragma mark - Display Names
@@ -597,19 +1035,26 @@ UIImage* SDLocalizedImageWithNameAndExtension(NSString * key, NSString *type)
 
 - (NSString *)localizedKey:(NSString *)key fromTable:(NSString *)tableName placeholderDictionary:(NSDictionary<NSString*, NSString*> *)placeholderDictionary withDefaultValue:(NSString *)defaultValue
 {
-    NSString* localizedString = [self localizedKey:key fromTable:tableName withDefaultValue:defaultValue];
-    
-    if (placeholderDictionary && localizedString)
+    if (placeholderDictionary.count > 0 && self.selectedLocale)
     {
-        for (NSString* key in placeholderDictionary.allKeys)
+        // the value is parsed once per table and set of placeholders, then each call only renders it
+        NSString* table = [tableName stringByReplacingOccurrencesOfString:@".strings" withString:@""];
+        SDResolvedTable* resolvedTable = [self resolvedTableWithName:table inBundle:[NSBundle mainBundle]];
+        GTYStringTemplate* template = [resolvedTable templateForKey:key placeholderDictionary:placeholderDictionary];
+        if (template)
         {
-            NSString* replacer = [placeholderDictionary objectForKey:key];
-            if (replacer)
-            {
-                localizedString = [localizedString stringByReplacingOccurrencesOfString:key withString:replacer];
-            }
+            [self recordLookupOfKey:key inTable:resolvedTable counter:[resolvedTable lookupCounterForKey:key]];
+            return [template stringWithPlaceholderDictionary:placeholderDictionary];
         }
     }
+    
+    NSString* localizedString = [self localizedKey:key fromTable:tableName withDefaultValue:defaultValue];
+    
+    if (placeholderDictionary.count > 0 && localizedString)
+    {
+        GTYStringTemplate* template = [[GTYStringTemplate alloc] initWithString:localizedString placeholders:placeholderDictionary.allKeys];
+        localizedString = [template stringWithPlaceholderDictionary:placeholderDictionary];
+    }
     return localizedString;
 }
 
@@ -636,267 +1081,1170 @@ UIImage* SDLocalizedImageWithNameAndExtension(NSString * key, NSString *type)
         return value;
     }
     
-    NSString* localizedString;
-    
-    // procedendo prima nella struttura in memoria e poi nel file system
-    // cerco prima nella lingua selezionata
-    NSString* selectedLang = self.dataSource.selectedLocale.languageID;
-    if(selectedLang)
+    // the merged table answers with the value of the first tier that contains the key
+    SDResolvedTable* resolvedTable = [self resolvedTableWithName:table inBundle:bundle];
+    SDLocalizationCounter counter;
+    NSString* localizedString = [resolvedTable stringForKey:key counter:&counter];
+    if (localizedString)
     {
-        localizedString = [self retrieveLocalizedStringForKey:key locale:self.dataSource.selectedLocale inBundle:bundle andTableName:table];
-        if(localizedString)
-        {
-            return localizedString;
-        }
+        [self recordLookupOfKey:key inTable:resolvedTable counter:counter];
+        return localizedString;
     }
     
-    
-    // if I did not find anything I would look for in any basic locale
-    NSString* baseLang = self.dataSource.baseLocale.languageID;
-    if (![baseLang isEqualToString:selectedLang])
+    // no matches were found.
+    if (defaultValue)
     {
-        localizedString = [self retrieveLocalizedStringForKey:key locale:self.dataSource.baseLocale inBundle:bundle andTableName:table];
-        if(localizedString)
-        {
-            return localizedString;
-        }
+        [self incrementCounter:SDLocalizationCounterDefaultValueReturns by:1];
+        SDLogModuleWarning(kLocalizationManagerLogModuleName, @"No localized value found for given key (%@) in table %@. The default value will be returned: %@", key, table, defaultValue);
+        return defaultValue;
+    }
+    else
+    {
+        [self incrementCounter:SDLocalizationCounterKeyReturns by:1];
+        SDLogModuleError(kLocalizationManagerLogModuleName, @"No localized value found for given key (%@) in table %@. The key will be returned.", key, table);
+        return key;
+    }
+}
+
+- (NSBundle*)bundleForClass:(Class)clazz
+{
+    if (!clazz)
+    {
+        return [NSBundle mainBundle];
+    }
+    NSBundle* bundle = [NSBundle bundleForClass:clazz];
+    bundle = bundle ?: [NSBundle mainBundle];
+    return bundle;
+}
+
+- (NSArray*) arrayOfLocalizedStringsWithPrefix:(NSString *)prefix
+{
+    if (self.selectedLocale)
+    {
+        // the keys "<prefix>.<n>" are found with a single scan of the key index, then read in order until the first gap
+        NSString* keyPrefix = [prefix stringByAppendingString:@"."];
+        SDResolvedTable* resolvedTable = [self resolvedTableWithName:@"Localizable" inBundle:[NSBundle mainBundle]];
+        NSMutableDictionary<NSNumber*, NSString*>* valuesByIndex = [NSMutableDictionary dictionary];
+        NSCharacterSet* nonDigits = [[NSCharacterSet decimalDigitCharacterSet] invertedSet];
+        for (NSString* key in [resolvedTable keysWithPrefix:keyPrefix])
+        {
+            // longer suffixes would saturate integerValue, mapping different keys to the same index
+            NSString* suffix = [key substringFromIndex:keyPrefix.length];
+            if (suffix.length > 0 && suffix.length <= kMaxArrayIndexDigits && [suffix rangeOfCharacterFromSet:nonDigits].location == NSNotFound && ([suffix isEqualToString:@"0"] || ![suffix hasPrefix:@"0"]))
+            {
+                valuesByIndex[@(suffix.integerValue)] = [resolvedTable stringForKey:key];
+            }
+        }
+        
+        NSMutableArray* array = [NSMutableArray arrayWithCapacity:valuesByIndex.count];
+        for (NSInteger counter = 0; valuesByIndex[@(counter)]; counter++)
+        {
+            [array addObject:valuesByIndex[@(counter)]];
+        }
+        return [NSArray arrayWithArray:array];
+    }
+    
+    NSMutableArray* array = [NSMutableArray arrayWithCapacity:0];
+    int counter = 0;
+    NSString* name = [NSString stringWithFormat:@"%@.%d", prefix, counter];
+    NSString* value = SDLocalizedString(name);
+    
+    while (![value isEqualToString:name])
+    {
+        [array addObject:value];
+        counter++;
+        name = [NSString stringWithFormat:@"%@.%d", prefix, counter];
+        value = SDLocalizedString(name);
+    }
+    
+    return [NSArray arrayWithArray:array];
+}
+
+#pragma mark - Batch Localized Strings
+
+- (NSDictionary<NSString*, NSString*>*) localizedKeys:(NSArray<NSString*>*)keys
+{
+    return [self localizedKeys:keys fromTable:@"Localizable" inBundleForClass:nil];
+}
+
+- (NSDictionary<NSString*, NSString*>*) localizedKeys:(NSArray<NSString*>*)keys fromTable:(NSString*)tableName inBundleForClass:(Class)bundleClass
+{
+    NSString* table = [tableName stringByReplacingOccurrencesOfString:@".strings" withString:@""];
+    NSMutableDictionary<NSString*, NSString*>* values = [NSMutableDictionary dictionaryWithCapacity:keys.count];
+    
+    // fallback on standard call
+    if (!self.selectedLocale)
+    {
+        for (NSString* key in keys)
+        {
+            values[key] = [self localizedKey:key fromTable:table inBundleForClass:bundleClass withDefaultValue:nil];
+        }
+        return [values copy];
+    }
+    
+    SDResolvedTable* resolvedTable = [self resolvedTableWithName:table inBundle:[self bundleForClass:bundleClass]];
+    NSUInteger missingCount = 0;
+    for (NSString* key in keys)
+    {
+        // each key is counted like a single lookup
+        SDLocalizationCounter counter;
+        NSString* value = [resolvedTable stringForKey:key counter:&counter];
+        if (value)
+        {
+            [self recordLookupOfKey:key inTable:resolvedTable counter:counter];
+        }
+        else
+        {
+            value = key;
+            missingCount++;
+        }
+        values[key] = value;
+    }
+    
+    if (missingCount > 0)
+    {
+        [self incrementCounter:SDLocalizationCounterKeyReturns by:missingCount];
+        SDLogModuleError(kLocalizationManagerLogModuleName, @"No localized value found for %lu keys in table %@. The keys will be returned.", (unsigned long)missingCount, table);
+    }
+    return [values copy];
+}
+
+- (NSDictionary<NSString*, NSDictionary<NSString*, NSString*>*>*) localizedKeysByTable:(NSDictionary<NSString*, NSArray<NSString*>*>*)keysByTable inBundleForClass:(Class)bundleClass
+{
+    NSMutableDictionary* valuesByTable = [NSMutableDictionary dictionaryWithCapacity:keysByTable.count];
+    [keysByTable enumerateKeysAndObjectsUsingBlock:^(NSString* tableName, NSArray<NSString*>* keys, BOOL* stop) {
+        valuesByTable[tableName] = [self localizedKeys:keys fromTable:tableName inBundleForClass:bundleClass];
+    }];
+    return [valuesByTable copy];
+}
+
+- (void) getLocalizedValues:(NSString* __strong *)values forKeys:(NSString* const *)keys count:(NSUInteger)count fromTable:(NSString*)tableName inBundleForClass:(Class)bundleClass
+{
+    NSString* table = [tableName stringByReplacingOccurrencesOfString:@".strings" withString:@""];
+    
+    // fallback on standard call
+    if (!self.selectedLocale)
+    {
+        for (NSUInteger index = 0; index < count; index++)
+        {
+            values[index] = [self localizedKey:keys[index] fromTable:table inBundleForClass:bundleClass withDefaultValue:nil];
+        }
+        return;
+    }
+    
+    SDResolvedTable* resolvedTable = [self resolvedTableWithName:table inBundle:[self bundleForClass:bundleClass]];
+    NSUInteger missingCount = 0;
+    for (NSUInteger index = 0; index < count; index++)
+    {
+        SDLocalizationCounter counter;
+        NSString* value = [resolvedTable stringForKey:keys[index] counter:&counter];
+        if (value)
+        {
+            [self recordLookupOfKey:keys[index] inTable:resolvedTable counter:counter];
+        }
+        else
+        {
+            value = keys[index];
+            missingCount++;
+        }
+        values[index] = value;
+    }
+    
+    if (missingCount > 0)
+    {
+        [self incrementCounter:SDLocalizationCounterKeyReturns by:missingCount];
+        SDLogModuleError(kLocalizationManagerLogModuleName, @"No localized value found for %lu keys in table %@. The keys will be returned.", (unsigned long)missingCount, table);
+    }
+}
+
+#pragma mark - Key IDs
+
+- (NSString*) localizedStringWithKeyID:(uint32_t)keyID key:(NSString*)key keySetHash:(uint32_t)keySetHash fromTable:(NSString*)tableName
+{
+    NSString* table = [tableName stringByReplacingOccurrencesOfString:@".strings" withString:@""];
+    if (self.selectedLocale)
+    {
+        SDResolvedTable* resolvedTable = [self resolvedTableWithName:table inBundle:[NSBundle mainBundle]];
+        GTYStringsPack* pack = resolvedTable.keyIDPack;
+        if (pack && pack.keySetHash == keySetHash)
+        {
+            NSString* value = [resolvedTable stringForKeyID:keyID];
+            if (value)
+            {
+                [self incrementCounter:SDLocalizationCounterKeyIDLookups by:1];
+                return value;
+            }
+        }
+        else if (pack && !resolvedTable.reportedKeySetMismatch)
+        {
+            // reported once per merged table, the lookups keep working by key
+            resolvedTable.reportedKeySetMismatch = YES;
+            SDLogModuleError(kLocalizationManagerLogModuleName, @"The header of key IDs of table %@ does not match its strings packs: keys are looked up as strings. Generate header and packs from the same .strings files.", table);
+        }
+    }
+    
+    // missing values, stale headers and lookups without a selected locale go through the string path
+    return [self localizedKey:key fromTable:table inBundleForClass:nil withDefaultValue:nil];
+}
+
+#pragma mark - Key Queries
+
+- (NSArray<NSString*>*) localizedKeysWithPrefix:(NSString*)prefix fromTable:(NSString*)tableName inBundleForClass:(Class)bundleClass
+{
+    if (!self.selectedLocale)
+    {
+        return @[];
+    }
+    NSString* table = [tableName stringByReplacingOccurrencesOfString:@".strings" withString:@""];
+    return [[self resolvedTableWithName:table inBundle:[self bundleForClass:bundleClass]] keysWithPrefix:prefix];
+}
+
+- (NSArray<NSString*>*) localizedKeysFromKey:(NSString*)fromKey toKey:(NSString*)toKey fromTable:(NSString*)tableName inBundleForClass:(Class)bundleClass
+{
+    if (!self.selectedLocale)
+    {
+        return @[];
+    }
+    NSString* table = [tableName stringByReplacingOccurrencesOfString:@".strings" withString:@""];
+    return [[self resolvedTableWithName:table inBundle:[self bundleForClass:bundleClass]] keysFromKey:fromKey toKey:toKey];
+}
+
+- (NSDictionary<NSString*, NSString*>*) localizedStringsWithPrefix:(NSString*)prefix fromTable:(NSString*)tableName inBundleForClass:(Class)bundleClass
+{
+    if (!self.selectedLocale)
+    {
+        return @{};
+    }
+    NSString* table = [tableName stringByReplacingOccurrencesOfString:@".strings" withString:@""];
+    SDResolvedTable* resolvedTable = [self resolvedTableWithName:table inBundle:[self bundleForClass:bundleClass]];
+    NSArray<NSString*>* keys = [resolvedTable keysWithPrefix:prefix];
+    NSMutableDictionary<NSString*, NSString*>* strings = [NSMutableDictionary dictionaryWithCapacity:keys.count];
+    for (NSString* key in keys)
+    {
+        strings[key] = [resolvedTable stringForKey:key] ?: @"";
+    }
+    return [strings copy];
+}
+
+- (void) enumerateLocalizedKeysAndStringsFromTable:(NSString*)tableName inBundleForClass:(Class)bundleClass usingBlock:(void (^)(NSString* key, NSString* string, BOOL* stop))block
+{
+    if (!self.selectedLocale)
+    {
+        return;
+    }
+    NSString* table = [tableName stringByReplacingOccurrencesOfString:@".strings" withString:@""];
+    SDResolvedTable* resolvedTable = [self resolvedTableWithName:table inBundle:[self bundleForClass:bundleClass]];
+    BOOL stop = NO;
+    for (NSString* key in resolvedTable.sortedKeys)
+    {
+        block(key, [resolvedTable stringForKey:key], &stop);
+        if (stop)
+        {
+            break;
+        }
+    }
+}
+
+/**
+ * Returns the merged table with the given name for the given bundle, building it if needed.
+ *
+ * Tables are loaded holding a lock specific to the merged table, so that lookups of other tables are never blocked by a load, and then published in a new snapshot of the data source.
+ */
+- (SDResolvedTable*) resolvedTableWithName:(NSString*)tableName inBundle:(NSBundle*)bundle
+{
+    NSString* bundleIdentifier = bundle.bundleIdentifier ?: @"";
+    
+    // lock-free path: the table has already been published in the current snapshot
+    SDResolvedTable* resolvedTable = [self.dataSource resolvedTableWithName:tableName bundleIdentifier:bundleIdentifier];
+    if (resolvedTable)
+    {
+        [self markAccessOfTable:resolvedTable];
+        return resolvedTable;
+    }
+    
+    return [self resolvedTableWithName:tableName inBundle:bundle dataSource:nil];
+}
+
+/**
+ * Returns the merged table with the given name of the given data source, building and publishing it if needed.
+ *
+ * @param targetDataSource The data source of the table, nil for the current one. The loading lock is per data source, so a locale being prepared in background never waits for lookups of the current one.
+ */
+- (SDResolvedTable*) resolvedTableWithName:(NSString*)tableName inBundle:(NSBundle*)bundle dataSource:(SDLocalizationDataSource*)targetDataSource
+{
+    SDLocalizationDataSource* dataSource = targetDataSource ?: self.dataSource;
+    NSString* bundleIdentifier = bundle.bundleIdentifier ?: @"";
+    NSString* lockKey = [NSString stringWithFormat:@"%p/%@/%@", dataSource, bundleIdentifier, tableName];
+    NSLock* tableLock = [self acquireLoadingLockWithKey:lockKey];
+    [tableLock lock];
+    
+    // another thread may have built the table while waiting for the lock
+    SDResolvedTable* resolvedTable = [dataSource resolvedTableWithName:tableName bundleIdentifier:bundleIdentifier];
+    if (!resolvedTable)
+    {
+        NSUInteger generation = dataSource.generation;
+        NSMutableArray<SDLocalizationTable*>* tables = [NSMutableArray array];
+        NSMutableArray<NSNumber*>* counters = [NSMutableArray array];
+        NSString* defaultLanguageID = self.defaultLocale.languageID;
+        [dataSource.tiers enumerateObjectsUsingBlock:^(SDLocaleModel* locale, NSUInteger index, BOOL* stop) {
+            SDLocalizationTier tier = index == 0 ? SDLocalizationTierSelected : ([locale.languageID isEqualToString:defaultLanguageID] ? SDLocalizationTierDefault : SDLocalizationTierFallback);
+            [tables addObjectsFromArray:[self tablesWithName:tableName locale:locale tier:tier inBundle:bundle counters:counters]];
+        }];
+        resolvedTable = [self mergedTableWithName:tableName bundleIdentifier:bundleIdentifier tables:tables counters:counters];
+        
+        [self.dataSourceLock lock];
+        // if strings have been added or removed while loading, the merged table may be stale: it serves this lookup only
+        if (dataSource.generation == generation)
+        {
+            resolvedTable.lastAccessTick = atomic_fetch_add_explicit(&_residencyTick, 1, memory_order_relaxed) + 1;
+            [dataSource addResolvedTable:resolvedTable];
+            [self evictTablesOfDataSource:dataSource];
+        }
+        [self.dataSourceLock unlock];
+    }
+    
+    [tableLock unlock];
+    [self relinquishLoadingLock:tableLock withKey:lockKey];
+    return resolvedTable;
+}
+
+/**
+ * Merges the given tables, sorted by precedence.
+ *
+ * Tiers are merged from the highest precedence to the lowest one, adding only the keys not found yet, so that values of the selected locale override those of its fallback chain, down to the default locale. In each tier, dynamic strings override the main bundle, which overrides the given bundle.
+ * The merged entries are copied into a GTYCompactTable, so the strings of the merged table are created only for the keys looked up. Compiled packs are not copied: they are probed in place after the merged entries, which leave out the keys of the packs above them.
+ *
+ * @param counters The lookup counters of the tables. Each merged entry stores the index of its table, so lookups know the counter of the value without another probe.
+ */
+- (SDResolvedTable*) mergedTableWithName:(NSString*)tableName bundleIdentifier:(NSString*)bundleIdentifier tables:(NSArray<SDLocalizationTable*>*)tables counters:(NSArray<NSNumber*>*)counters
+{
+    SDResolvedTable* resolvedTable = [SDResolvedTable new];
+    resolvedTable.name = tableName;
+    resolvedTable.bundleIdentifier = bundleIdentifier;
+    
+    // the content of a table precedes its pack, and the packs above a table shadow its content
+    NSMutableArray<SDLocalizationTable*>* contentTables = [NSMutableArray arrayWithCapacity:tables.count];
+    NSMutableArray<NSNumber*>* contentCounters = [NSMutableArray arrayWithCapacity:tables.count];
+    NSMutableArray<NSArray<GTYStringsPack*>*>* shadowingPacks = [NSMutableArray arrayWithCapacity:tables.count];
+    NSMutableArray<GTYStringsPack*>* packs = [NSMutableArray array];
+    NSMutableArray<NSNumber*>* packCounters = [NSMutableArray array];
+    NSUInteger capacity = 0;
+    [tables enumerateObjectsUsingBlock:^(SDLocalizationTable* table, NSUInteger index, BOOL* stop) {
+        if (table.content.count > 0)
+        {
+            [contentTables addObject:table];
+            [contentCounters addObject:counters[index]];
+            [shadowingPacks addObject:[packs copy]];
+        }
+        if (table.pack)
+        {
+            [packs addObject:table.pack];
+            [packCounters addObject:counters[index]];
+        }
+    }];
+    for (SDLocalizationTable* table in contentTables)
+    {
+        capacity = MAX(capacity, table.content.count);
+    }
+    for (GTYStringsPack* pack in packs)
+    {
+        if (pack.flags & GTYStringsPackFlagResolved)
+        {
+            resolvedTable.keyIDPack = pack;
+            break;
+        }
+    }
+    resolvedTable.packs = [packs copy];
+    resolvedTable.counters = [contentCounters arrayByAddingObjectsFromArray:packCounters];
+    
+    // resolved packs already hold the values of their fallback chain, which shadow strings added to the fallback tiers
+    for (NSUInteger index = 0; index < contentTables.count; index++)
+    {
+        BOOL addedStrings = contentCounters[index].unsignedIntegerValue % SDLocalizationSourceCount == SDLocalizationSourceDynamic;
+        NSUInteger resolvedPackIndex = [shadowingPacks[index] indexOfObjectPassingTest:^BOOL(GTYStringsPack* pack, NSUInteger packIndex, BOOL* stop) {
+            return (pack.flags & GTYStringsPackFlagResolved) != 0;
+        }];
+        if (addedStrings && resolvedPackIndex != NSNotFound)
+        {
+            SDLogModuleWarning(kLocalizationManagerLogModuleName, @"Strings added to a fallback localization of table %@ are shadowed by the values resolved into the strings packs of the selected one: add them to the selected localization.", tableName);
+            break;
+        }
+    }
+    
+    if (contentTables.count == 0)
+    {
+        resolvedTable.content = [NSDictionary new];
+        resolvedTable.sharesContent = YES;
+    }
+    else if (contentTables.count == 1 && shadowingPacks.firstObject.count == 0)
+    {
+        // nothing to merge
+        resolvedTable.content = contentTables.firstObject.content;
+        resolvedTable.sharesContent = YES;
+    }
+    else
+    {
+        GTYCompactTableBuilder* builder = [[GTYCompactTableBuilder alloc] initWithCapacity:capacity];
+        for (NSUInteger index = 0; index < contentTables.count; index++)
+        {
+            // the tiers of a fallback chain are a handful of tables, far below the limit of a source
+            builder.source = (uint8_t)MIN(index, UINT8_MAX);
+            [contentTables[index] addMissingEntriesToBuilder:builder shadowedByPacks:shadowingPacks[index] usingBlock:nil];
+        }
+        resolvedTable.content = [builder build];
+    }
+    return resolvedTable;
+}
+
+/**
+ * Returns the loading lock with the given key, creating it if needed, and counts the caller as one of its users. Every call must be balanced by relinquishLoadingLock:withKey:.
+ */
+- (NSLock*) acquireLoadingLockWithKey:(NSString*)key
+{
+    [self.dataSourceLock lock];
+    NSLock* lock = self.tableLoadingLocks[key];
+    if (!lock)
+    {
+        lock = [NSLock new];
+        self.tableLoadingLocks[key] = lock;
+    }
+    [self.tableLoadingLockUsers addObject:key];
+    [self.dataSourceLock unlock];
+    return lock;
+}
+
+/**
+ * Removes the loading lock with the given key once its last user is done with it, so that locks do not pile up for every table and data source ever loaded.
+ */
+- (void) relinquishLoadingLock:(NSLock*)lock withKey:(NSString*)key
+{
+    [self.dataSourceLock lock];
+    [self.tableLoadingLockUsers removeObject:key];
+    if ([self.tableLoadingLockUsers countForObject:key] == 0 && self.tableLoadingLocks[key] == lock)
+    {
+        [self.tableLoadingLocks removeObjectForKey:key];
+    }
+    [self.dataSourceLock unlock];
+}
+
+/**
+ * Returns the tables with the given name of the given locale, loading them if needed, in order of precedence: dynamic strings, main bundle and given bundle.
+ *
+ * The lookup counter of each returned table is appended to the given array.
+ */
+- (NSArray<SDLocalizationTable*>*) tablesWithName:(NSString*)tableName locale:(SDLocaleModel*)locale tier:(SDLocalizationTier)tier inBundle:(NSBundle*)bundle counters:(NSMutableArray<NSNumber*>*)counters
+{
+    NSMutableArray<SDLocalizationTable*>* tables = [NSMutableArray arrayWithCapacity:3];
+    NSString* localization = locale.languageID;
+    
+    // dynamic content
+    SDLocalizationTable* table = [self tableWithName:tableName inTablesBundle:locale.dynamic locale:locale loader:^SDLocalizationTable *{
+        return [self loadDynamicTableWithName:tableName localization:localization];
+    }];
+    if (table)
+    {
+        [tables addObject:table];
+        [counters addObject:@(SDLocalizationCounterForLookup(tier, SDLocalizationSourceDynamic))];
+    }
+    
+    // main bundle
+    table = [self tableWithName:tableName inTablesBundle:locale.main locale:locale loader:^SDLocalizationTable *{
+        return [self loadTableWithName:tableName fromBundle:[NSBundle mainBundle] localization:localization];
+    }];
+    if (table)
+    {
+        [tables addObject:table];
+        [counters addObject:@(SDLocalizationCounterForLookup(tier, SDLocalizationSourceMainBundle))];
+    }
+    
+    // given bundle, if it is different from main bundle
+    if (![bundle isEqual:[NSBundle mainBundle]])
+    {
+        // create the bundle in data source if needed
+        NSString* bundleIdentifier = bundle.bundleIdentifier ?: @"";
+        [self.dataSourceLock lock];
+        SDTablesBundle* tablesBundle = locale.bundlesById[bundleIdentifier];
+        if (!tablesBundle)
+        {
+            tablesBundle = [SDTablesBundle new];
+            tablesBundle.identifier = bundleIdentifier;
+            locale.bundlesById[bundleIdentifier] = tablesBundle;
+        }
+        [self.dataSourceLock unlock];
+        
+        table = [self tableWithName:tableName inTablesBundle:tablesBundle locale:locale loader:^SDLocalizationTable *{
+            return [self loadTableWithName:tableName fromBundle:bundle localization:localization];
+        }];
+        if (table)
+        {
+            [tables addObject:table];
+            [counters addObject:@(SDLocalizationCounterForLookup(tier, SDLocalizationSourceBundle))];
+        }
+    }
+    
+    return tables;
+}
+
+/**
+ * Returns the table with the given name of the given tables bundle, loading it with the given block if it is neither loaded nor known to be missing.
+ *
+ * The block runs without holding dataSourceLock. Its result is stored only if the tables of the locale were not invalidated in the meantime, through any of the data sources sharing it.
+ */
+- (SDLocalizationTable*) tableWithName:(NSString*)tableName inTablesBundle:(SDTablesBundle*)tablesBundle locale:(SDLocaleModel*)locale loader:(SDLocalizationTable* (^)(void))loader
+{
+    [self.dataSourceLock lock];
+    SDLocalizationTable* table = tablesBundle.tablesByName[tableName];
+    BOOL missing = [tablesBundle.missingTableNames containsObject:tableName];
+    NSUInteger generation = locale.generation;
+    [self.dataSourceLock unlock];
+    if (table || missing)
+    {
+        return table;
+    }
+    
+    table = [self timedLoadOfTableWithName:tableName loader:loader];
+    
+    [self.dataSourceLock lock];
+    if (locale.generation == generation)
+    {
+        if (!table)
+        {
+            [tablesBundle.missingTableNames addObject:tableName];
+        }
+        else if (tablesBundle.tablesByName[tableName])
+        {
+            // loaded in the meantime for another bundle
+            table = tablesBundle.tablesByName[tableName];
+        }
+        else
+        {
+            [tablesBundle addTable:table];
+        }
+    }
+    [self.dataSourceLock unlock];
+    return table;
+}
+
+/**
+ * Runs the given loader, counting the load, its size and its duration.
+ */
+- (SDLocalizationTable*) timedLoadOfTableWithName:(NSString*)tableName loader:(SDLocalizationTable* (^)(void))loader
+{
+    BOOL tracing = self.traceSamplingInterval > 0;
+#if SD_SIGNPOSTS
+    os_signpost_id_t signpostID = 0;
+    if (tracing)
+    {
+        if (@available(iOS 12.0, *))
+        {
+            signpostID = os_signpost_id_generate(SDSignpostLog());
+            os_signpost_interval_begin(SDSignpostLog(), signpostID, "TableLoad", "%{public}@", tableName);
+        }
+    }
+#endif
+    
+    uint64_t start = SDCurrentNanoseconds();
+    SDLocalizationTable* table = loader();
+    uint64_t duration = SDCurrentNanoseconds() - start;
+    if (table)
+    {
+        [self incrementCounter:SDLocalizationCounterTableLoads by:1];
+        [self incrementCounter:SDLocalizationCounterTableLoadBytes by:table.fileByteCount];
+        [self incrementCounter:SDLocalizationCounterTableLoadNanoseconds by:duration];
+    }
+    
+    if (tracing)
+    {
+        SDLogModuleVerbose(kLocalizationManagerLogModuleName, @"Table %@ loaded in %.3f ms (%lu bytes)", tableName, duration / (double)NSEC_PER_MSEC, (unsigned long)table.fileByteCount);
+#if SD_SIGNPOSTS
+        if (@available(iOS 12.0, *))
+        {
+            os_signpost_interval_end(SDSignpostLog(), signpostID, "TableLoad", "%lu bytes", (unsigned long)table.fileByteCount);
+        }
+#endif
+    }
+    return table;
+}
+
+/**
+ * Loads the table of strings added for the given localization.
+ *
+ * @return The loaded table, or nil if no strings were added to the table.
+ */
+- (SDLocalizationTable*) loadDynamicTableWithName:(NSString*)tableName localization:(NSString*)localization
+{
+    if (![self.dynamicStringsStore hasStringsForTable:tableName localization:localization])
+    {
+        return nil;
+    }
+    
+    NSMutableDictionary* dictionary = [self.dynamicStringsStore stringsForTable:tableName localization:localization];
+    if (dictionary.count == 0)
+    {
+        return nil;
+    }
+    SDLocalizationTable* table = [SDLocalizationTable new];
+    table.name = tableName;
+    table.content = dictionary;
+    return table;
+}
+
+/**
+ * Loads a table from the given bundle.
+ *
+ * A compiled strings pack is preferred, since it is mapped instead of parsed. The .strings file is used as fallback, read by GTYStringsParser.
+ *
+ * @return The loaded table, or nil if the bundle does not contain it.
+ */
+- (SDLocalizationTable*) loadTableWithName:(NSString*)tableName fromBundle:(NSBundle*)bundle localization:(NSString*)localization
+{
+    NSString* packPath = [bundle pathForResource:tableName ofType:kStringsPackExtension inDirectory:nil forLocalization:localization];
+    GTYStringsPack* pack = [GTYStringsPack packWithContentsOfFile:packPath];
+    if (pack)
+    {
+        SDLocalizationTable* table = [SDLocalizationTable new];
+        table.name = tableName;
+        table.pack = pack;
+        table.fileByteCount = pack.byteSize;
+        return table;
+    }
+    
+    NSString* bundlePath = [self bundle:bundle pathForTable:tableName localization:localization];
+    if (bundlePath)
+    {
+        NSError* error = nil;
+        NSDictionary* dictionary = [GTYStringsParser compactTableWithContentsOfFile:bundlePath error:&error];
+        if (!dictionary)
+        {
+            // e.g. XML property lists: the generic parser reads anything a .strings file can be
+            SDLogModuleWarning(kLocalizationManagerLogModuleName, @"Table %@ (%@) read with the property list parser: %@", tableName, localization, error.localizedDescription);
+            NSDictionary* propertyList = [NSDictionary dictionaryWithContentsOfFile:bundlePath];
+            dictionary = propertyList ? [GTYCompactTable tableWithStrings:propertyList] : nil;
+        }
+        if (dictionary)
+        {
+            SDLocalizationTable* table = [SDLocalizationTable new];
+            table.name = tableName;
+            table.content = dictionary;
+            table.fileByteCount = (NSUInteger)[[NSFileManager defaultManager] attributesOfItemAtPath:bundlePath error:nil].fileSize;
+            return table;
+        }
+    }
+    return nil;
+}
+
+- (NSString*) bundle:(NSBundle*)bundle pathForTable:(NSString*)tableName localization:(NSString*)localization
+{
+    NSString* path = [bundle pathForResource:tableName ofType:@"strings" inDirectory:nil forLocalization:localization];
+    return path;
+}
+
+#pragma mark - Preloading
+
+- (void) preloadTablesWithNames:(NSArray<NSString*>*)tableNames inBundleForClass:(Class)bundleClass completion:(void (^)(void))completion
+{
+    NSBundle* bundle = [self bundleForClass:bundleClass];
+    dispatch_queue_t queue = dispatch_get_global_queue(QOS_CLASS_UTILITY, 0);
+    dispatch_async(queue, ^{
+        if (self.selectedLocale)
+        {
+            NSArray<NSString*>* names = tableNames ?: [self availableTableNamesInBundle:bundle dataSource:self.dataSource];
+            // tables are loaded in parallel: each one blocks only the lookups of the same table
+            dispatch_apply(names.count, queue, ^(size_t index) {
+                NSString* table = [names[index] stringByReplacingOccurrencesOfString:@".strings" withString:@""];
+                [self resolvedTableWithName:table inBundle:bundle];
+            });
+            SDLogModuleVerbose(kLocalizationManagerLogModuleName, @"Preloaded tables: %@", names);
+        }
+        
+        if (completion)
+        {
+            dispatch_async(dispatch_get_main_queue(), completion);
+        }
+    });
+}
+
+#pragma mark - Loaded tables
+
+/**
+ * Marks the table as used at the current tick of the residency clock. The tick of a table changes at most once per published table, so lookups rarely write.
+ */
+- (void) markAccessOfTable:(SDResolvedTable*)resolvedTable
+{
+    if (self.loadedTablesByteLimit == 0)
+    {
+        return;
+    }
+    uint64_t tick = atomic_load_explicit(&_residencyTick, memory_order_relaxed);
+    if (resolvedTable.lastAccessTick != tick)
+    {
+        resolvedTable.lastAccessTick = tick;
+    }
+}
+
+/**
+ * Unloads the least recently used tables of the given data source beyond loadedTablesByteLimit. Must be called holding dataSourceLock.
+ */
+- (void) evictTablesOfDataSource:(SDLocalizationDataSource*)dataSource
+{
+    NSUInteger byteLimit = self.loadedTablesByteLimit;
+    if (byteLimit == 0)
+    {
+        return;
+    }
+    NSUInteger evictedCount = [dataSource evictTablesToFitByteLimit:byteLimit sharingTablesWithDataSources:[self updatableDataSources]];
+    if (evictedCount > 0)
+    {
+        [self incrementCounter:SDLocalizationCounterTableEvictions by:evictedCount];
+        SDLogModuleVerbose(kLocalizationManagerLogModuleName, @"Unloaded %lu tables to fit %lu bytes", (unsigned long)evictedCount, (unsigned long)byteLimit);
+    }
+}
+
+@synthesize loadedTablesByteLimit = _loadedTablesByteLimit;
+
+- (NSUInteger) loadedTablesByteLimit
+{
+    return _loadedTablesByteLimit;
+}
+
+- (void) setLoadedTablesByteLimit:(NSUInteger)loadedTablesByteLimit
+{
+    [self.dataSourceLock lock];
+    _loadedTablesByteLimit = loadedTablesByteLimit;
+    [self evictTablesOfDataSource:self.dataSource];
+    [self.dataSourceLock unlock];
+}
+
+- (NSUInteger) loadedTablesByteCount
+{
+    [self.dataSourceLock lock];
+    NSUInteger byteCount = [self.dataSource residentByteCount];
+    [self.dataSourceLock unlock];
+    return byteCount;
+}
+
+- (NSUInteger) loadedByteCountOfTableWithName:(NSString*)tableName inBundleForClass:(Class)bundleClass
+{
+    NSString* table = tableName.length > 0 ? tableName : @"Localizable";
+    NSString* bundleIdentifier = [self bundleForClass:bundleClass].bundleIdentifier ?: @"";
+    [self.dataSourceLock lock];
+    NSUInteger byteCount = [self.dataSource residentByteCountOfTableWithName:table bundleIdentifier:bundleIdentifier];
+    [self.dataSourceLock unlock];
+    return byteCount;
+}
+
+- (void) unloadTables
+{
+    // a new data source with the same fallback chain: loads in progress publish their tables in the previous one, which is released
+    [self.dataSourceLock lock];
+    NSArray<NSString*>* languageIDs = [self.dataSource.tiers valueForKey:@"languageID"];
+    self.dataSource = [[SDLocalizationDataSource alloc] initWithLanguageIDs:languageIDs reusingLocalesOfDataSource:nil];
+    [self.dataSourceLock unlock];
+    SDLogModuleVerbose(kLocalizationManagerLogModuleName, @"Unloaded all tables");
+}
+
+/**
+ * Returns the names of all the tables localized in the tiers of the given data source, found in the main bundle, in the given bundle and among added strings.
+ */
+- (NSArray<NSString*>*) availableTableNamesInBundle:(NSBundle*)bundle dataSource:(SDLocalizationDataSource*)dataSource
+{
+    NSMutableSet<NSString*>* names = [NSMutableSet set];
+    NSArray<NSBundle*>* bundles = [bundle isEqual:[NSBundle mainBundle]] ? @[bundle] : @[[NSBundle mainBundle], bundle];
+    for (SDLocaleModel* locale in dataSource.tiers)
+    {
+        for (NSBundle* tablesBundle in bundles)
+        {
+            for (NSString* type in @[@"strings", kStringsPackExtension])
+            {
+                for (NSString* path in [tablesBundle pathsForResourcesOfType:type inDirectory:nil forLocalization:locale.languageID])
+                {
+                    [names addObject:path.lastPathComponent.stringByDeletingPathExtension];
+                }
+            }
+        }
+        [names addObjectsFromArray:[self.dynamicStringsStore tableNamesForLocalization:locale.languageID]];
+    }
+    return names.allObjects;
+}
+
+#pragma mark - Adding strings
+
+- (void) addStrings:(NSDictionary<NSString*, NSString*>*)strings
+{
+    [self addStrings:strings toTableWithName:@"Localizable"];
+}
+
+- (void) addStrings:(NSDictionary<NSString*, NSString*>*)strings toTableWithName:(NSString*)tableName
+{
+    [self addStrings:strings toTableWithName:tableName forLocalization:self.ISOSelectedLocale.languageID];
+}
+
+- (void) addStrings:(NSDictionary<NSString*, NSString*>*)strings toTableWithName:(NSString*)tableName forLocalization:(NSString*)localization
+{
+    // Parameters validation
+    if (!strings)
+    {
+        SDLogModuleError(kLocalizationManagerLogModuleName, @"Passed a nil dictionary of strings to add to table with name %@", tableName);
+        return;
     }
     
-    // last try with the default locale
-    NSString* defaultLang = self.dataSource.defaultLocale.languageID;
-    if (defaultLang.length > 0 && ![defaultLang isEqualToString:selectedLang] &&
-        ![defaultLang isEqualToString:baseLang])
+    if (tableName.length == 0)
     {
-        localizedString = [self retrieveLocalizedStringForKey:key locale:self.dataSource.defaultLocale inBundle:bundle andTableName:table];
-        if(localizedString)
-        {
-            return localizedString;
-        }
+        SDLogModuleError(kLocalizationManagerLogModuleName, @"Invalid table name");
+        return;
     }
     
-    // no matches were found.
-    if (defaultValue)
+    if (localization.length == 0)
     {
-        SDLogModuleWarning(kLocalizationManagerLogModuleName, @"No localized value found for given key (%@) in table %@. The default value will be returned: %@", key, table, defaultValue);
-        return defaultValue;
+        SDLogModuleError(kLocalizationManagerLogModuleName, @"Invalid localization");
+        return;
     }
-    else
+    
+    // the strings are appended to the journal of the table, whose write is grouped with the other ones issued meanwhile
+    [self.dynamicStringsStore addStrings:strings toTable:tableName localization:localization];
+    
+    // only the merged tables that depend on the updated one are rebuilt
+    [self.dataSourceLock lock];
+    for (SDLocalizationDataSource* dataSource in [self updatableDataSources])
     {
-        SDLogModuleError(kLocalizationManagerLogModuleName, @"No localized value found for given key (%@) in table %@. The key will be returned.", key, table);
-        return key;
+        [dataSource addStrings:strings toTableWithName:tableName forLocalization:localization];
     }
+    [self.dataSourceLock unlock];
+    
+    SDLocalizationChangeSet* changeSet = [[SDLocalizationChangeSet alloc] initWithKinds:SDLocalizationChangeKindStringsAdded tableNames:[NSSet setWithObject:tableName] localizations:[NSSet setWithObject:localization] keys:[NSSet setWithArray:strings.allKeys]];
+    [self postStringsDidUpdateNotificationWithChangeSet:changeSet];
 }
 
-- (NSBundle*)bundleForClass:(Class)clazz
+- (void) resetAddedStringsToTableWithName:(NSString*)tableName forLocalization:(NSString*)localization
 {
-    if (!clazz)
+    if (![self.dynamicStringsStore hasStringsForTable:tableName localization:localization])
     {
-        return [NSBundle mainBundle];
+        return;
     }
-    NSBundle* bundle = [NSBundle bundleForClass:clazz];
-    bundle = bundle ?: [NSBundle mainBundle];
-    return bundle;
+    
+    [self.dynamicStringsStore removeStringsForTable:tableName localization:localization];
+    
+    [self.dataSourceLock lock];
+    for (SDLocalizationDataSource* dataSource in [self updatableDataSources])
+    {
+        [dataSource invalidateTableWithName:tableName forLocalization:localization];
+    }
+    [self.dataSourceLock unlock];
+    
+    SDLocalizationChangeSet* changeSet = [[SDLocalizationChangeSet alloc] initWithKinds:SDLocalizationChangeKindStringsReset tableNames:[NSSet setWithObject:tableName] localizations:[NSSet setWithObject:localization] keys:nil];
+    [self postStringsDidUpdateNotificationWithChangeSet:changeSet];
 }
 
-- (NSArray*) arrayOfLocalizedStringsWithPrefix:(NSString *)prefix
+- (void) resetAllAddedStringsForLocalization:(NSString*)localization
 {
-    NSMutableArray* array = [NSMutableArray arrayWithCapacity:0];
-    int counter = 0;
-    NSString* name = [NSString stringWithFormat:@"%@.%d", prefix, counter];
-    NSString* value = SDLocalizedString(name);
+    NSArray<NSString*>* tableNames = [self.dynamicStringsStore tableNamesForLocalization:localization];
+    if (tableNames.count == 0)
+    {
+        return;
+    }
     
-    while (![value isEqualToString:name])
+    [self.dynamicStringsStore removeStringsForLocalization:localization];
+    
+    [self.dataSourceLock lock];
+    for (SDLocalizationDataSource* dataSource in [self updatableDataSources])
     {
-        [array addObject:value];
-        counter++;
-        name = [NSString stringWithFormat:@"%@.%d", prefix, counter];
-        value = SDLocalizedString(name);
+        [dataSource invalidateTablesWithNames:tableNames forLocalization:localization];
     }
+    [self.dataSourceLock unlock];
     
-    return [NSArray arrayWithArray:array];
+    SDLocalizationChangeSet* changeSet = [[SDLocalizationChangeSet alloc] initWithKinds:SDLocalizationChangeKindStringsReset tableNames:[NSSet setWithArray:tableNames] localizations:[NSSet setWithObject:localization] keys:nil];
+    [self postStringsDidUpdateNotificationWithChangeSet:changeSet];
 }
 
-- (NSString*) retrieveLocalizedStringForKey:(NSString*)key locale:(SDLocaleModel*)locale inBundle:(NSBundle*)bundle andTableName:(NSString*)tableName
+- (void) resetAllAddedStrings
 {
-    NSString* localizedValue = nil;
-    // search in dynamic content
-    localizedValue = locale.dynamic.tablesByName[tableName].content[key];
-    if (!localizedValue)
+    NSMutableSet<NSString*>* updatedTableNames = [NSMutableSet set];
+    
+    [self.dataSourceLock lock];
+    // strings added for localizations that are not tiers are not loaded, so only the tiers are invalidated
+    NSArray<SDLocalizationDataSource*>* dataSources = [self updatableDataSources];
+    NSMutableDictionary<NSString*, NSArray<NSString*>*>* tableNamesByLocalization = [NSMutableDictionary dictionary];
+    for (SDLocalizationDataSource* dataSource in dataSources)
     {
-        // try to load dynamic contents from file system
-        NSString* fileSystemPath = [self fileSystemPathForTable:tableName localization:locale.languageID];
-        NSDictionary* dictionary = [NSDictionary dictionaryWithContentsOfFile:fileSystemPath];
-        if (dictionary)
+        for (SDLocaleModel* locale in dataSource.tiers)
         {
-            SDLocalizationTable* table = [SDLocalizationTable new];
-            table.name = tableName;
-            [table.content addEntriesFromDictionary:dictionary];
-            locale.dynamic.tablesByName[tableName] = table;
-            localizedValue = table.content[key];
+            tableNamesByLocalization[locale.languageID] = [self.dynamicStringsStore tableNamesForLocalization:locale.languageID];
         }
     }
-    if (localizedValue)
-    {
-        return localizedValue;
-    }
-    
-    // search in main bundle
-    localizedValue = locale.main.tablesByName[tableName].content[key];
-    if (!localizedValue)
-    {
-        // try to load the table from main bundle
-        NSString* bundlePath = [self bundle:[NSBundle mainBundle] pathForTable:tableName localization:locale.languageID];
-        if (bundlePath)
+    [self.dynamicStringsStore removeAllStrings];
+    [tableNamesByLocalization enumerateKeysAndObjectsUsingBlock:^(NSString* localization, NSArray<NSString*>* tableNames, BOOL* stop) {
+        for (SDLocalizationDataSource* dataSource in dataSources)
         {
-            NSDictionary* dictionary = [NSDictionary dictionaryWithContentsOfFile:bundlePath];
-            if (dictionary)
-            {
-                SDLocalizationTable* table = [SDLocalizationTable new];
-                table.name = tableName;
-                [table.content addEntriesFromDictionary:dictionary];
-                locale.main.tablesByName[tableName] = table;
-                localizedValue = table.content[key];
-            }
+            [dataSource invalidateTablesWithNames:tableNames forLocalization:localization];
         }
+        [updatedTableNames addObjectsFromArray:tableNames];
+    }];
+    [self.dataSourceLock unlock];
+    
+    // strings of all the localizations are removed, loaded or not
+    SDLocalizationChangeSet* changeSet = [[SDLocalizationChangeSet alloc] initWithKinds:SDLocalizationChangeKindStringsReset tableNames:updatedTableNames localizations:nil keys:nil];
+    [self postStringsDidUpdateNotificationWithChangeSet:changeSet];
+}
+
+/**
+ * Returns the current data source and those being prepared by asynchronous switches, which all reflect the added strings. Must be called holding dataSourceLock.
+ */
+- (NSArray<SDLocalizationDataSource*>*) updatableDataSources
+{
+    NSMutableArray<SDLocalizationDataSource*>* dataSources = [self.preparedDataSources.allObjects mutableCopy];
+    if (self.dataSource)
+    {
+        [dataSources addObject:self.dataSource];
     }
-    if (localizedValue)
+    return dataSources;
+}
+
+#pragma mark - Change Notifications
+
+/**
+ * Merges the given change set with the pending ones, scheduling their notification at the end of the coalescing interval.
+ */
+- (void) postStringsDidUpdateNotificationWithChangeSet:(SDLocalizationChangeSet*)changeSet
+{
+    NSTimeInterval interval = self.notificationCoalescingInterval;
+    if (interval <= 0)
     {
-        return localizedValue;
+        [self postStringsDidUpdateNotificationForChangeSet:changeSet];
+        return;
     }
     
-    // finally search in given bundle, if it is different from main bundle
-    if (![bundle isEqual:[NSBundle mainBundle]])
+    [self.pendingChangeSetLock lock];
+    BOOL scheduled = self.pendingChangeSet != nil;
+    self.pendingChangeSet = [changeSet changeSetByMergingChangeSet:self.pendingChangeSet];
+    [self.pendingChangeSetLock unlock];
+    
+    if (!scheduled)
     {
-        localizedValue = locale.bundlesById[bundle.bundleIdentifier].tablesByName[tableName].content[key];
-        if (!localizedValue)
-        {
-            // try to load the table from the given bundle
-            NSString* bundlePath = [self bundle:bundle pathForTable:tableName localization:locale.languageID];
-            if (bundlePath)
-            {
-                NSDictionary* dictionary = [NSDictionary dictionaryWithContentsOfFile:bundlePath];
-                if (dictionary)
-                {
-                    // create the bundle in data source if needed
-                    SDTablesBundle* tablesBundle = locale.bundlesById[bundle.bundleIdentifier];
-                    if (!tablesBundle)
-                    {
-                        tablesBundle = [SDTablesBundle new];
-                        tablesBundle.identifier = bundle.bundleIdentifier;
-                        locale.bundlesById[bundle.bundleIdentifier] = tablesBundle;
-                    }
-                    
-                    SDLocalizationTable* table = [SDLocalizationTable new];
-                    table.name = tableName;
-                    [table.content addEntriesFromDictionary:dictionary];
-                    tablesBundle.tablesByName[tableName] = table;
-                    localizedValue = table.content[key];
-                }
-            }
-        }
+        dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(interval * NSEC_PER_SEC)), dispatch_get_main_queue(), ^{
+            [self flushPendingChangeSet];
+        });
     }
+}
+
+- (void) flushPendingChangeSet
+{
+    [self.pendingChangeSetLock lock];
+    SDLocalizationChangeSet* changeSet = self.pendingChangeSet;
+    self.pendingChangeSet = nil;
+    [self.pendingChangeSetLock unlock];
     
-    if (!localizedValue)
+    // a language change may have posted the pending updates already
+    if (changeSet)
     {
-        SDLogModuleError(kLocalizationManagerLogModuleName, @"Key not found in table %@: %@", tableName, key);
+        [self postStringsDidUpdateNotificationForChangeSet:changeSet];
     }
-    return localizedValue;
 }
 
-- (NSString*) bundle:(NSBundle*)bundle pathForTable:(NSString*)tableName localization:(NSString*)localization
+- (void) postStringsDidUpdateNotificationForChangeSet:(SDLocalizationChangeSet*)changeSet
 {
-    NSString* path = [bundle pathForResource:tableName ofType:@"strings" inDirectory:nil forLocalization:localization];
-    return path;
+    NSMutableDictionary* userInfo = [NSMutableDictionary dictionary];
+    userInfo[SDLocalizationManagerChangeSetKey] = changeSet;
+    userInfo[SDLocalizationManagerUpdatedTableNamesKey] = changeSet.tableNames.allObjects;
+    if (changeSet.localizations.count == 1)
+    {
+        userInfo[SDLocalizationManagerUpdatedLocalizationKey] = changeSet.localizations.anyObject;
+    }
+    [[NSNotificationCenter defaultCenter] postNotificationName:SDLocalizationManagerStringsDidUpdateNotification object:self userInfo:userInfo];
 }
 
-- (NSString*) fileSystemPathForTable:(NSString*)tableName localization:(NSString*)localization
+/**
+ * Posts SDLocalizationManagerLanguageDidChangeNotification, which includes the pending updates of added strings: observers reload all the tables anyway.
+ */
+- (void) postLanguageDidChangeNotification
 {
-    NSString* path = [self.pathForDynamicStrings stringByAppendingPathComponent:[NSString stringWithFormat:@"%@_%@.strings", tableName, localization]];
-    return path;
+    [self.pendingChangeSetLock lock];
+    SDLocalizationChangeSet* changeSet = [[SDLocalizationChangeSet languageChangeSet] changeSetByMergingChangeSet:self.pendingChangeSet];
+    self.pendingChangeSet = nil;
+    [self.pendingChangeSetLock unlock];
+    
+    [[NSNotificationCenter defaultCenter] postNotificationName:SDLocalizationManagerLanguageDidChangeNotification object:self.selectedLocale userInfo:@{SDLocalizationManagerChangeSetKey: changeSet}];
 }
 
-#pragma mark - Adding strings
+#pragma mark - Statistics
 
-- (void) addStrings:(NSDictionary<NSString*, NSString*>*)strings
+- (void) incrementCounter:(SDLocalizationCounter)counter by:(uint64_t)value
 {
-    [self addStrings:strings toTableWithName:@"Localizable"];
+    atomic_fetch_add_explicit(&_counters[counter], value, memory_order_relaxed);
 }
 
-- (void) addStrings:(NSDictionary<NSString*, NSString*>*)strings toTableWithName:(NSString*)tableName
+- (SDLocalizationStatistics*) statistics
 {
-    [self addStrings:strings toTableWithName:tableName forLocalization:self.ISOSelectedLocale.languageID];
+    uint64_t counters[SDLocalizationCounterCount];
+    for (NSUInteger counter = 0; counter < SDLocalizationCounterCount; counter++)
+    {
+        counters[counter] = atomic_load_explicit(&_counters[counter], memory_order_relaxed);
+    }
+    return [[SDLocalizationStatistics alloc] initWithCounters:counters];
 }
 
-- (void) addStrings:(NSDictionary<NSString*, NSString*>*)strings toTableWithName:(NSString*)tableName forLocalization:(NSString*)localization
+- (void) resetStatistics
 {
-    // Parameters validation
-    if (!strings)
+    for (NSUInteger counter = 0; counter < SDLocalizationCounterCount; counter++)
     {
-        SDLogModuleError(kLocalizationManagerLogModuleName, @"Passed a nil dictionary of strings to add to table with name %@", tableName);
-        return;
+        atomic_store_explicit(&_counters[counter], 0, memory_order_relaxed);
     }
+}
+
+/**
+ * Counts a lookup served by the given table with the counter of the tier and source of the value and, if tracing is on, traces one lookup out of traceSamplingInterval.
+ */
+- (void) recordLookupOfKey:(NSString*)key inTable:(SDResolvedTable*)table counter:(SDLocalizationCounter)counter
+{
+    [self incrementCounter:counter by:1];
     
-    if (tableName.length == 0)
+    NSUInteger samplingInterval = self.traceSamplingInterval;
+    if (samplingInterval > 0 && atomic_fetch_add_explicit(&_traceSequence, 1, memory_order_relaxed) % samplingInterval == 0)
+    {
+        unsigned long tier = (counter - SDLocalizationCounterLookups) / SDLocalizationSourceCount;
+        unsigned long source = (counter - SDLocalizationCounterLookups) % SDLocalizationSourceCount;
+        SDLogModuleVerbose(kLocalizationManagerLogModuleName, @"Lookup of %@ in table %@ served by tier %lu, source %lu", key, table.name, tier, source);
+#if SD_SIGNPOSTS
+        if (@available(iOS 12.0, *))
+        {
+            os_signpost_event_emit(SDSignpostLog(), OS_SIGNPOST_ID_EXCLUSIVE, "Lookup", "%{public}@ %{public}@ tier:%lu source:%lu", table.name, key, tier, source);
+        }
+#endif
+    }
+}
+
+#if GLOTTY_UIKIT
+#pragma mark - Localized Images
+
+- (NSUInteger) imageCacheByteLimit
+{
+    return self.imageCache.totalCostLimit;
+}
+
+- (void) setImageCacheByteLimit:(NSUInteger)imageCacheByteLimit
+{
+    self.imageCache.totalCostLimit = imageCacheByteLimit;
+}
+
+- (void) removeCachedImages
+{
+    [self.imageCache removeAllObjects];
+}
+
+/**
+ * Called on memory warnings: resolved paths are dropped too, since they are kept for every localization and image name ever requested.
+ */
+- (void) removeCachedImagesAndPaths
+{
+    [self removeCachedImages];
+    [self.localizedImagePathsLock lock];
+    [self.localizedImagePaths removeAllObjects];
+    [self.localizedImagePathsLock unlock];
+}
+
+/**
+ * Returns the path of the localized image with the given name, trying the given extensions in order.
+ *
+ * Paths are resolved once per localization, also when the image is not found: a missing image is logged only the first time.
+ */
+- (NSString*) pathForLocalizedImageWithKey:(NSString*)key types:(NSArray<NSString*>*)types
+{
+    if (key.length == 0)
     {
-        SDLogModuleError(kLocalizationManagerLogModuleName, @"Invalid table name");
-        return;
+        return nil;
     }
     
-    if (localization.length == 0)
+    NSString* localization = self.selectedLocale.localeIdentifier;
+    NSString* cacheKey = [NSString stringWithFormat:@"%@/%@.%@", localization ?: @"", key, [types componentsJoinedByString:@"|"]];
+    [self.localizedImagePathsLock lock];
+    id cachedPath = self.localizedImagePaths[cacheKey];
+    [self.localizedImagePathsLock unlock];
+    if (cachedPath)
     {
-        SDLogModuleError(kLocalizationManagerLogModuleName, @"Invalid localization");
-        return;
+        return cachedPath == [NSNull null] ? nil : cachedPath;
     }
     
-    NSString* fileSystemPath = [self fileSystemPathForTable:tableName localization:localization];
-    NSMutableDictionary* dynamicDictionary = [NSMutableDictionary dictionaryWithContentsOfFile:fileSystemPath];
-    if(!dynamicDictionary)
+    NSString* path = nil;
+    for (NSString* type in types)
     {
-        dynamicDictionary = [NSMutableDictionary new];
+        path = [[NSBundle mainBundle] pathForResource:key ofType:type inDirectory:nil forLocalization:localization];
+        if (path)
+        {
+            break;
+        }
+    }
+    if (!path)
+    {
+        SDLogError(@"Path image nil for key: %@ and types: %@", key, [types componentsJoinedByString:@", "]);
     }
     
-    [dynamicDictionary addEntriesFromDictionary:strings];
-    
-    [dynamicDictionary writeToFile:fileSystemPath atomically:YES];
-    
-    [self resetLocalizedTables];
+    [self.localizedImagePathsLock lock];
+    self.localizedImagePaths[cacheKey] = path ?: [NSNull null];
+    [self.localizedImagePathsLock unlock];
+    return path;
 }
 
-- (void) resetAddedStringsToTableWithName:(NSString*)tableName forLocalization:(NSString*)localization
+- (UIImage*) localizedImageWithKey:(NSString*)key types:(NSArray<NSString*>*)types
 {
-    NSString* fileSystemPath = [self fileSystemPathForTable:tableName localization:localization];
-    [GTYFileManager deleteFilesAtPath:fileSystemPath];
+    NSString* path = [self pathForLocalizedImageWithKey:key types:types];
+    if (!path)
+    {
+        return nil;
+    }
     
-    [self resetLocalizedTables];
+    // cached images are decoded, as those loaded by loadLocalizedImageWithKey:completion: with the same path
+    UIImage* image = [self.imageCache objectForKey:path];
+    if (!image)
+    {
+        image = SDDecodedImage([UIImage imageWithContentsOfFile:path]);
+        [self.imageCache setObject:image forKey:path cost:SDImageCost(image)];
+    }
+    return image;
 }
 
-- (void) resetAllAddedStringsForLocalization:(NSString*)localization
+- (void) loadLocalizedImageWithKey:(NSString*)key completion:(void (^)(UIImage* image))completion
 {
-    NSArray<NSString*>* filePaths = [GTYFileManager getFilesContentInDirectoryNamed:self.pathForDynamicStrings];
-    for (NSString* fileName in filePaths)
-    {
-        if([fileName containsString:[NSString stringWithFormat:@"_%@.strings", localization]])
+    dispatch_async(dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^{
+        UIImage* image = nil;
+        NSString* path = [self pathForLocalizedImageWithKey:key types:kLocalizedImageTypes];
+        if (path)
+        {
+            image = [self.imageCache objectForKey:path];
+            if (!image)
+            {
+                image = SDDecodedImage([UIImage imageWithContentsOfFile:path]);
+                [self.imageCache setObject:image forKey:path cost:SDImageCost(image)];
+            }
+        }
+        
+        if (completion)
         {
-            NSString* filePath = [self.pathForDynamicStrings stringByAppendingPathComponent:fileName];
-            [GTYFileManager deleteFilesAtPath:filePath];
+            dispatch_async(dispatch_get_main_queue(), ^{
+                completion(image);
+            });
         }
-    }
-    [self resetLocalizedTables];
+    });
 }
 
-- (void) resetAllAddedStrings
-{
-    NSArray<NSString*>* filePaths = [GTYFileManager getFilesContentInDirectoryNamed:self.pathForDynamicStrings];
-    for (NSString* fileName in filePaths)
-    {
-        NSString* filePath = [self.pathForDynamicStrings stringByAppendingPathComponent:fileName];
-        [GTYFileManager deleteFilesAtPath:filePath];
-    }
-    [self resetLocalizedTables];
-}
+#endif
 
 #pragma mark - Formatters & Calendars Management
 
+/**
+ * Formats a date and a number with the given locale on the calling thread. Formatters belong to their threads, but the first one of a locale loads its data for the whole process.
+ */
+- (void)warmFormattersForLocale:(NSLocale*)locale
+{
+    NSDateFormatter* dateFormatter = [[NSDateFormatter alloc] init];
+    dateFormatter.locale = locale;
+    dateFormatter.dateFormat = [NSDateFormatter dateFormatFromTemplate:@"dd/MM/yyyy HH:mm" options:0 locale:locale];
+    [dateFormatter stringFromDate:[NSDate date]];
+    
+    NSNumberFormatter* numberFormatter = [[NSNumberFormatter alloc] init];
+    numberFormatter.locale = locale;
+    numberFormatter.numberStyle = NSNumberFormatterDecimalStyle;
+    [numberFormatter stringFromNumber:@1234.5];
+}
+
 - (void)resetFormattersAndCalendars
 {
     self.simpleDateFormatter = nil;
@@ -914,6 +2262,29 @@ UIImage* SDLocalizedImageWithNameAndExtension(NSString * key, NSString *type)
     self.percentageFormatter = nil;
     
     self.userDefaultCalendar = nil;
+    
+    [self.formatterPool invalidate];
+}
+
+/**
+ * Reads the formatting preferences from user defaults. A new snapshot, with a new version, is published only if a value changed.
+ */
+- (void)refreshFormattingSettings
+{
+    NSUserDefaults* userDefaults = [NSUserDefaults standardUserDefaults];
+    NSMutableDictionary<NSString*, NSString*>* values = [NSMutableDictionary dictionary];
+    for (NSString* key in kFormattingSettingsKeys)
+    {
+        values[key] = [userDefaults stringForKey:key];
+    }
+    
+    [self.formattingSettingsLock lock];
+    SDFormattingSettings* settings = self.formattingSettings;
+    if (![settings.values isEqualToDictionary:values])
+    {
+        self.formattingSettings = [[SDFormattingSettings alloc] initWithValues:values version:settings.version + 1];
+    }
+    [self.formattingSettingsLock unlock];
 }
 
 #pragma mark - Date Formatters
@@ -924,74 +2295,75 @@ UIImage* SDLocalizedImageWithNameAndExtension(NSString * key, NSString *type)
     return isoLocale ? isoLocale : [NSLocale currentLocale];
 }
 
+- (NSDateFormatter*) dateFormatterWithTemplate:(NSString*)dateTemplate timeZone:(NSTimeZone*)timeZone
+{
+    NSLocale* locale = self.formatterLocale;
+    NSString* key = [NSString stringWithFormat:@"template|%@|%@|%@", dateTemplate, locale.localeIdentifier, timeZone.name ?: @""];
+    return [self.formatterPool formatterForKey:key creator:^id{
+        NSDateFormatter* formatter = [[NSDateFormatter alloc] init];
+        formatter.locale = locale;
+        formatter.dateFormat = [NSDateFormatter dateFormatFromTemplate:dateTemplate options:0 locale:locale];
+        if (timeZone)
+        {
+            formatter.timeZone = timeZone;
+        }
+        return formatter;
+    }];
+}
+
+- (NSDateFormatter*) dateFormatterWithFormat:(NSString*)dateFormat timeZone:(NSTimeZone*)timeZone
+{
+    return [self dateFormatterWithFormat:dateFormat locale:self.formatterLocale timeZone:timeZone];
+}
+
+- (NSDateFormatter*) dateFormatterWithFormat:(NSString*)dateFormat locale:(NSLocale*)locale timeZone:(NSTimeZone*)timeZone
+{
+    NSString* key = [NSString stringWithFormat:@"format|%@|%@|%@", dateFormat, locale.localeIdentifier ?: @"", timeZone.name ?: @""];
+    return [self.formatterPool formatterForKey:key creator:^id{
+        NSDateFormatter* formatter = [[NSDateFormatter alloc] init];
+        if (locale)
+        {
+            formatter.locale = locale;
+        }
+        formatter.dateFormat = dateFormat;
+        if (timeZone)
+        {
+            formatter.timeZone = timeZone;
+        }
+        return formatter;
+    }];
+}
+
 - (NSDateFormatter *)simpleDateFormatter
 {
-    if (!_simpleDateFormatter)
-    {
-        NSString *template = [NSString stringWithFormat:@"dd/MM/yyyy"];
-        NSString* format = [NSDateFormatter dateFormatFromTemplate:template options:0 locale:self.formatterLocale];
-        _simpleDateFormatter = [[NSDateFormatter alloc] init];
-        _simpleDateFormatter.locale = self.formatterLocale;
-        _simpleDateFormatter.dateFormat = format;
-    }
-    return _simpleDateFormatter;
+    return _simpleDateFormatter ?: [self dateFormatterWithTemplate:@"dd/MM/yyyy" timeZone:nil];
 }
 
 - (NSDateFormatter *)twelveHoursTimeFormatter
 {
-    if (!_twelveHoursTimeFormatter)
-    {
-        NSString *template = [NSString stringWithFormat:@"hh:mm a"];
-        NSString* format = [NSDateFormatter dateFormatFromTemplate:template options:0 locale:self.formatterLocale];
-        _twelveHoursTimeFormatter = [[NSDateFormatter alloc] init];
-        _twelveHoursTimeFormatter.locale = self.formatterLocale;
-        _twelveHoursTimeFormatter.dateFormat = format;
-    }
-    return _twelveHoursTimeFormatter;
+    return _twelveHoursTimeFormatter ?: [self dateFormatterWithTemplate:@"hh:mm a" timeZone:nil];
 }
 
 - (NSDateFormatter *)twentyFourHoursTimeFormatter
 {
-    if (!_twentyFourHoursTimeFormatter)
-    {
-        NSString *template = [NSString stringWithFormat:@"HH:mm"];
-        NSString* format = [NSDateFormatter dateFormatFromTemplate:template options:0 locale:self.formatterLocale];
-        _twentyFourHoursTimeFormatter = [[NSDateFormatter alloc] init];
-        _twentyFourHoursTimeFormatter.locale = self.formatterLocale;
-        _twentyFourHoursTimeFormatter.dateFormat = format;
-    }
-    return _twentyFourHoursTimeFormatter;
+    return _twentyFourHoursTimeFormatter ?: [self dateFormatterWithTemplate:@"HH:mm" timeZone:nil];
 }
 
 - (NSDateFormatter *)simpleDateTimeFormatter
 {
-    if (!_simpleDateTimeFormatter)
-    {
-        NSString *template = [NSString stringWithFormat:@"dd/MM/yyyy HH:mm"];
-        NSString* format = [NSDateFormatter dateFormatFromTemplate:template options:0 locale:self.formatterLocale];
-        _simpleDateTimeFormatter = [[NSDateFormatter alloc] init];
-        _simpleDateTimeFormatter.locale = self.formatterLocale;
-        _simpleDateTimeFormatter.dateFormat = format;
-    }
-    return _simpleDateTimeFormatter;
+    return _simpleDateTimeFormatter ?: [self dateFormatterWithTemplate:@"dd/MM/yyyy HH:mm" timeZone:nil];
 }
 
 - (NSDateFormatter*) serverDateTimeFormatter
 {
-    if (!_serverDateTimeFormatter)
-    {
-        _serverDateTimeFormatter = [[NSDateFormatter alloc] init];
-        _serverDateTimeFormatter.dateFormat = @"yyyy-MM-dd hh:mm:ss.SSS";
-        _serverDateTimeFormatter.timeZone = [NSTimeZone timeZoneForSecondsFromGMT:0];
-    }
-    return _serverDateTimeFormatter;
+    return _serverDateTimeFormatter ?: [self dateFormatterWithFormat:@"yyyy-MM-dd hh:mm:ss.SSS" locale:nil timeZone:[NSTimeZone timeZoneForSecondsFromGMT:0]];
 }
 
 #pragma mark - User Default Date Formatters
 
 - (NSString *)userDefaultDateFormat
 {
-    NSString* dateFormat = [[NSUserDefaults standardUserDefaults] stringForKey:USER_DEF_DATE_FORMAT];
+    NSString* dateFormat = [self.formattingSettings stringForKey:USER_DEF_DATE_FORMAT];
     
     if (dateFormat.length == 0)
     {
@@ -1002,13 +2374,12 @@ UIImage* SDLocalizedImageWithNameAndExtension(NSString * key, NSString *type)
 
 - (void)setUserDefaultDateFormat:(NSString *)userDefaultDateFormat
 {
-    [[NSUserDefaults standardUserDefaults] setObject:userDefaultDateFormat forKey:USER_DEF_DATE_FORMAT];
-    [[NSUserDefaults standardUserDefaults] synchronize];
+    [self setPersistentObject:userDefaultDateFormat forKey:USER_DEF_DATE_FORMAT];
 }
 
 - (NSString *)userDefaultTimeFormat
 {
-    NSString* dateFormat = [[NSUserDefaults standardUserDefaults] stringForKey:USER_DEF_TIME_FORMAT];
+    NSString* dateFormat = [self.formattingSettings stringForKey:USER_DEF_TIME_FORMAT];
     
     if (dateFormat.length == 0)
     {
@@ -1019,49 +2390,30 @@ UIImage* SDLocalizedImageWithNameAndExtension(NSString * key, NSString *type)
 
 - (void)setUserDefaultTimeFormat:(NSString *)userDefaultTimeFormat
 {
-    [[NSUserDefaults standardUserDefaults] setObject:userDefaultTimeFormat forKey:USER_DEF_TIME_FORMAT];
-    [[NSUserDefaults standardUserDefaults] synchronize];
+    [self setPersistentObject:userDefaultTimeFormat forKey:USER_DEF_TIME_FORMAT];
 }
 
 - (NSDateFormatter*) userDefaultDateFormatter
 {
-    if (!_userDefaultDateFormatter)
-    {
-        _userDefaultDateFormatter = [[NSDateFormatter alloc] init];
-        _userDefaultDateFormatter.locale = self.formatterLocale;
-    }
-    _userDefaultDateFormatter.dateFormat = self.userDefaultDateFormat;
-    return _userDefaultDateFormatter;
+    // the format is part of the key of the pool, so a changed format gives a different formatter instead of mutating a shared one
+    return _userDefaultDateFormatter ?: [self dateFormatterWithFormat:self.userDefaultDateFormat timeZone:nil];
 }
 
 - (NSDateFormatter*) userDefaultTimeFormatter
 {
-    if (!_userDefaultTimeFormatter)
-    {
-        _userDefaultTimeFormatter = [[NSDateFormatter alloc] init];
-        _userDefaultTimeFormatter.locale = self.formatterLocale;
-    }
-    _userDefaultTimeFormatter.dateFormat = self.userDefaultTimeFormat;
-    return _userDefaultTimeFormatter;
+    return _userDefaultTimeFormatter ?: [self dateFormatterWithFormat:self.userDefaultTimeFormat timeZone:nil];
 }
 
 - (NSDateFormatter*) userDefaultDateTimeFormatter
 {
-    if (!_userDefaultDateTimeFormatter)
-    {
-        _userDefaultDateTimeFormatter = [[NSDateFormatter alloc] init];
-        _userDefaultDateTimeFormatter.locale = self.formatterLocale;
-    }
-    _userDefaultDateTimeFormatter.dateFormat = [NSString stringWithFormat:@"%@ %@", self.userDefaultDateFormat, self.userDefaultTimeFormat];
-    
-    return _userDefaultDateTimeFormatter;
+    return _userDefaultDateTimeFormatter ?: [self dateFormatterWithFormat:[NSString stringWithFormat:@"%@ %@", self.userDefaultDateFormat, self.userDefaultTimeFormat] timeZone:nil];
 }
 
 #pragma mark - Number Formatters
 
 - (NSString *)userDefaultDistanceUnit
 {
-    NSString* unit = [[NSUserDefaults standardUserDefaults] stringForKey:USER_DEF_DISTANCE_UNIT];
+    NSString* unit = [self.formattingSettings stringForKey:USER_DEF_DISTANCE_UNIT];
     
     if (unit.length == 0)
     {
@@ -1072,13 +2424,12 @@ UIImage* SDLocalizedImageWithNameAndExtension(NSString * key, NSString *type)
 
 - (void)setUserDefaultDistanceUnit:(NSString *)userDefaultDistanceUnit
 {
-    [[NSUserDefaults standardUserDefaults] setObject:userDefaultDistanceUnit forKey:USER_DEF_DISTANCE_UNIT];
-    [[NSUserDefaults standardUserDefaults] synchronize];
+    [self setPersistentObject:userDefaultDistanceUnit forKey:USER_DEF_DISTANCE_UNIT];
 }
 
 - (NSString *)userDefaultSpeedUnit
 {
-    NSString* unit = [[NSUserDefaults standardUserDefaults] stringForKey:USER_DEF_SPEED_UNIT];
+    NSString* unit = [self.formattingSettings stringForKey:USER_DEF_SPEED_UNIT];
     
     if (unit.length == 0)
     {
@@ -1089,13 +2440,12 @@ UIImage* SDLocalizedImageWithNameAndExtension(NSString * key, NSString *type)
 
 - (void)setUserDefaultSpeedUnit:(NSString *)userDefaultSpeedUnit
 {
-    [[NSUserDefaults standardUserDefaults] setObject:userDefaultSpeedUnit forKey:USER_DEF_SPEED_UNIT];
-    [[NSUserDefaults standardUserDefaults] synchronize];
+    [self setPersistentObject:userDefaultSpeedUnit forKey:USER_DEF_SPEED_UNIT];
 }
 
 - (NSString *)userDefaultCurrencySymbol
 {
-    NSString* symbol = [[NSUserDefaults standardUserDefaults] stringForKey:USER_DEF_CURRENCY_SYMBOL];
+    NSString* symbol = [self.formattingSettings stringForKey:USER_DEF_CURRENCY_SYMBOL];
     
     if (symbol.length == 0)
     {
@@ -1106,85 +2456,69 @@ UIImage* SDLocalizedImageWithNameAndExtension(NSString * key, NSString *type)
 
 - (void)setUserDefaultCurrencySymbol:(NSString *)userDefaultCurrencySymbol
 {
-    [[NSUserDefaults standardUserDefaults] setObject:userDefaultCurrencySymbol forKey:USER_DEF_CURRENCY_SYMBOL];
-    [[NSUserDefaults standardUserDefaults] synchronize];
+    [self setPersistentObject:userDefaultCurrencySymbol forKey:USER_DEF_CURRENCY_SYMBOL];
+}
+
+/**
+ * Returns the formatter of the calling thread for decimal numbers with the given number of fraction digits and suffix. Separators can be overwritten by localized keys.
+ */
+- (NSNumberFormatter*) decimalFormatterWithFractionDigits:(NSUInteger)fractionDigits positiveSuffix:(NSString*)suffix
+{
+    NSLocale* locale = self.formatterLocale;
+    NSString* key = [NSString stringWithFormat:@"decimal|%lu|%@|%@", (unsigned long)fractionDigits, suffix, locale.localeIdentifier];
+    return [self.formatterPool formatterForKey:key creator:^id{
+        NSNumberFormatter* formatter = [[NSNumberFormatter alloc] init];
+        formatter.numberStyle = NSNumberFormatterDecimalStyle;
+        formatter.minimumFractionDigits = formatter.maximumFractionDigits = fractionDigits;
+        formatter.locale = locale;
+        formatter.usesGroupingSeparator = YES;
+        
+        NSString *decimalSeparator = SDLocalizedStringWithDefault(kDecimalSeparatorLocalizedKey, formatter.locale.decimalSeparator);
+        formatter.decimalSeparator = decimalSeparator;
+        NSString *groupingSeparator = SDLocalizedStringWithDefault(kGroupingSeparatorLocalizedKey, formatter.locale.groupingSeparator);
+        formatter.groupingSeparator = groupingSeparator;
+        formatter.positiveSuffix = suffix;
+        return formatter;
+    }];
 }
 
 - (NSNumberFormatter*) userDefaultDistanceFormatter
 {
-    if (!_userDefaultDistanceFormatter)
-    {
-        _userDefaultDistanceFormatter = [[NSNumberFormatter alloc] init];
-        _userDefaultDistanceFormatter.numberStyle = NSNumberFormatterDecimalStyle;
-        _userDefaultDistanceFormatter.minimumFractionDigits = _userDefaultDistanceFormatter.maximumFractionDigits = 1;
-        _userDefaultDistanceFormatter.locale = [self formatterLocale];
-        _userDefaultDistanceFormatter.usesGroupingSeparator = YES;
-        
-        NSString *decimalSeparator = SDLocalizedStringWithDefault(kDecimalSeparatorLocalizedKey, _userDefaultDistanceFormatter.locale.decimalSeparator);
-        _userDefaultDistanceFormatter.decimalSeparator = decimalSeparator;
-        NSString *groupingSeparator = SDLocalizedStringWithDefault(kGroupingSeparatorLocalizedKey, _userDefaultDistanceFormatter.locale.groupingSeparator);
-        _userDefaultDistanceFormatter.groupingSeparator = groupingSeparator;
-    }
-    _userDefaultDistanceFormatter.positiveSuffix = self.userDefaultDistanceUnit;
-    return _userDefaultDistanceFormatter;
+    return _userDefaultDistanceFormatter ?: [self decimalFormatterWithFractionDigits:1 positiveSuffix:self.userDefaultDistanceUnit];
 }
 
 - (NSNumberFormatter *)userDefaultSpeedFormatter
 {
-    if (!_userDefaultSpeedFormatter)
-    {
-        _userDefaultSpeedFormatter = [[NSNumberFormatter alloc] init];
-        _userDefaultSpeedFormatter.numberStyle = NSNumberFormatterDecimalStyle;
-        _userDefaultSpeedFormatter.minimumFractionDigits = _userDefaultSpeedFormatter.maximumFractionDigits = 1;
-        _userDefaultSpeedFormatter.locale = [self formatterLocale];
-        _userDefaultSpeedFormatter.usesGroupingSeparator = YES;
-        
-        NSString *decimalSeparator = SDLocalizedStringWithDefault(kDecimalSeparatorLocalizedKey, _userDefaultSpeedFormatter.locale.decimalSeparator);
-        _userDefaultSpeedFormatter.decimalSeparator = decimalSeparator;
-        NSString *groupingSeparator = SDLocalizedStringWithDefault(kGroupingSeparatorLocalizedKey, _userDefaultSpeedFormatter.locale.groupingSeparator);
-        _userDefaultSpeedFormatter.groupingSeparator = groupingSeparator;
-    }
-    _userDefaultSpeedFormatter.positiveSuffix = self.userDefaultSpeedUnit;
-    return _userDefaultSpeedFormatter;
+    return _userDefaultSpeedFormatter ?: [self decimalFormatterWithFractionDigits:1 positiveSuffix:self.userDefaultSpeedUnit];
 }
 
 - (NSNumberFormatter *)userDefaultCurrencyFormatter
 {
-    if (!_userDefaultCurrencyFormatter)
-    {
-        _userDefaultCurrencyFormatter = [[NSNumberFormatter alloc] init];
-        _userDefaultCurrencyFormatter.numberStyle = NSNumberFormatterDecimalStyle;
-        _userDefaultCurrencyFormatter.minimumFractionDigits = _userDefaultSpeedFormatter.maximumFractionDigits = 2;
-        _userDefaultCurrencyFormatter.locale = [self formatterLocale];
-        _userDefaultCurrencyFormatter.usesGroupingSeparator = YES;
-        
-        NSString *decimalSeparator = SDLocalizedStringWithDefault(kDecimalSeparatorLocalizedKey, _userDefaultCurrencyFormatter.locale.decimalSeparator);
-        _userDefaultCurrencyFormatter.decimalSeparator = decimalSeparator;
-        NSString *groupingSeparator = SDLocalizedStringWithDefault(kGroupingSeparatorLocalizedKey, _userDefaultCurrencyFormatter.locale.groupingSeparator);
-        _userDefaultCurrencyFormatter.groupingSeparator = groupingSeparator;
-    }
-    _userDefaultCurrencyFormatter.positiveSuffix = self.userDefaultCurrencySymbol;
-    return _userDefaultCurrencyFormatter;
+    return _userDefaultCurrencyFormatter ?: [self decimalFormatterWithFractionDigits:2 positiveSuffix:self.userDefaultCurrencySymbol];
 }
 
 - (NSNumberFormatter *)percentageFormatter
 {
-    if (!_percentageFormatter)
+    if (_percentageFormatter)
     {
-        _percentageFormatter = [[NSNumberFormatter alloc] init];
-        _percentageFormatter.locale = self.formatterLocale;
-        [_percentageFormatter setNumberStyle:NSNumberFormatterPercentStyle];
-        [_percentageFormatter setMaximumFractionDigits:2];
-        [_percentageFormatter setMultiplier:@1];
+        return _percentageFormatter;
     }
-    return _percentageFormatter;
+    NSLocale* locale = self.formatterLocale;
+    return [self.formatterPool formatterForKey:[@"percentage|" stringByAppendingString:locale.localeIdentifier] creator:^id{
+        NSNumberFormatter* formatter = [[NSNumberFormatter alloc] init];
+        formatter.locale = locale;
+        [formatter setNumberStyle:NSNumberFormatterPercentStyle];
+        [formatter setMaximumFractionDigits:2];
+        [formatter setMultiplier:@1];
+        return formatter;
+    }];
 }
 
 #pragma mark - Calendars
 
 - (NSTimeZone *)userDefaultTimeZone
 {
-    NSString* timeZoneName = [[NSUserDefaults standardUserDefaults] stringForKey:USER_DEF_TIME_ZONE];
+    NSString* timeZoneName = [self.formattingSettings stringForKey:USER_DEF_TIME_ZONE];
     
     if (timeZoneName.length == 0)
     {
@@ -1195,13 +2529,12 @@ UIImage* SDLocalizedImageWithNameAndExtension(NSString * key, NSString *type)
 
 - (void)setUserDefaultTimeZone:(NSTimeZone *)userDefaultTimeZone
 {
-    [[NSUserDefaults standardUserDefaults] setObject:userDefaultTimeZone.name forKey:USER_DEF_TIME_ZONE];
-    [[NSUserDefaults standardUserDefaults] synchronize];
+    [self setPersistentObject:userDefaultTimeZone.name forKey:USER_DEF_TIME_ZONE];
 }
 
 - (NSString *)userDefaultCalendarIdentifier
 {
-    NSString* calendarID = [[NSUserDefaults standardUserDefaults] stringForKey:USER_DEF_CALENDAR_ID];
+    NSString* calendarID = [self.formattingSettings stringForKey:USER_DEF_CALENDAR_ID];
     if (calendarID.length == 0)
     {
         calendarID = [NSCalendar currentCalendar].calendarIdentifier;
@@ -1211,22 +2544,34 @@ UIImage* SDLocalizedImageWithNameAndExtension(NSString * key, NSString *type)
 
 - (void)setUserDefaultCalendarIdentifier:(NSString *)userDefaultCalendarIdentifier
 {
-    [[NSUserDefaults standardUserDefaults] setObject:userDefaultCalendarIdentifier forKey:USER_DEF_CALENDAR_ID];
-    [[NSUserDefaults standardUserDefaults] synchronize];
+    [self setPersistentObject:userDefaultCalendarIdentifier forKey:USER_DEF_CALENDAR_ID];
     [self setUserDefaultCalendar:nil];
 }
 
 - (NSCalendar *)userDefaultCalendar
 {
+    NSUInteger version = self.formattingSettings.version;
     if (!_userDefaultCalendar)
     {
         _userDefaultCalendar = [[NSCalendar alloc] initWithCalendarIdentifier:self.userDefaultCalendarIdentifier];
         _userDefaultCalendar.locale = self.formatterLocale;
+        _userDefaultCalendarSettingsVersion = 0;
+    }
+    // the time zone is applied again only if the settings changed
+    if (_userDefaultCalendarSettingsVersion != version)
+    {
+        _userDefaultCalendar.timeZone = self.userDefaultTimeZone;
+        _userDefaultCalendarSettingsVersion = version;
     }
-    _userDefaultCalendar.timeZone = self.userDefaultTimeZone;
     return _userDefaultCalendar;
 }
 
+- (void)setUserDefaultCalendar:(NSCalendar *)userDefaultCalendar
+{
+    _userDefaultCalendar = userDefaultCalendar;
+    _userDefaultCalendarSettingsVersion = 0;
+}
+
 - (NSCalendar *)utcCalendar
 {
     if (!_utcCalendar)
@@ -6,15 +6,152 @@
 //
 
 #import <Foundation/Foundation.h>
+#import "SDLocalizationStatistics.h"
+
+@class GTYStringsPack;
+@class GTYCompactTableBuilder;
+@class GTYStringTemplate;
 
 @interface SDLocalizationTable: NSObject
 @property (nonatomic, strong) NSString* name;
-@property (nonatomic, strong) NSMutableDictionary* content;
+/**
+ * The strings of the table: a GTYCompactTable for tables loaded from .strings files, a mutable dictionary for added strings. Never mutated once the table is in a data source.
+ */
+@property (nonatomic, strong) NSDictionary<NSString*, NSString*>* content;
+@property (nonatomic, strong) GTYStringsPack* pack;
+/**
+ * Size on disk of the .strings file or compiled pack the table has been loaded from, 0 for tables of added strings. Used only by the load statistics, logs and signposts: residency limits use residentByteCount and chargedByteCount, which estimate memory.
+ */
+@property (nonatomic, assign) NSUInteger fileByteCount;
+/**
+ * Estimated bytes of memory used by the content, computed the first time, holding the lock of the data source. The interned strings of compact content are shared with other tables, so they are counted by the data source. Compiled packs are mapped, so the system can reclaim their pages and they are not counted.
+ */
+@property (nonatomic, readonly) NSUInteger residentByteCount;
+/**
+ * Bytes added to the running count of the tables bundle holding the table: residentByteCount and the interned strings the table added to the pool.
+ */
+@property (nonatomic, readonly) NSUInteger chargedByteCount;
+/**
+ * Returns the value for the given key, searching the content and then the compiled pack, if any.
+ */
+- (NSString*)stringForKey:(NSString*)key;
+/**
+ * Enumerates the entries of the content, then those of the compiled pack. A key found in both is enumerated twice, with the value of the content first.
+ */
+- (void)enumerateKeysAndStringsUsingBlock:(void (^)(NSString* key, NSString* string, BOOL* stop))block;
+/**
+ * Adds the entries of the content whose keys are not in the given builder yet. Compact content is copied byte by byte, without creating strings. The compiled pack is not copied: it is probed in place by the merged table.
+ *
+ * @param packs Packs of higher precedence: the keys they contain are skipped, so that lookups find them in the packs.
+ * @param block Called with the key of each added entry. Can be nil.
+ */
+- (void)addMissingEntriesToBuilder:(GTYCompactTableBuilder*)builder shadowedByPacks:(NSArray<GTYStringsPack*>*)packs usingBlock:(void (^)(NSString* key))block;
+@end
+
+/**
+ * The view of a table of a bundle with all locale tiers merged in order of precedence, so that a lookup is a single probe of the merged content, followed by the compiled packs only if it misses.
+ */
+@interface SDResolvedTable: NSObject
+@property (nonatomic, strong) NSString* name;
+@property (nonatomic, strong) NSString* bundleIdentifier;
+/**
+ * The merged entries of the tables with content. Keys that a pack of higher precedence contains are left out, so that the pack answers for them.
+ */
+@property (nonatomic, strong) NSDictionary<NSString*, NSString*>* content;
+/**
+ * The compiled packs of the merged tables, in order of precedence. They are probed in place, never copied into content, so their pages are read only for the keys looked up.
+ */
+@property (nonatomic, strong) NSArray<GTYStringsPack*>* packs;
+/**
+ * YES if content is the content of a merged table, or an empty dictionary, rather than a dictionary of its own.
+ */
+@property (nonatomic, assign) BOOL sharesContent;
+/**
+ * Bytes of memory used by the merged table, excluding its interned strings, 0 if it shares the content of its table.
+ */
+@property (nonatomic, readonly) NSUInteger residentByteCount;
+/**
+ * Bytes added to the running count of the data source when the table is published: residentByteCount and the interned strings the merged content added to the pool.
+ */
+@property (nonatomic, readonly) NSUInteger chargedByteCount;
+/**
+ * Value of the residency clock of the manager at the last lookup, used to evict the least recently used tables. Lookups only read the clock, which advances when tables are published.
+ */
+@property (atomic, assign) uint64_t lastAccessTick;
+/**
+ * Lookup counters of the merged tables by source: the tables with content in order of precedence, then the packs. Each entry of a merged compact content stores the index of its table, so the counter of a lookup is known without another probe.
+ */
+@property (nonatomic, copy) NSArray<NSNumber*>* counters;
+/**
+ * Returns the value of the given key: the one of content, or else the one of the first pack containing it.
+ */
+- (NSString*)stringForKey:(NSString*)key;
+/**
+ * Like stringForKey:, setting counter to the counter of SDLocalizationStatistics of the table the value comes from. The counter is not changed if the key is missing.
+ */
+- (NSString*)stringForKey:(NSString*)key counter:(SDLocalizationCounter*)counter;
+/**
+ * Returns the counter of SDLocalizationStatistics to increment for a lookup of the given key. Costs a lookup: use stringForKey:counter: when the value is needed too.
+ */
+- (SDLocalizationCounter)lookupCounterForKey:(NSString*)key;
+/**
+ * Returns the value of the key parsed with the placeholders of the given dictionary. Templates are cached with the table, so they are dropped when it is invalidated.
+ *
+ * @return The template, or nil if the table does not contain the key.
+ */
+- (GTYStringTemplate*)templateForKey:(NSString*)key placeholderDictionary:(NSDictionary<NSString*, NSString*>*)placeholderDictionary;
+/**
+ * Keys of the table in ordinal (UTF-16) order, sorted the first time they are needed.
+ */
+@property (atomic, strong, readonly) NSArray<NSString*>* sortedKeys;
+/**
+ * Keys starting with the given prefix, in order. Keys sharing a prefix are contiguous in sortedKeys, so this is a binary search followed by a scan of the matches.
+ */
+- (NSArray<NSString*>*)keysWithPrefix:(NSString*)prefix;
+/**
+ * Keys greater than or equal to fromKey and less than toKey, in order. A nil bound is open.
+ */
+- (NSArray<NSString*>*)keysFromKey:(NSString*)fromKey toKey:(NSString*)toKey;
+/**
+ * The resolved pack of the highest tier, if any: the indexes of its entries are the key IDs of the table.
+ */
+@property (nonatomic, strong) GTYStringsPack* keyIDPack;
+/**
+ * Returns the value of the key with the given ID, reading an array indexed by ID that is built from the content the first time.
+ *
+ * @return The value, or nil if the ID is out of range or the key has no value.
+ */
+- (NSString*)stringForKeyID:(uint32_t)keyID;
+/**
+ * Set once a header of key IDs not matching keyIDPack has been reported, so that the error is logged once per table.
+ */
+@property (atomic, assign) BOOL reportedKeySetMismatch;
 @end
 
 @interface SDTablesBundle: NSObject
 @property (nonatomic, strong) NSString* identifier;
-@property (nonatomic, strong) NSMutableDictionary<NSString*, SDLocalizationTable*>* tablesByName;
+/**
+ * Loaded tables by name, changed only with addTable: and removeTablesWithNames:.
+ */
+@property (nonatomic, strong, readonly) NSDictionary<NSString*, SDLocalizationTable*>* tablesByName;
+/**
+ * Sum of the charged bytes of the loaded tables, kept up to date by addTable: and removeTablesWithNames:.
+ */
+@property (nonatomic, assign, readonly) NSUInteger residentByteCount;
+/**
+ * Adds the given table, replacing the loaded table with the same name if any.
+ */
+- (void)addTable:(SDLocalizationTable*)table;
+/**
+ * Removes the loaded tables with the given names.
+ *
+ * @return The removed tables.
+ */
+- (NSArray<SDLocalizationTable*>*)removeTablesWithNames:(NSArray<NSString*>*)tableNames;
+/**
+ * Names of the tables known to be absent, so that they are not searched again.
+ */
+@property (nonatomic, strong) NSMutableSet<NSString*>* missingTableNames;
 @end
 
 @interface SDLocaleModel: NSObject
@@ -22,10 +159,78 @@
 @property (nonatomic, strong) SDTablesBundle* dynamic;
 @property (nonatomic, strong) SDTablesBundle* main;
 @property (nonatomic, strong) NSMutableDictionary<NSString*, SDTablesBundle*>* bundlesById;
+/**
+ * Incremented by every invalidation of the tables of the locale, so that tables loaded meanwhile are not stored. Locale models are shared by data sources, so loads compare it rather than the generation of the data source that started them.
+ */
+@property (atomic, assign) NSUInteger generation;
+/**
+ * Sum of the running counts of the tables bundles. Locale models are shared by the data sources with the same tiers, so their tables are counted once for all of them.
+ */
+- (NSUInteger)residentByteCount;
 @end
 
 @interface SDLocalizationDataSource: NSObject
-@property (nonatomic, strong) SDLocaleModel* selectedLocale;
-@property (nonatomic, strong) SDLocaleModel* baseLocale;
-@property (nonatomic, strong) SDLocaleModel* defaultLocale;
+/**
+ * @param languageIDs The fallback chain of the selected locale, from the selected locale itself to the default one.
+ *
+ * Locale models of the previous data source with the same language ID are reused, together with their loaded tables.
+ */
+- (instancetype)initWithLanguageIDs:(NSArray<NSString*>*)languageIDs reusingLocalesOfDataSource:(SDLocalizationDataSource*)dataSource;
+/**
+ * Distinct locales to search, in order of precedence: the first one is the selected locale, the last one the default locale.
+ */
+@property (nonatomic, strong, readonly) NSArray<SDLocaleModel*>* tiers;
+/**
+ * Merged tables by bundle identifier and table name.
+ *
+ * The dictionary is immutable and it is replaced atomically by every change (copy on write), so it can be read from any thread without locks.
+ * Methods that change the data source must instead be called by one writer at a time.
+ */
+@property (atomic, strong, readonly) NSDictionary<NSString*, NSDictionary<NSString*, SDResolvedTable*>*>* resolvedTablesByBundleId;
+/**
+ * Sum of the generations of the tiers: it changes with every invalidation of any of them, made through this data source or through another one sharing the locale, so that merged tables built meanwhile are not published.
+ */
+@property (nonatomic, readonly) NSUInteger generation;
+- (SDResolvedTable*)resolvedTableWithName:(NSString*)tableName bundleIdentifier:(NSString*)bundleIdentifier;
+- (void)addResolvedTable:(SDResolvedTable*)table;
+/**
+ * Drops the dynamic table with the given name in the tiers of the given localization and all the merged tables with that name, so that they are rebuilt on the next lookup.
+ */
+- (void)invalidateTableWithName:(NSString*)tableName forLocalization:(NSString*)localization;
+/**
+ * Like invalidateTableWithName:forLocalization:, publishing the merged tables once for all the given names.
+ */
+- (void)invalidateTablesWithNames:(NSArray<NSString*>*)tableNames forLocalization:(NSString*)localization;
+/**
+ * Invalidates the table like invalidateTableWithName:forLocalization:, but keeps the dynamic table if it is loaded, updated in memory with the given strings instead of being read again from disk.
+ */
+- (void)addStrings:(NSDictionary<NSString*, NSString*>*)strings toTableWithName:(NSString*)tableName forLocalization:(NSString*)localization;
+/**
+ * Estimated bytes of the loaded tables of all tiers and of the merged tables: the running counts kept as tables are added and dropped, so reading it does not scan the tables. Interned strings are charged to the table that added them to the pool.
+ */
+- (NSUInteger)residentByteCount;
+/**
+ * Estimated bytes of the merged table with the given name and of the tables it is merged from, or 0 if it is not loaded.
+ */
+- (NSUInteger)residentByteCountOfTableWithName:(NSString*)tableName bundleIdentifier:(NSString*)bundleIdentifier;
+/**
+ * Drops the least recently used merged tables, together with the tables they are merged from, until the resident bytes fit the given limit. Tables of the main bundle and added strings are kept while a merged table of another bundle still uses them.
+ *
+ * The bytes freed by each dropped table are measured on that table alone: its interned strings referenced by any other table, and content still used by the merged tables of the given data sources, are not freed. The most recently used merged table is never dropped, even if it exceeds the limit alone. Dropped tables are loaded again by the next lookup.
+ *
+ * @param dataSources The other live data sources, which may share locale models and contents with the receiver.
+ *
+ * @return The number of merged tables dropped.
+ */
+- (NSUInteger)evictTablesToFitByteLimit:(NSUInteger)byteLimit sharingTablesWithDataSources:(NSArray<SDLocalizationDataSource*>*)dataSources;
+@end
+
+/**
+ * Immutable snapshot of the formatting preferences saved in user defaults. Each snapshot with different values has a higher version.
+ */
+@interface SDFormattingSettings: NSObject
+- (instancetype)initWithValues:(NSDictionary<NSString*, NSString*>*)values version:(NSUInteger)version;
+@property (nonatomic, strong, readonly) NSDictionary<NSString*, NSString*>* values;
+@property (nonatomic, assign, readonly) NSUInteger version;
+- (NSString*)stringForKey:(NSString*)key;
 @end
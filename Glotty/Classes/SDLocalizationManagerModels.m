@@ -6,7 +6,21 @@
 //
 
 #import "SDLocalizationManagerModels.h"
+#import "GTYStringsPack.h"
+#import "GTYStringTemplate.h"
+#import "GTYCompactTable.h"
 #define DYNAMIC_BUNDLE_IDENTIFIER @"DYNAMIC"
+// estimated overhead of an entry: two string objects and the slot of the hash table
+#define kEntryOverheadByteCount 64
+// estimated size of a slot of a merged dictionary, whose keys and values belong to other tables
+#define kMergedEntryByteCount 16
+
+@interface SDLocalizationTable ()
+{
+    NSUInteger _residentByteCount;
+    BOOL _hasResidentByteCount;
+}
+@end
 
 @implementation SDLocalizationTable
 - (instancetype)init
@@ -14,10 +28,353 @@
     self = [super init];
     if (self)
     {
-        self.content = [NSMutableDictionary new];
+        self.content = [NSDictionary new];
     }
     return self;
 }
+
+- (NSUInteger)residentByteCount
+{
+    if (!_hasResidentByteCount && [self.content isKindOfClass:[GTYCompactTable class]])
+    {
+        _residentByteCount = ((GTYCompactTable*)self.content).byteSize;
+        _hasResidentByteCount = YES;
+    }
+    else if (!_hasResidentByteCount)
+    {
+        __block NSUInteger byteCount = 0;
+        [self.content enumerateKeysAndObjectsUsingBlock:^(NSString* key, NSString* string, BOOL* stop) {
+            byteCount += (key.length + string.length) * sizeof(unichar) + kEntryOverheadByteCount;
+        }];
+        _residentByteCount = byteCount;
+        _hasResidentByteCount = YES;
+    }
+    return _residentByteCount;
+}
+
+- (NSUInteger)chargedByteCount
+{
+    NSUInteger byteCount = [self residentByteCount];
+    if ([self.content isKindOfClass:[GTYCompactTable class]])
+    {
+        byteCount += ((GTYCompactTable*)self.content).internedByteCount;
+    }
+    return byteCount;
+}
+
+- (NSString*)stringForKey:(NSString*)key
+{
+    NSString* value = self.content[key];
+    if (!value)
+    {
+        value = [self.pack stringForKey:key];
+    }
+    return value;
+}
+
+- (void)enumerateKeysAndStringsUsingBlock:(void (^)(NSString* key, NSString* string, BOOL* stop))block
+{
+    __block BOOL stopped = NO;
+    [self.content enumerateKeysAndObjectsUsingBlock:^(NSString* key, NSString* string, BOOL* stop) {
+        block(key, string, stop);
+        stopped = *stop;
+    }];
+    if (!stopped)
+    {
+        [self.pack enumerateKeysAndStringsUsingBlock:block];
+    }
+}
+
+- (void)addMissingEntriesToBuilder:(GTYCompactTableBuilder*)builder shadowedByPacks:(NSArray<GTYStringsPack*>*)packs usingBlock:(void (^)(NSString* key))block
+{
+    if ([self.content isKindOfClass:[GTYCompactTable class]])
+    {
+        BOOL (^predicate)(const char*, NSUInteger) = nil;
+        if (packs.count > 0)
+        {
+            predicate = ^BOOL(const char* keyBytes, NSUInteger keyLength) {
+                for (GTYStringsPack* pack in packs)
+                {
+                    if ([pack containsStringForKeyBytes:keyBytes length:keyLength])
+                    {
+                        return NO;
+                    }
+                }
+                return YES;
+            };
+        }
+        [builder addMissingEntriesOfTable:(GTYCompactTable*)self.content passingTest:predicate usingBlock:block];
+        return;
+    }
+    
+    [self.content enumerateKeysAndObjectsUsingBlock:^(NSString* key, NSString* string, BOOL* stop) {
+        for (GTYStringsPack* pack in packs)
+        {
+            if ([pack containsStringForKey:key])
+            {
+                return;
+            }
+        }
+        if ([builder addString:string forKey:key replacingExisting:NO] && block)
+        {
+            block(key);
+        }
+    }];
+}
+@end
+
+#define kTemplatesCountLimit 512
+
+static NSComparisonResult SDCompareKeys(NSString* key1, NSString* key2)
+{
+    return [key1 compare:key2 options:NSLiteralSearch];
+}
+
+@interface SDResolvedTable ()
+{
+    // counters copied out of the array, read by every lookup
+    SDLocalizationCounter* _sourceCounters;
+    NSUInteger _sourceCount;
+    BOOL _compactContent;
+}
+@property (nonatomic, strong) NSCache<NSString*, GTYStringTemplate*>* templates;
+@property (atomic, strong, readwrite) NSArray<NSString*>* sortedKeys;
+/**
+ * Values by key ID, with NSNull for keys without value.
+ */
+@property (atomic, strong) NSArray* valuesByKeyID;
+@end
+
+@implementation SDResolvedTable
+- (instancetype)init
+{
+    self = [super init];
+    if (self)
+    {
+        self.templates = [NSCache new];
+        self.templates.countLimit = kTemplatesCountLimit;
+    }
+    return self;
+}
+
+- (void)dealloc
+{
+    free(_sourceCounters);
+}
+
+- (void)setContent:(NSDictionary<NSString*, NSString*>*)content
+{
+    _content = content;
+    _compactContent = [content isKindOfClass:[GTYCompactTable class]];
+}
+
+- (void)setCounters:(NSArray<NSNumber*>*)counters
+{
+    _counters = [counters copy];
+    free(_sourceCounters);
+    _sourceCount = counters.count;
+    _sourceCounters = malloc(MAX(_sourceCount, 1) * sizeof(SDLocalizationCounter));
+    for (NSUInteger index = 0; index < _sourceCount; index++)
+    {
+        _sourceCounters[index] = counters[index].unsignedIntegerValue;
+    }
+}
+
+/**
+ * Returns the counter of the given source, or the one of the highest table if counters are not set.
+ */
+- (SDLocalizationCounter)counterOfSource:(NSUInteger)source
+{
+    if (source < _sourceCount)
+    {
+        return _sourceCounters[source];
+    }
+    return _sourceCount > 0 ? _sourceCounters[0] : SDLocalizationCounterForLookup(SDLocalizationTierSelected, SDLocalizationSourceMainBundle);
+}
+
+- (NSUInteger)residentByteCount
+{
+    if (self.sharesContent)
+    {
+        return 0;
+    }
+    if ([self.content isKindOfClass:[GTYCompactTable class]])
+    {
+        return ((GTYCompactTable*)self.content).byteSize;
+    }
+    return self.content.count * kMergedEntryByteCount;
+}
+
+- (NSUInteger)chargedByteCount
+{
+    NSUInteger byteCount = [self residentByteCount];
+    if (!self.sharesContent && _compactContent)
+    {
+        byteCount += ((GTYCompactTable*)self.content).internedByteCount;
+    }
+    return byteCount;
+}
+
+- (NSString*)stringForKey:(NSString*)key
+{
+    NSString* value = self.content[key];
+    if (!value)
+    {
+        for (GTYStringsPack* pack in self.packs)
+        {
+            value = [pack stringForKey:key];
+            if (value)
+            {
+                break;
+            }
+        }
+    }
+    return value;
+}
+
+- (NSString*)stringForKey:(NSString*)key counter:(SDLocalizationCounter*)counter
+{
+    // a single probe gives both the value and the table it comes from
+    uint8_t source = 0;
+    NSString* value = _compactContent ? [(GTYCompactTable*)_content objectForKey:key source:&source] : _content[key];
+    if (value)
+    {
+        *counter = [self counterOfSource:source];
+        return value;
+    }
+    NSArray<GTYStringsPack*>* packs = self.packs;
+    if (packs.count == 0)
+    {
+        return nil;
+    }
+    // the packs follow the tables with content
+    NSUInteger firstPackSource = _sourceCount - MIN(packs.count, _sourceCount);
+    for (NSUInteger index = 0; index < packs.count; index++)
+    {
+        value = [packs[index] stringForKey:key];
+        if (value)
+        {
+            *counter = [self counterOfSource:firstPackSource + index];
+            return value;
+        }
+    }
+    return nil;
+}
+
+- (SDLocalizationCounter)lookupCounterForKey:(NSString*)key
+{
+    SDLocalizationCounter counter = [self counterOfSource:0];
+    [self stringForKey:key counter:&counter];
+    return counter;
+}
+
+- (GTYStringTemplate*)templateForKey:(NSString*)key placeholderDictionary:(NSDictionary<NSString*, NSString*>*)placeholderDictionary
+{
+    GTYStringTemplate* template = [self.templates objectForKey:key];
+    if ([template hasPlaceholdersOfDictionary:placeholderDictionary])
+    {
+        return template;
+    }
+    
+    NSString* value = [self stringForKey:key];
+    if (!value)
+    {
+        return nil;
+    }
+    // the last parsed set of placeholders replaces the previous one, since a key is usually formatted always with the same placeholders
+    template = [[GTYStringTemplate alloc] initWithString:value placeholders:placeholderDictionary.allKeys];
+    [self.templates setObject:template forKey:key];
+    return template;
+}
+
+- (NSArray<NSString*>*)sortedKeys
+{
+    NSArray<NSString*>* sortedKeys = _sortedKeys;
+    if (!sortedKeys)
+    {
+        // content and packs are immutable, so concurrent builds give the same array
+        NSArray<NSString*>* keys = self.content.allKeys;
+        if (self.packs.count > 0)
+        {
+            NSMutableSet<NSString*>* allKeys = [NSMutableSet setWithArray:keys];
+            for (GTYStringsPack* pack in self.packs)
+            {
+                [allKeys addObjectsFromArray:[pack allKeysWithStrings]];
+            }
+            keys = allKeys.allObjects;
+        }
+        sortedKeys = [keys sortedArrayUsingComparator:^NSComparisonResult(NSString* key1, NSString* key2) {
+            return SDCompareKeys(key1, key2);
+        }];
+        self.sortedKeys = sortedKeys;
+    }
+    return sortedKeys;
+}
+
+- (NSUInteger)indexOfFirstKeyNotLessThan:(NSString*)key inKeys:(NSArray<NSString*>*)keys
+{
+    return [keys indexOfObject:key inSortedRange:NSMakeRange(0, keys.count) options:NSBinarySearchingFirstEqual | NSBinarySearchingInsertionIndex usingComparator:^NSComparisonResult(NSString* key1, NSString* key2) {
+        return SDCompareKeys(key1, key2);
+    }];
+}
+
+- (NSArray<NSString*>*)keysWithPrefix:(NSString*)prefix
+{
+    NSArray<NSString*>* keys = self.sortedKeys;
+    if (prefix.length == 0)
+    {
+        return keys;
+    }
+    
+    NSUInteger start = [self indexOfFirstKeyNotLessThan:prefix inKeys:keys];
+    NSUInteger end = start;
+    while (end < keys.count && [keys[end] hasPrefix:prefix])
+    {
+        end++;
+    }
+    return [keys subarrayWithRange:NSMakeRange(start, end - start)];
+}
+
+- (NSArray<NSString*>*)keysFromKey:(NSString*)fromKey toKey:(NSString*)toKey
+{
+    NSArray<NSString*>* keys = self.sortedKeys;
+    NSUInteger start = fromKey ? [self indexOfFirstKeyNotLessThan:fromKey inKeys:keys] : 0;
+    NSUInteger end = toKey ? [self indexOfFirstKeyNotLessThan:toKey inKeys:keys] : keys.count;
+    if (end <= start)
+    {
+        return @[];
+    }
+    return [keys subarrayWithRange:NSMakeRange(start, end - start)];
+}
+
+- (NSString*)stringForKeyID:(uint32_t)keyID
+{
+    NSArray* valuesByKeyID = self.valuesByKeyID;
+    if (!valuesByKeyID && self.keyIDPack)
+    {
+        // values are read in order of precedence, so dynamic strings override the values of the pack
+        NSMutableArray* values = [NSMutableArray arrayWithCapacity:self.keyIDPack.count];
+        for (NSUInteger index = 0; index < self.keyIDPack.count; index++)
+        {
+            NSString* key = [self.keyIDPack keyAtIndex:index];
+            [values addObject:(key ? [self stringForKey:key] : nil) ?: [NSNull null]];
+        }
+        valuesByKeyID = [values copy];
+        self.valuesByKeyID = valuesByKeyID;
+    }
+    
+    if (keyID >= valuesByKeyID.count)
+    {
+        return nil;
+    }
+    id value = valuesByKeyID[keyID];
+    return value == [NSNull null] ? nil : value;
+}
+@end
+
+@interface SDTablesBundle ()
+@property (nonatomic, strong) NSMutableDictionary<NSString*, SDLocalizationTable*>* mutableTablesByName;
+@property (nonatomic, assign, readwrite) NSUInteger residentByteCount;
 @end
 
 @implementation SDTablesBundle
@@ -26,11 +383,44 @@
     self = [super init];
     if (self)
     {
-        self.tablesByName = [NSMutableDictionary new];
+        self.mutableTablesByName = [NSMutableDictionary new];
+        self.missingTableNames = [NSMutableSet new];
     }
     return self;
 }
 
+- (NSDictionary<NSString*, SDLocalizationTable*>*)tablesByName
+{
+    return self.mutableTablesByName;
+}
+
+- (void)addTable:(SDLocalizationTable*)table
+{
+    SDLocalizationTable* previousTable = self.mutableTablesByName[table.name];
+    if (previousTable)
+    {
+        self.residentByteCount -= MIN(previousTable.chargedByteCount, self.residentByteCount);
+    }
+    self.mutableTablesByName[table.name] = table;
+    self.residentByteCount += table.chargedByteCount;
+}
+
+- (NSArray<SDLocalizationTable*>*)removeTablesWithNames:(NSArray<NSString*>*)tableNames
+{
+    NSMutableArray<SDLocalizationTable*>* removedTables = [NSMutableArray arrayWithCapacity:tableNames.count];
+    for (NSString* tableName in tableNames)
+    {
+        SDLocalizationTable* table = self.mutableTablesByName[tableName];
+        if (table)
+        {
+            self.residentByteCount -= MIN(table.chargedByteCount, self.residentByteCount);
+            [self.mutableTablesByName removeObjectForKey:tableName];
+            [removedTables addObject:table];
+        }
+    }
+    return removedTables;
+}
+
 + (SDTablesBundle*)dynamicTablesBundle
 {
     SDTablesBundle* bundle = [SDTablesBundle new];
@@ -58,18 +448,355 @@
     }
     return self;
 }
+
+- (NSUInteger)residentByteCount
+{
+    NSUInteger byteCount = self.dynamic.residentByteCount + self.main.residentByteCount;
+    for (SDTablesBundle* tablesBundle in self.bundlesById.allValues)
+    {
+        byteCount += tablesBundle.residentByteCount;
+    }
+    return byteCount;
+}
+@end
+
+@interface SDLocalizationDataSource ()
+@property (atomic, strong, readwrite) NSDictionary<NSString*, NSDictionary<NSString*, SDResolvedTable*>*>* resolvedTablesByBundleId;
+/**
+ * Sum of the charged bytes of the published merged tables.
+ */
+@property (nonatomic, assign) NSUInteger resolvedByteCount;
 @end
 
 @implementation SDLocalizationDataSource
 - (instancetype)init
+{
+    return [self initWithLanguageIDs:@[] reusingLocalesOfDataSource:nil];
+}
+
+- (instancetype)initWithLanguageIDs:(NSArray<NSString*>*)languageIDs reusingLocalesOfDataSource:(SDLocalizationDataSource*)dataSource
+{
+    self = [super init];
+    if (self)
+    {
+        self.resolvedTablesByBundleId = @{};
+        
+        NSMutableArray* tiers = [NSMutableArray arrayWithCapacity:languageIDs.count];
+        NSMutableSet* addedLanguageIDs = [NSMutableSet setWithCapacity:languageIDs.count];
+        for (NSString* languageID in languageIDs)
+        {
+            if (languageID.length > 0 && ![addedLanguageIDs containsObject:languageID])
+            {
+                SDLocaleModel* locale = [dataSource localeWithLanguageID:languageID] ?: [SDLocaleModel new];
+                locale.languageID = languageID;
+                [tiers addObject:locale];
+                [addedLanguageIDs addObject:languageID];
+            }
+        }
+        _tiers = [tiers copy];
+    }
+    return self;
+}
+
+- (SDLocaleModel*)localeWithLanguageID:(NSString*)languageID
+{
+    if (languageID.length == 0)
+    {
+        return nil;
+    }
+    for (SDLocaleModel* locale in self.tiers)
+    {
+        if ([locale.languageID isEqualToString:languageID])
+        {
+            return locale;
+        }
+    }
+    return nil;
+}
+
+- (NSUInteger)generation
+{
+    // generations only grow, so the sum changes whenever one of them does
+    NSUInteger generation = 0;
+    for (SDLocaleModel* locale in self.tiers)
+    {
+        generation += locale.generation;
+    }
+    return generation;
+}
+
+- (SDResolvedTable*)resolvedTableWithName:(NSString*)tableName bundleIdentifier:(NSString*)bundleIdentifier
+{
+    return self.resolvedTablesByBundleId[bundleIdentifier][tableName];
+}
+
+- (void)addResolvedTable:(SDResolvedTable*)table
+{
+    NSMutableDictionary* resolvedTablesByBundleId = [self.resolvedTablesByBundleId mutableCopy];
+    NSMutableDictionary* tablesByName = [resolvedTablesByBundleId[table.bundleIdentifier] mutableCopy] ?: [NSMutableDictionary new];
+    [self dropChargeOfResolvedTable:tablesByName[table.name]];
+    tablesByName[table.name] = table;
+    self.resolvedByteCount += table.chargedByteCount;
+    resolvedTablesByBundleId[table.bundleIdentifier] = [tablesByName copy];
+    
+    // publish the new snapshot: readers still holding the previous one keep using it
+    self.resolvedTablesByBundleId = [resolvedTablesByBundleId copy];
+}
+
+- (void)invalidateTableWithName:(NSString*)tableName forLocalization:(NSString*)localization
+{
+    [self invalidateTablesWithNames:@[tableName] forLocalization:localization];
+}
+
+- (void)invalidateTablesWithNames:(NSArray<NSString*>*)tableNames forLocalization:(NSString*)localization
+{
+    SDLocaleModel* locale = [self localeWithLanguageID:localization];
+    if (!locale || tableNames.count == 0)
+    {
+        // the localization is not one of the tiers, so nothing depends on it
+        return;
+    }
+    locale.generation++;
+    [locale.dynamic removeTablesWithNames:tableNames];
+    for (NSString* tableName in tableNames)
+    {
+        [locale.dynamic.missingTableNames removeObject:tableName];
+    }
+    
+    NSMutableDictionary* resolvedTablesByBundleId = [NSMutableDictionary dictionaryWithCapacity:self.resolvedTablesByBundleId.count];
+    [self.resolvedTablesByBundleId enumerateKeysAndObjectsUsingBlock:^(NSString* bundleIdentifier, NSDictionary<NSString*, SDResolvedTable*>* tablesByName, BOOL* stop) {
+        NSMutableDictionary* newTablesByName = [tablesByName mutableCopy];
+        for (NSString* tableName in tableNames)
+        {
+            [self dropChargeOfResolvedTable:tablesByName[tableName]];
+        }
+        [newTablesByName removeObjectsForKeys:tableNames];
+        resolvedTablesByBundleId[bundleIdentifier] = [newTablesByName copy];
+    }];
+    self.resolvedTablesByBundleId = [resolvedTablesByBundleId copy];
+}
+
+- (void)addStrings:(NSDictionary<NSString*, NSString*>*)strings toTableWithName:(NSString*)tableName forLocalization:(NSString*)localization
+{
+    SDLocaleModel* locale = [self localeWithLanguageID:localization];
+    SDLocalizationTable* table = locale.dynamic.tablesByName[tableName];
+    [self invalidateTableWithName:tableName forLocalization:localization];
+    if (table)
+    {
+        // the loaded content may be shared with a published merged table, so it is copied
+        SDLocalizationTable* updatedTable = [SDLocalizationTable new];
+        updatedTable.name = tableName;
+        NSMutableDictionary* content = [table.content mutableCopy];
+        [content addEntriesFromDictionary:strings];
+        updatedTable.content = content;
+        [locale.dynamic addTable:updatedTable];
+    }
+}
+
+/**
+ * Removes the charge of the given merged table, if any, from the running count.
+ */
+- (void)dropChargeOfResolvedTable:(SDResolvedTable*)table
+{
+    if (table)
+    {
+        self.resolvedByteCount -= MIN(table.chargedByteCount, self.resolvedByteCount);
+    }
+}
+
+- (NSUInteger)residentByteCount
+{
+    NSUInteger byteCount = self.resolvedByteCount;
+    for (SDLocaleModel* locale in self.tiers)
+    {
+        byteCount += [locale residentByteCount];
+    }
+    return byteCount;
+}
+
+- (NSUInteger)residentByteCountOfTableWithName:(NSString*)tableName bundleIdentifier:(NSString*)bundleIdentifier
+{
+    SDResolvedTable* resolvedTable = [self resolvedTableWithName:tableName bundleIdentifier:bundleIdentifier];
+    if (!resolvedTable)
+    {
+        return 0;
+    }
+    NSMutableArray* tables = [NSMutableArray arrayWithObject:resolvedTable];
+    for (SDLocaleModel* locale in self.tiers)
+    {
+        NSMutableArray<SDTablesBundle*>* tablesBundles = [NSMutableArray arrayWithObjects:locale.dynamic, locale.main, nil];
+        SDTablesBundle* bundleTables = locale.bundlesById[bundleIdentifier];
+        if (bundleTables)
+        {
+            [tablesBundles addObject:bundleTables];
+        }
+        for (SDTablesBundle* tablesBundle in tablesBundles)
+        {
+            SDLocalizationTable* table = tablesBundle.tablesByName[tableName];
+            if (table)
+            {
+                [tables addObject:table];
+            }
+        }
+    }
+    
+    // measured on the tables of this table only, with the interned strings counted once
+    NSUInteger byteCount = 0;
+    NSMutableArray<GTYCompactTable*>* compactTables = [NSMutableArray arrayWithCapacity:tables.count];
+    for (id table in tables)
+    {
+        byteCount += [table residentByteCount];
+        // shared content is counted with the table that owns it
+        BOOL sharesContent = [table isKindOfClass:[SDResolvedTable class]] && ((SDResolvedTable*)table).sharesContent;
+        if (!sharesContent && [[table content] isKindOfClass:[GTYCompactTable class]])
+        {
+            [compactTables addObject:[table content]];
+        }
+    }
+    return byteCount + [GTYCompactTable internedByteCountOfTables:compactTables exclusive:NO];
+}
+
+/**
+ * Bytes freed by releasing the given SDLocalizationTable and SDResolvedTable objects: their blocks and the interned strings that no other table references.
+ *
+ * @param liveContents Contents still used by other data sources, which are not freed.
+ */
+- (NSUInteger)freedByteCountOfTables:(NSArray*)tables liveContents:(NSHashTable*)liveContents
+{
+    NSUInteger byteCount = 0;
+    NSMutableArray<GTYCompactTable*>* compactTables = [NSMutableArray arrayWithCapacity:tables.count];
+    for (id table in tables)
+    {
+        BOOL sharesContent = [table isKindOfClass:[SDResolvedTable class]] && ((SDResolvedTable*)table).sharesContent;
+        if (sharesContent || [liveContents containsObject:[table content]])
+        {
+            continue;
+        }
+        byteCount += [table residentByteCount];
+        if ([[table content] isKindOfClass:[GTYCompactTable class]])
+        {
+            [compactTables addObject:[table content]];
+        }
+    }
+    return byteCount + [GTYCompactTable internedByteCountOfTables:compactTables exclusive:YES];
+}
+
+- (NSUInteger)evictTablesToFitByteLimit:(NSUInteger)byteLimit sharingTablesWithDataSources:(NSArray<SDLocalizationDataSource*>*)dataSources
+{
+    NSUInteger residentByteCount = [self residentByteCount];
+    if (residentByteCount <= byteLimit)
+    {
+        return 0;
+    }
+    
+    NSMutableArray<SDResolvedTable*>* candidates = [NSMutableArray array];
+    NSMutableDictionary<NSString*, NSMutableDictionary<NSString*, SDResolvedTable*>*>* resolvedTablesByBundleId = [NSMutableDictionary dictionaryWithCapacity:self.resolvedTablesByBundleId.count];
+    [self.resolvedTablesByBundleId enumerateKeysAndObjectsUsingBlock:^(NSString* bundleIdentifier, NSDictionary<NSString*, SDResolvedTable*>* tablesByName, BOOL* stop) {
+        [candidates addObjectsFromArray:tablesByName.allValues];
+        resolvedTablesByBundleId[bundleIdentifier] = [tablesByName mutableCopy];
+    }];
+    [candidates sortUsingComparator:^NSComparisonResult(SDResolvedTable* table1, SDResolvedTable* table2) {
+        uint64_t tick1 = table1.lastAccessTick;
+        uint64_t tick2 = table2.lastAccessTick;
+        return tick1 < tick2 ? NSOrderedAscending : (tick1 > tick2 ? NSOrderedDescending : NSOrderedSame);
+    }];
+    [candidates removeLastObject];
+    
+    // the other data sources share the locale models, so the tables they still use are those of their merged tables
+    NSHashTable* liveContents = [NSHashTable hashTableWithOptions:NSPointerFunctionsStrongMemory | NSPointerFunctionsObjectPointerPersonality];
+    for (SDLocalizationDataSource* dataSource in dataSources)
+    {
+        if (dataSource == self)
+        {
+            continue;
+        }
+        for (NSDictionary<NSString*, SDResolvedTable*>* tablesByName in dataSource.resolvedTablesByBundleId.allValues)
+        {
+            for (SDResolvedTable* table in tablesByName.allValues)
+            {
+                [liveContents addObject:table.content];
+            }
+        }
+    }
+    
+    NSUInteger evictedCount = 0;
+    NSUInteger remainingByteCount = residentByteCount;
+    for (SDResolvedTable* table in candidates)
+    {
+        if (remainingByteCount <= byteLimit)
+        {
+            break;
+        }
+        [resolvedTablesByBundleId[table.bundleIdentifier] removeObjectForKey:table.name];
+        [self dropChargeOfResolvedTable:table];
+        NSMutableArray* droppedTables = [NSMutableArray arrayWithObject:table];
+        [droppedTables addObjectsFromArray:[self removeTablesMergedIntoTable:table remainingResolvedTables:resolvedTablesByBundleId]];
+        // strings shared with tables dropped before are not counted by either of them: the estimate errs on the side of evicting more
+        NSUInteger freedByteCount = [self freedByteCountOfTables:droppedTables liveContents:liveContents];
+        remainingByteCount -= MIN(freedByteCount, remainingByteCount);
+        evictedCount++;
+    }
+    
+    NSMutableDictionary* publishedTablesByBundleId = [NSMutableDictionary dictionaryWithCapacity:resolvedTablesByBundleId.count];
+    [resolvedTablesByBundleId enumerateKeysAndObjectsUsingBlock:^(NSString* bundleIdentifier, NSMutableDictionary<NSString*, SDResolvedTable*>* tablesByName, BOOL* stop) {
+        publishedTablesByBundleId[bundleIdentifier] = [tablesByName copy];
+    }];
+    self.resolvedTablesByBundleId = [publishedTablesByBundleId copy];
+    return evictedCount;
+}
+
+/**
+ * Removes from the tiers the tables merged into the given one that no remaining merged table uses.
+ *
+ * @return The removed tables.
+ */
+- (NSArray<SDLocalizationTable*>*)removeTablesMergedIntoTable:(SDResolvedTable*)resolvedTable remainingResolvedTables:(NSDictionary<NSString*, NSDictionary<NSString*, SDResolvedTable*>*>*)resolvedTablesByBundleId
+{
+    NSString* tableName = resolvedTable.name;
+    __block BOOL sharedTables = NO;
+    [resolvedTablesByBundleId enumerateKeysAndObjectsUsingBlock:^(NSString* bundleIdentifier, NSDictionary<NSString*, SDResolvedTable*>* tablesByName, BOOL* stop) {
+        // merged tables of all bundles use the tables of the main bundle and of added strings
+        sharedTables = tablesByName[tableName] != nil;
+        *stop = sharedTables;
+    }];
+    
+    NSMutableArray<SDLocalizationTable*>* removedTables = [NSMutableArray array];
+    for (SDLocaleModel* locale in self.tiers)
+    {
+        NSMutableArray<SDTablesBundle*>* tablesBundles = [NSMutableArray arrayWithCapacity:3];
+        SDTablesBundle* bundleTables = locale.bundlesById[resolvedTable.bundleIdentifier];
+        if (bundleTables)
+        {
+            [tablesBundles addObject:bundleTables];
+        }
+        if (!sharedTables)
+        {
+            [tablesBundles addObject:locale.dynamic];
+            [tablesBundles addObject:locale.main];
+        }
+        for (SDTablesBundle* tablesBundle in tablesBundles)
+        {
+            [removedTables addObjectsFromArray:[tablesBundle removeTablesWithNames:@[tableName]]];
+        }
+    }
+    return removedTables;
+}
+@end
+
+@implementation SDFormattingSettings
+- (instancetype)initWithValues:(NSDictionary<NSString*, NSString*>*)values version:(NSUInteger)version
 {
     self = [super init];
     if (self)
     {
-        self.selectedLocale = [SDLocaleModel new];
-        self.baseLocale = [SDLocaleModel new];
-        self.defaultLocale = [SDLocaleModel new];
+        _values = [values copy];
+        _version = version;
     }
     return self;
 }
+
+- (NSString*)stringForKey:(NSString*)key
+{
+    return self.values[key];
+}
 @end
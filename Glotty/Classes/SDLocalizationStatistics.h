@@ -0,0 +1,109 @@
+// Copyright 2017 Sysdata S.p.A.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#import <Foundation/Foundation.h>
+
+/**
+ * The position of a locale in the fallback chain of the selected locale.
+ */
+typedef NS_ENUM(NSUInteger, SDLocalizationTier)
+{
+    SDLocalizationTierSelected = 0,
+    /** Any locale between the selected and the default one, e.g. the generic language of the selected locale. */
+    SDLocalizationTierFallback,
+    SDLocalizationTierDefault,
+};
+#define SDLocalizationTierCount 3
+
+/**
+ * Where a string comes from, in a locale of the fallback chain.
+ */
+typedef NS_ENUM(NSUInteger, SDLocalizationSource)
+{
+    /** Strings added by code. */
+    SDLocalizationSourceDynamic = 0,
+    SDLocalizationSourceMainBundle,
+    /** The bundle of the class passed to the lookup, when it is not the main bundle. */
+    SDLocalizationSourceBundle,
+};
+#define SDLocalizationSourceCount 3
+
+typedef NS_ENUM(NSUInteger, SDLocalizationCounter)
+{
+    /** Lookups served by each tier and source: see SDLocalizationCounterForLookup(). */
+    SDLocalizationCounterLookups = 0,
+    /** Lookups by key ID served by a packed value. */
+    SDLocalizationCounterKeyIDLookups = SDLocalizationTierCount * SDLocalizationSourceCount,
+    /** Lookups that found no value and returned the given default value. */
+    SDLocalizationCounterDefaultValueReturns,
+    /** Lookups that found no value and returned the key. */
+    SDLocalizationCounterKeyReturns,
+    SDLocalizationCounterTableLoads,
+    /** Size on disk of the files and compiled packs read by table loads from bundles, not their memory: see loadedTablesByteCount of SDLocalizationManager. Tables of added strings are not counted. */
+    SDLocalizationCounterTableLoadBytes,
+    SDLocalizationCounterTableLoadNanoseconds,
+    /** Merged tables unloaded to fit loadedTablesByteLimit of SDLocalizationManager. */
+    SDLocalizationCounterTableEvictions,
+    SDLocalizationCounterLocaleSwitches,
+    SDLocalizationCounterLocaleSwitchNanoseconds,
+    SDLocalizationCounterCount
+};
+
+static inline SDLocalizationCounter SDLocalizationCounterForLookup(SDLocalizationTier tier, SDLocalizationSource source)
+{
+    return (SDLocalizationCounter)(SDLocalizationCounterLookups + tier * SDLocalizationSourceCount + source);
+}
+
+/**
+ * An immutable snapshot of the counters of SDLocalizationManager, taken by its statistics method.
+ *
+ * Counters are updated without locks, so a snapshot taken during lookups may be slightly behind on some of them.
+ */
+@interface SDLocalizationStatistics : NSObject
+
+- (instancetype) initWithCounters:(const uint64_t*)counters;
+
+- (uint64_t) valueOfCounter:(SDLocalizationCounter)counter;
+
+/**
+ * Lookups served by the given tier and source.
+ */
+- (uint64_t) lookupsServedByTier:(SDLocalizationTier)tier source:(SDLocalizationSource)source;
+
+/**
+ * Lookups served by any tier and source.
+ */
+@property (nonatomic, readonly) uint64_t lookupsServed;
+@property (nonatomic, readonly) uint64_t keyIDLookups;
+@property (nonatomic, readonly) uint64_t defaultValueReturns;
+@property (nonatomic, readonly) uint64_t keyReturns;
+@property (nonatomic, readonly) uint64_t tableLoads;
+@property (nonatomic, readonly) uint64_t tableLoadBytes;
+/**
+ * Total time spent loading and parsing tables, in seconds.
+ */
+@property (nonatomic, readonly) NSTimeInterval tableLoadDuration;
+@property (nonatomic, readonly) uint64_t tableEvictions;
+@property (nonatomic, readonly) uint64_t localeSwitches;
+/**
+ * Total time spent switching the selected locale, in seconds. Tables of the new locale are loaded later, by the first lookups, and are counted as table loads.
+ */
+@property (nonatomic, readonly) NSTimeInterval localeSwitchDuration;
+
+/**
+ * Returns the counters by name, e.g. to log them or to send them to analytics.
+ */
+- (NSDictionary<NSString*, NSNumber*>*) dictionaryRepresentation;
+
+@end
@@ -0,0 +1,140 @@
+// Copyright 2017 Sysdata S.p.A.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#import "SDLocalizationStatistics.h"
+
+@implementation SDLocalizationStatistics
+{
+    uint64_t _counters[SDLocalizationCounterCount];
+}
+
+- (instancetype) init
+{
+    return [self initWithCounters:NULL];
+}
+
+- (instancetype) initWithCounters:(const uint64_t*)counters
+{
+    self = [super init];
+    if (self)
+    {
+        if (counters)
+        {
+            memcpy(_counters, counters, sizeof(_counters));
+        }
+    }
+    return self;
+}
+
+- (uint64_t) valueOfCounter:(SDLocalizationCounter)counter
+{
+    return counter < SDLocalizationCounterCount ? _counters[counter] : 0;
+}
+
+- (uint64_t) lookupsServedByTier:(SDLocalizationTier)tier source:(SDLocalizationSource)source
+{
+    if (tier >= SDLocalizationTierCount || source >= SDLocalizationSourceCount)
+    {
+        return 0;
+    }
+    return _counters[SDLocalizationCounterForLookup(tier, source)];
+}
+
+- (uint64_t) lookupsServed
+{
+    uint64_t lookups = 0;
+    for (NSUInteger counter = SDLocalizationCounterLookups; counter < SDLocalizationCounterKeyIDLookups; counter++)
+    {
+        lookups += _counters[counter];
+    }
+    return lookups;
+}
+
+- (uint64_t) keyIDLookups
+{
+    return _counters[SDLocalizationCounterKeyIDLookups];
+}
+
+- (uint64_t) defaultValueReturns
+{
+    return _counters[SDLocalizationCounterDefaultValueReturns];
+}
+
+- (uint64_t) keyReturns
+{
+    return _counters[SDLocalizationCounterKeyReturns];
+}
+
+- (uint64_t) tableLoads
+{
+    return _counters[SDLocalizationCounterTableLoads];
+}
+
+- (uint64_t) tableLoadBytes
+{
+    return _counters[SDLocalizationCounterTableLoadBytes];
+}
+
+- (NSTimeInterval) tableLoadDuration
+{
+    return _counters[SDLocalizationCounterTableLoadNanoseconds] / (NSTimeInterval)NSEC_PER_SEC;
+}
+
+- (uint64_t) tableEvictions
+{
+    return _counters[SDLocalizationCounterTableEvictions];
+}
+
+- (uint64_t) localeSwitches
+{
+    return _counters[SDLocalizationCounterLocaleSwitches];
+}
+
+- (NSTimeInterval) localeSwitchDuration
+{
+    return _counters[SDLocalizationCounterLocaleSwitchNanoseconds] / (NSTimeInterval)NSEC_PER_SEC;
+}
+
+- (NSDictionary<NSString*, NSNumber*>*) dictionaryRepresentation
+{
+    NSArray<NSString*>* tierNames = @[@"selected", @"fallback", @"default"];
+    NSArray<NSString*>* sourceNames = @[@"dynamic", @"main", @"bundle"];
+    NSMutableDictionary<NSString*, NSNumber*>* dictionary = [NSMutableDictionary dictionary];
+    for (NSUInteger tier = 0; tier < SDLocalizationTierCount; tier++)
+    {
+        for (NSUInteger source = 0; source < SDLocalizationSourceCount; source++)
+        {
+            NSString* name = [NSString stringWithFormat:@"lookups.%@.%@", tierNames[tier], sourceNames[source]];
+            dictionary[name] = @([self lookupsServedByTier:tier source:source]);
+        }
+    }
+    dictionary[@"lookups"] = @(self.lookupsServed);
+    dictionary[@"keyIDLookups"] = @(self.keyIDLookups);
+    dictionary[@"defaultValueReturns"] = @(self.defaultValueReturns);
+    dictionary[@"keyReturns"] = @(self.keyReturns);
+    dictionary[@"tableLoads"] = @(self.tableLoads);
+    dictionary[@"tableLoadBytes"] = @(self.tableLoadBytes);
+    dictionary[@"tableLoadDuration"] = @(self.tableLoadDuration);
+    dictionary[@"tableEvictions"] = @(self.tableEvictions);
+    dictionary[@"localeSwitches"] = @(self.localeSwitches);
+    dictionary[@"localeSwitchDuration"] = @(self.localeSwitchDuration);
+    return [dictionary copy];
+}
+
+- (NSString*) description
+{
+    return [NSString stringWithFormat:@"<%@: %p> %@", NSStringFromClass([self class]), self, [self dictionaryRepresentation]];
+}
+
+@end
@@ -0,0 +1,102 @@
+// Copyright 2017 Sysdata S.p.A.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#import <Foundation/Foundation.h>
+
+/**
+ * An immutable dictionary of strings stored in a single block of memory.
+ *
+ * The block holds the entries and an open addressing hash index of them, so a table is allocated and freed at once. Keys and values are UTF-8 strings of the shared GTYStringInternPool: tables of different locales, tiers and merged tables reference the same bytes for the same text, and release them when deallocated.
+ * Key and value objects are created the first time they are requested and then kept by the pool: entries never read cost only their bytes.
+ *
+ * Being an NSDictionary, a table can be used wherever the content of a strings table is expected. Tables are built with GTYCompactTableBuilder.
+ */
+@interface GTYCompactTable : NSDictionary<NSString*, NSString*>
+
+/**
+ * Returns a table with the string entries of the given dictionary.
+ */
++ (instancetype) tableWithStrings:(NSDictionary<NSString*, NSString*>*)strings;
+
+/**
+ * Returns the bytes of memory used by the interned strings of the given tables, each counted once.
+ *
+ * @param exclusive YES to count only the strings that no other table references, i.e. the bytes freed by releasing the tables.
+ */
++ (NSUInteger) internedByteCountOfTables:(NSArray<GTYCompactTable*>*)tables exclusive:(BOOL)exclusive;
+
+/**
+ * Size in bytes of the block of the table, excluding the interned strings.
+ */
+@property (nonatomic, readonly) NSUInteger byteSize;
+
+/**
+ * Bytes of the interned strings the table added to the pool when it was built, i.e. the strings no other table referenced at that time.
+ */
+@property (nonatomic, readonly) NSUInteger internedByteCount;
+
+/**
+ * Returns the value of the given key like objectForKey:, with the source of its entry.
+ *
+ * @param source Set to the source the entry was added with, if the key is found. Can be NULL.
+ */
+- (NSString*) objectForKey:(NSString*)key source:(uint8_t*)source;
+
+@end
+
+/**
+ * Collects the entries of a GTYCompactTable, copying their bytes into a growing buffer indexed by key. The bytes are interned when the table is built.
+ */
+@interface GTYCompactTableBuilder : NSObject
+
+/**
+ * @param capacity Expected number of entries.
+ */
+- (instancetype) initWithCapacity:(NSUInteger)capacity;
+
+@property (nonatomic, readonly) NSUInteger count;
+
+/**
+ * Source of the entries added from now on, e.g. the index of the table they are merged from, stored with each entry of the built table. Tables whose entries all have source 0 store no sources.
+ */
+@property (nonatomic, assign) uint8_t source;
+
+/**
+ * Adds an entry with the given UTF-8 bytes, which are copied. The bytes are not validated.
+ *
+ * @param replace YES to replace the value of an existing key, NO to keep it.
+ *
+ * @return YES if the entry has been added or its value replaced.
+ */
+- (BOOL) addKeyBytes:(const char*)keyBytes length:(NSUInteger)keyLength valueBytes:(const char*)valueBytes length:(NSUInteger)valueLength replacingExisting:(BOOL)replace;
+
+/**
+ * Adds an entry like addKeyBytes:length:valueBytes:length:replacingExisting:, converting the strings to UTF-8.
+ */
+- (BOOL) addString:(NSString*)string forKey:(NSString*)key replacingExisting:(BOOL)replace;
+
+/**
+ * Adds the entries of the given table whose keys are not in the builder yet, copying their bytes.
+ *
+ * @param predicate Called with the UTF-8 bytes of each key, returns NO to skip the entry. Can be nil.
+ * @param block Called with the key of each added entry. Can be nil.
+ */
+- (void) addMissingEntriesOfTable:(GTYCompactTable*)table passingTest:(BOOL (^)(const char* keyBytes, NSUInteger keyLength))predicate usingBlock:(void (^)(NSString* key))block;
+
+/**
+ * Returns a table with the entries added so far. The builder is emptied.
+ */
+- (GTYCompactTable*) build;
+
+@end
@@ -0,0 +1,586 @@
+// Copyright 2017 Sysdata S.p.A.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#import "GTYCompactTable.h"
+#import "GTYStringInternPool.h"
+
+// Layout of the block of a table:
+//
+//   strings  GTYInternedString*[2 * count], key and value of each entry, referenced in the intern pool
+//   slots    GTYCompactSlot[slotCount], hash of the key and index of its entry + 1, 0 for empty slots; slotCount is a power of 2
+//   sources  uint8_t[count], source of each entry, only if some entry has a source other than 0
+//
+// A probe compares the hash in the slot before reading the key, so it reads the interned string only for the matching entry.
+// The builder keeps the bytes of the entries in a buffer of its own, interned when the table is built.
+
+#define GTY_COMPACT_KEY_BUFFER      256
+#define GTY_COMPACT_MIN_SLOTS       8
+
+// an entry of a builder, with offsets in its buffer
+typedef struct
+{
+    uint32_t keyOffset;
+    uint32_t keyLength;
+    uint32_t valueOffset;
+    uint32_t valueLength;
+    uint32_t hash;
+    uint8_t source;
+} GTYCompactEntry;
+
+// a slot of the index of a table
+typedef struct
+{
+    uint32_t hash;
+    uint32_t entry;
+} GTYCompactSlot;
+
+/**
+ * Number of slots keeping the load factor of the index under 3/4.
+ */
+static inline uint32_t GTYCompactSlotCount(NSUInteger count)
+{
+    uint32_t slotCount = GTY_COMPACT_MIN_SLOTS;
+    while (slotCount - slotCount / 4 <= count)
+    {
+        slotCount *= 2;
+    }
+    return slotCount;
+}
+
+/**
+ * Returns the slot of the entry with the given key, or the empty slot where it would be inserted.
+ */
+static inline uint32_t GTYCompactFindSlot(const uint32_t* slots, uint32_t slotMask, const GTYCompactEntry* entries, const char* bytes, const char* keyBytes, size_t keyLength, uint32_t hash)
+{
+    uint32_t slot = hash & slotMask;
+    for (;;)
+    {
+        uint32_t entryIndex = slots[slot];
+        if (entryIndex == 0)
+        {
+            return slot;
+        }
+        const GTYCompactEntry* entry = &entries[entryIndex - 1];
+        if (entry->hash == hash && entry->keyLength == keyLength && memcmp(bytes + entry->keyOffset, keyBytes, keyLength) == 0)
+        {
+            return slot;
+        }
+        slot = (slot + 1) & slotMask;
+    }
+}
+
+/**
+ * Returns the UTF-8 bytes of the given string and their length, without conversion when the string already holds them. The length is explicit, since keys may contain U+0000.
+ */
+static inline const char* GTYCompactUTF8Bytes(NSString* string, char* buffer, size_t bufferLength, size_t* length)
+{
+    const char* bytes = CFStringGetCStringPtr((__bridge CFStringRef)string, kCFStringEncodingUTF8);
+    if (bytes)
+    {
+        // only ASCII strings expose their storage as UTF-8, one byte per character
+        *length = string.length;
+        return bytes;
+    }
+    NSUInteger usedLength = 0;
+    NSRange remainingRange = {0, 0};
+    if ([string getBytes:buffer maxLength:bufferLength usedLength:&usedLength encoding:NSUTF8StringEncoding options:0 range:NSMakeRange(0, string.length) remainingRange:&remainingRange] && remainingRange.length == 0)
+    {
+        *length = usedLength;
+        return buffer;
+    }
+    *length = [string lengthOfBytesUsingEncoding:NSUTF8StringEncoding];
+    return string.UTF8String;
+}
+
+#pragma mark - Builder
+
+@interface GTYCompactTableBuilder ()
+{
+    @package
+    GTYCompactEntry* _entries;
+    NSUInteger _entriesCapacity;
+    uint32_t* _slots;
+    uint32_t _slotMask;
+    char* _bytes;
+    size_t _bytesLength;
+    size_t _bytesCapacity;
+}
+@property (nonatomic, readwrite) NSUInteger count;
+@end
+
+@interface GTYCompactTable ()
+- (instancetype) initWithBuilder:(GTYCompactTableBuilder*)builder;
+- (NSString*) keyAtIndex:(NSUInteger)index;
+- (const char*) keyBytesAtIndex:(NSUInteger)index length:(size_t*)length;
+- (const char*) valueBytesAtIndex:(NSUInteger)index length:(size_t*)length;
+@end
+
+@implementation GTYCompactTableBuilder
+
+- (instancetype) init
+{
+    return [self initWithCapacity:0];
+}
+
+- (instancetype) initWithCapacity:(NSUInteger)capacity
+{
+    self = [super init];
+    if (self)
+    {
+        [self resetWithCapacity:capacity];
+    }
+    return self;
+}
+
+- (void) dealloc
+{
+    free(_entries);
+    free(_slots);
+    free(_bytes);
+}
+
+- (void) resetWithCapacity:(NSUInteger)capacity
+{
+    free(_entries);
+    free(_slots);
+    free(_bytes);
+    _entriesCapacity = MAX(capacity, 16);
+    _entries = malloc(_entriesCapacity * sizeof(GTYCompactEntry));
+    uint32_t slotCount = GTYCompactSlotCount(capacity);
+    _slots = calloc(slotCount, sizeof(uint32_t));
+    _slotMask = slotCount - 1;
+    _bytesCapacity = MAX(capacity * 32, 256);
+    _bytes = malloc(_bytesCapacity);
+    _bytesLength = 0;
+    self.count = 0;
+    self.source = 0;
+}
+
+- (BOOL) appendBytes:(const char*)bytes length:(size_t)length offset:(uint32_t*)offset
+{
+    if (_bytesLength + length > UINT32_MAX)
+    {
+        return NO;
+    }
+    if (_bytesLength + length > _bytesCapacity)
+    {
+        size_t capacity = MAX(_bytesCapacity * 2, _bytesLength + length);
+        char* newBytes = realloc(_bytes, capacity);
+        if (!newBytes)
+        {
+            return NO;
+        }
+        _bytes = newBytes;
+        _bytesCapacity = capacity;
+    }
+    memcpy(_bytes + _bytesLength, bytes, length);
+    *offset = (uint32_t)_bytesLength;
+    _bytesLength += length;
+    return YES;
+}
+
+- (BOOL) growIfNeeded
+{
+    NSUInteger count = self.count;
+    if (count == _entriesCapacity)
+    {
+        GTYCompactEntry* entries = realloc(_entries, _entriesCapacity * 2 * sizeof(GTYCompactEntry));
+        if (!entries)
+        {
+            return NO;
+        }
+        _entries = entries;
+        _entriesCapacity *= 2;
+    }
+
+    uint32_t slotCount = _slotMask + 1;
+    if (count + 1 > slotCount - slotCount / 4)
+    {
+        uint32_t newSlotCount = slotCount * 2;
+        uint32_t* slots = calloc(newSlotCount, sizeof(uint32_t));
+        if (!slots)
+        {
+            return NO;
+        }
+        uint32_t slotMask = newSlotCount - 1;
+        for (NSUInteger index = 0; index < count; index++)
+        {
+            uint32_t slot = _entries[index].hash & slotMask;
+            while (slots[slot] != 0)
+            {
+                slot = (slot + 1) & slotMask;
+            }
+            slots[slot] = (uint32_t)index + 1;
+        }
+        free(_slots);
+        _slots = slots;
+        _slotMask = slotMask;
+    }
+    return YES;
+}
+
+- (BOOL) addKeyBytes:(const char*)keyBytes length:(NSUInteger)keyLength valueBytes:(const char*)valueBytes length:(NSUInteger)valueLength replacingExisting:(BOOL)replace
+{
+    if (!keyBytes || !valueBytes || ![self growIfNeeded])
+    {
+        return NO;
+    }
+
+    uint32_t hash = GTYInternHash(keyBytes, keyLength);
+    uint32_t slot = GTYCompactFindSlot(_slots, _slotMask, _entries, _bytes, keyBytes, keyLength, hash);
+    if (_slots[slot] != 0)
+    {
+        if (!replace)
+        {
+            return NO;
+        }
+        // the bytes of the previous value stay in the buffer, unreferenced: replacements are rare
+        GTYCompactEntry* entry = &_entries[_slots[slot] - 1];
+        uint32_t valueOffset;
+        if (![self appendBytes:valueBytes length:valueLength offset:&valueOffset])
+        {
+            return NO;
+        }
+        entry->valueOffset = valueOffset;
+        entry->valueLength = (uint32_t)valueLength;
+        entry->source = self.source;
+        return YES;
+    }
+
+    GTYCompactEntry entry;
+    if (![self appendBytes:keyBytes length:keyLength offset:&entry.keyOffset] ||
+        ![self appendBytes:valueBytes length:valueLength offset:&entry.valueOffset])
+    {
+        return NO;
+    }
+    entry.keyLength = (uint32_t)keyLength;
+    entry.valueLength = (uint32_t)valueLength;
+    entry.hash = hash;
+    entry.source = self.source;
+    _entries[self.count] = entry;
+    _slots[slot] = (uint32_t)self.count + 1;
+    self.count++;
+    return YES;
+}
+
+- (BOOL) addString:(NSString*)string forKey:(NSString*)key replacingExisting:(BOOL)replace
+{
+    if (![string isKindOfClass:[NSString class]] || ![key isKindOfClass:[NSString class]])
+    {
+        return NO;
+    }
+    char keyBuffer[GTY_COMPACT_KEY_BUFFER];
+    size_t keyLength;
+    const char* keyBytes = GTYCompactUTF8Bytes(key, keyBuffer, sizeof(keyBuffer), &keyLength);
+    const char* valueBytes = string.UTF8String;
+    if (!keyBytes || !valueBytes)
+    {
+        return NO;
+    }
+    // keys and values may contain \0 escapes, so their lengths are never taken with strlen
+    return [self addKeyBytes:keyBytes length:keyLength valueBytes:valueBytes length:[string lengthOfBytesUsingEncoding:NSUTF8StringEncoding] replacingExisting:replace];
+}
+
+- (void) addMissingEntriesOfTable:(GTYCompactTable*)table passingTest:(BOOL (^)(const char* keyBytes, NSUInteger keyLength))predicate usingBlock:(void (^)(NSString* key))block
+{
+    NSUInteger count = table.count;
+    for (NSUInteger index = 0; index < count; index++)
+    {
+        size_t keyLength, valueLength;
+        const char* keyBytes = [table keyBytesAtIndex:index length:&keyLength];
+        if (predicate && !predicate(keyBytes, keyLength))
+        {
+            continue;
+        }
+        const char* valueBytes = [table valueBytesAtIndex:index length:&valueLength];
+        if ([self addKeyBytes:keyBytes length:keyLength valueBytes:valueBytes length:valueLength replacingExisting:NO] && block)
+        {
+            block([table keyAtIndex:index]);
+        }
+    }
+}
+
+- (GTYCompactTable*) build
+{
+    GTYCompactTable* table = [[GTYCompactTable alloc] initWithBuilder:self];
+    [self resetWithCapacity:0];
+    return table;
+}
+
+@end
+
+#pragma mark - Table
+
+@implementation GTYCompactTable
+{
+    void* _block;
+    GTYInternedString** _strings;
+    const GTYCompactSlot* _slots;
+    const uint8_t* _sources;
+    uint32_t _slotMask;
+    NSUInteger _count;
+    GTYStringInternPool* _pool;
+}
+
++ (instancetype) tableWithStrings:(NSDictionary<NSString*, NSString*>*)strings
+{
+    if ([strings isKindOfClass:[GTYCompactTable class]])
+    {
+        return (GTYCompactTable*)strings;
+    }
+    GTYCompactTableBuilder* builder = [[GTYCompactTableBuilder alloc] initWithCapacity:strings.count];
+    [strings enumerateKeysAndObjectsUsingBlock:^(NSString* key, NSString* string, BOOL* stop) {
+        [builder addString:string forKey:key replacingExisting:YES];
+    }];
+    return [builder build];
+}
+
++ (NSUInteger) internedByteCountOfTables:(NSArray<GTYCompactTable*>*)tables exclusive:(BOOL)exclusive
+{
+    NSUInteger stringCount = 0;
+    for (GTYCompactTable* table in tables)
+    {
+        stringCount += 2 * table->_count;
+    }
+    GTYInternedString** strings = malloc(MAX(stringCount, 1) * sizeof(GTYInternedString*));
+    if (!strings)
+    {
+        return 0;
+    }
+    NSUInteger offset = 0;
+    for (GTYCompactTable* table in tables)
+    {
+        memcpy(strings + offset, table->_strings, 2 * table->_count * sizeof(GTYInternedString*));
+        offset += 2 * table->_count;
+    }
+    NSUInteger byteCount = [[GTYStringInternPool sharedPool] byteCountOfStrings:strings count:stringCount exclusive:exclusive];
+    free(strings);
+    return byteCount;
+}
+
+- (instancetype) init
+{
+    return [self initWithObjects:NULL forKeys:NULL count:0];
+}
+
+- (instancetype) initWithObjects:(const id [])objects forKeys:(const id<NSCopying> [])keys count:(NSUInteger)count
+{
+    GTYCompactTableBuilder* builder = [[GTYCompactTableBuilder alloc] initWithCapacity:count];
+    for (NSUInteger index = 0; index < count; index++)
+    {
+        [builder addString:objects[index] forKey:(NSString*)keys[index] replacingExisting:YES];
+    }
+    return [self initWithBuilder:builder];
+}
+
+- (instancetype) initWithBuilder:(GTYCompactTableBuilder*)builder
+{
+    // the initializers of NSDictionary are abstract or call initWithObjects:forKeys:count:, so they are not called
+    if (self)
+    {
+        NSUInteger count = builder.count;
+        uint32_t slotCount = GTYCompactSlotCount(count);
+        size_t stringsSize = 2 * count * sizeof(GTYInternedString*);
+        size_t slotsSize = slotCount * sizeof(GTYCompactSlot);
+        size_t sourcesSize = 0;
+        for (NSUInteger index = 0; index < count && sourcesSize == 0; index++)
+        {
+            sourcesSize = builder->_entries[index].source != 0 ? count : 0;
+        }
+        char* block = calloc(1, stringsSize + slotsSize + sourcesSize);
+        GTYInternSpan* spans = malloc(MAX(2 * count, 1) * sizeof(GTYInternSpan));
+        GTYStringInternPool* pool = [GTYStringInternPool sharedPool];
+        if (!block || !spans)
+        {
+            free(block);
+            free(spans);
+            return nil;
+        }
+        for (NSUInteger index = 0; index < count; index++)
+        {
+            const GTYCompactEntry* entry = &builder->_entries[index];
+            spans[2 * index] = (GTYInternSpan){entry->keyOffset, entry->keyLength, entry->hash};
+            spans[2 * index + 1] = (GTYInternSpan){entry->valueOffset, entry->valueLength, GTYInternHash(builder->_bytes + entry->valueOffset, entry->valueLength)};
+        }
+        NSUInteger internedByteCount = 0;
+        BOOL interned = [pool internSpans:spans count:2 * count inBytes:builder->_bytes strings:(GTYInternedString**)block addedByteCount:&internedByteCount];
+        free(spans);
+        if (!interned)
+        {
+            free(block);
+            return nil;
+        }
+
+        _block = block;
+        _strings = (GTYInternedString**)block;
+        _count = count;
+        _pool = pool;
+        _byteSize = stringsSize + slotsSize + sourcesSize;
+        _internedByteCount = internedByteCount;
+        // the index is rebuilt at the final size, which may be smaller than the one of the builder
+        GTYCompactSlot* slots = (GTYCompactSlot*)(block + stringsSize);
+        _slotMask = slotCount - 1;
+        for (NSUInteger index = 0; index < count; index++)
+        {
+            uint32_t hash = builder->_entries[index].hash;
+            uint32_t slot = hash & _slotMask;
+            while (slots[slot].entry != 0)
+            {
+                slot = (slot + 1) & _slotMask;
+            }
+            slots[slot] = (GTYCompactSlot){hash, (uint32_t)index + 1};
+        }
+        _slots = slots;
+        if (sourcesSize > 0)
+        {
+            uint8_t* sources = (uint8_t*)(block + stringsSize + slotsSize);
+            for (NSUInteger index = 0; index < count; index++)
+            {
+                sources[index] = builder->_entries[index].source;
+            }
+            _sources = sources;
+        }
+    }
+    return self;
+}
+
+- (void) dealloc
+{
+    [_pool releaseStrings:_strings count:2 * _count];
+    free(_block);
+}
+
+#pragma mark - NSDictionary
+
+- (NSUInteger) count
+{
+    return _count;
+}
+
+- (id) objectForKey:(id)key
+{
+    return [self objectForKey:key source:NULL];
+}
+
+- (NSString*) objectForKey:(NSString*)key source:(uint8_t*)source
+{
+    if (_count == 0 || ![key isKindOfClass:[NSString class]])
+    {
+        return nil;
+    }
+    char buffer[GTY_COMPACT_KEY_BUFFER];
+    size_t keyLength;
+    const char* keyBytes = GTYCompactUTF8Bytes(key, buffer, sizeof(buffer), &keyLength);
+    if (!keyBytes)
+    {
+        return nil;
+    }
+    NSUInteger index = [self indexOfKeyBytes:keyBytes length:keyLength];
+    if (index == NSNotFound)
+    {
+        return nil;
+    }
+    if (source)
+    {
+        *source = _sources ? _sources[index] : 0;
+    }
+    return GTYInternedStringObject(_strings[2 * index + 1]);
+}
+
+- (NSEnumerator*) keyEnumerator
+{
+    NSMutableArray<NSString*>* keys = [NSMutableArray arrayWithCapacity:_count];
+    for (NSUInteger index = 0; index < _count; index++)
+    {
+        NSString* key = [self keyAtIndex:index];
+        if (key)
+        {
+            [keys addObject:key];
+        }
+    }
+    return [keys objectEnumerator];
+}
+
+- (void) enumerateKeysAndObjectsUsingBlock:(void (^)(id key, id object, BOOL* stop))block
+{
+    BOOL stop = NO;
+    for (NSUInteger index = 0; index < _count && !stop; index++)
+    {
+        NSString* key = [self keyAtIndex:index];
+        NSString* value = GTYInternedStringObject(_strings[2 * index + 1]);
+        if (key && value)
+        {
+            block(key, value, &stop);
+        }
+    }
+}
+
+- (void) enumerateKeysAndObjectsWithOptions:(NSEnumerationOptions)options usingBlock:(void (^)(id key, id object, BOOL* stop))block
+{
+    [self enumerateKeysAndObjectsUsingBlock:block];
+}
+
+- (id) copyWithZone:(NSZone*)zone
+{
+    return self;
+}
+
+- (Class) classForCoder
+{
+    return [NSDictionary class];
+}
+
+#pragma mark - Entries
+
+- (NSUInteger) indexOfKeyBytes:(const char*)keyBytes length:(size_t)keyLength
+{
+    uint32_t hash = GTYInternHash(keyBytes, keyLength);
+    uint32_t slot = hash & _slotMask;
+    for (;;)
+    {
+        GTYCompactSlot entry = _slots[slot];
+        if (entry.entry == 0)
+        {
+            return NSNotFound;
+        }
+        if (entry.hash == hash)
+        {
+            const GTYInternedString* entryKey = _strings[2 * (entry.entry - 1)];
+            if (entryKey->length == keyLength && memcmp(entryKey->bytes, keyBytes, keyLength) == 0)
+            {
+                return entry.entry - 1;
+            }
+        }
+        slot = (slot + 1) & _slotMask;
+    }
+}
+
+- (NSString*) keyAtIndex:(NSUInteger)index
+{
+    return index < _count ? GTYInternedStringObject(_strings[2 * index]) : nil;
+}
+
+- (const char*) keyBytesAtIndex:(NSUInteger)index length:(size_t*)length
+{
+    *length = _strings[2 * index]->length;
+    return _strings[2 * index]->bytes;
+}
+
+- (const char*) valueBytesAtIndex:(NSUInteger)index length:(size_t*)length
+{
+    *length = _strings[2 * index + 1]->length;
+    return _strings[2 * index + 1]->bytes;
+}
+
+@end
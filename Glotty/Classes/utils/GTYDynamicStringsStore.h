@@ -0,0 +1,77 @@
+// Copyright 2017 Sysdata S.p.A.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#import <Foundation/Foundation.h>
+
+/**
+ * Persistent store of the strings added by code, one per table and localization.
+ *
+ * Each store is made of a compact .strings file and an append-only journal of the changes made after it was written.
+ * Added strings and resets are appended to the journal as checksummed records: writes issued close together are grouped and written with a single append and sync per journal.
+ * Loading a store replays its journal on the compact file, stopping at the first incomplete record left by a crash, which the next append truncates.
+ * Reads never wait for writes: they read the files directly and replay on them the records still being written.
+ * Journals that grow too much, or that contain a reset, are compacted in background back into the .strings file.
+ *
+ * All methods are thread-safe.
+ */
+@interface GTYDynamicStringsStore : NSObject
+
+/**
+ * Creates a store that keeps its files in the given directory, which is listed once.
+ */
+- (instancetype) initWithDirectoryPath:(NSString*)directoryPath;
+
+@property (nonatomic, readonly) NSString* directoryPath;
+
+/**
+ * Returns YES if strings may have been added to the given table. The answer comes from memory and never accesses the file system.
+ */
+- (BOOL) hasStringsForTable:(NSString*)tableName localization:(NSString*)localization;
+
+/**
+ * Names of the tables with added strings for the given localization.
+ */
+- (NSArray<NSString*>*) tableNamesForLocalization:(NSString*)localization;
+
+/**
+ * Reads the strings added to the given table, including the ones not yet written to disk. Never waits for the writes in progress.
+ */
+- (NSMutableDictionary<NSString*, NSString*>*) stringsForTable:(NSString*)tableName localization:(NSString*)localization;
+
+/**
+ * Appends the given strings to the journal of the table. The write happens asynchronously.
+ */
+- (void) addStrings:(NSDictionary<NSString*, NSString*>*)strings toTable:(NSString*)tableName localization:(NSString*)localization;
+
+/**
+ * Appends a reset record to the journal of the table, discarding all the strings added before.
+ */
+- (void) removeStringsForTable:(NSString*)tableName localization:(NSString*)localization;
+
+/**
+ * Appends a reset record to the journals of all the tables of the given localization.
+ */
+- (void) removeStringsForLocalization:(NSString*)localization;
+
+/**
+ * Appends a reset record to all the journals.
+ */
+- (void) removeAllStrings;
+
+/**
+ * Writes the pending records and waits for the write to complete.
+ */
+- (void) flush;
+
+@end
@@ -0,0 +1,545 @@
+// Copyright 2017 Sysdata S.p.A.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#import "GTYDynamicStringsStore.h"
+#import "GTYFileManager.h"
+#import "SDLocalizationLogger.h"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Layout of a journal (all integers are little endian):
+//
+//   header   magic "GTYJ", uint32 version
+//   records  uint8 type, uint32 key length, uint32 value length, UTF-8 key, UTF-8 value, uint32 FNV-1a checksum of the preceding bytes of the record
+//
+// A set record adds a string, a clear record (empty key and value) discards everything before it.
+
+#define GTY_JOURNAL_MAGIC               "GTYJ"
+#define GTY_JOURNAL_VERSION             1
+#define GTY_JOURNAL_HEADER_SIZE         8
+#define GTY_JOURNAL_RECORD_PREFIX       9
+#define GTY_JOURNAL_RECORD_OVERHEAD     13
+#define GTY_JOURNAL_RECORD_SET          'S'
+#define GTY_JOURNAL_RECORD_CLEAR        'C'
+
+#define kCompactStoreExtension          @"strings"
+#define kJournalExtension               @"journal"
+
+// records appended within this interval are written together
+static const NSTimeInterval kGroupCommitInterval = 0.05;
+// journals longer than this are compacted after the write
+static const unsigned long long kCompactionThreshold = 256 * 1024;
+
+static uint32_t GTYJournalChecksum(const uint8_t* bytes, size_t length)
+{
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < length; i++)
+    {
+        hash ^= bytes[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static void GTYJournalAppendRecord(NSMutableData* data, uint8_t type, NSData* key, NSData* value)
+{
+    NSUInteger start = data.length;
+    uint32_t keyLength = (uint32_t)key.length;
+    uint32_t valueLength = (uint32_t)value.length;
+    [data appendBytes:&type length:sizeof(type)];
+    [data appendBytes:&keyLength length:sizeof(keyLength)];
+    [data appendBytes:&valueLength length:sizeof(valueLength)];
+    if (key)
+    {
+        [data appendData:key];
+    }
+    if (value)
+    {
+        [data appendData:value];
+    }
+    uint32_t checksum = GTYJournalChecksum((const uint8_t*)data.bytes + start, data.length - start);
+    [data appendBytes:&checksum length:sizeof(checksum)];
+}
+
+/**
+ * Applies the records to strings, if not NULL.
+ *
+ * @return The length of the valid records: replay stops at the first incomplete or corrupted one.
+ */
+static NSUInteger GTYJournalReplay(const uint8_t* bytes, NSUInteger length, NSMutableDictionary* strings, BOOL* containsClear)
+{
+    NSUInteger offset = 0;
+    while (offset + GTY_JOURNAL_RECORD_OVERHEAD <= length)
+    {
+        const uint8_t* record = bytes + offset;
+        uint8_t type = record[0];
+        uint32_t keyLength, valueLength, checksum;
+        memcpy(&keyLength, record + 1, sizeof(keyLength));
+        memcpy(&valueLength, record + 5, sizeof(valueLength));
+        uint64_t payloadEnd = (uint64_t)offset + GTY_JOURNAL_RECORD_PREFIX + keyLength + valueLength;
+        if (payloadEnd + sizeof(checksum) > length)
+        {
+            break;
+        }
+        memcpy(&checksum, bytes + payloadEnd, sizeof(checksum));
+        if (checksum != GTYJournalChecksum(record, (size_t)(payloadEnd - offset)))
+        {
+            break;
+        }
+
+        if (type == GTY_JOURNAL_RECORD_SET)
+        {
+            const uint8_t* payload = record + GTY_JOURNAL_RECORD_PREFIX;
+            NSString* key = [[NSString alloc] initWithBytes:payload length:keyLength encoding:NSUTF8StringEncoding];
+            NSString* value = [[NSString alloc] initWithBytes:payload + keyLength length:valueLength encoding:NSUTF8StringEncoding];
+            if (key && value)
+            {
+                strings[key] = value;
+            }
+        }
+        else if (type == GTY_JOURNAL_RECORD_CLEAR)
+        {
+            [strings removeAllObjects];
+            if (containsClear)
+            {
+                *containsClear = YES;
+            }
+        }
+        else
+        {
+            break;
+        }
+        offset = (NSUInteger)payloadEnd + sizeof(checksum);
+    }
+    return offset;
+}
+
+static BOOL GTYWriteAll(int fd, const void* bytes, size_t length)
+{
+    while (length > 0)
+    {
+        ssize_t written = write(fd, bytes, length);
+        if (written < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            return NO;
+        }
+        bytes = (const uint8_t*)bytes + written;
+        length -= (size_t)written;
+    }
+    return YES;
+}
+
+@interface GTYDynamicStringsStore ()
+@property (nonatomic, strong) NSString* directoryPath;
+
+/**
+ * Serial queue of all the writes to the files. Reads never wait on it.
+ */
+@property (nonatomic, strong) dispatch_queue_t ioQueue;
+
+/**
+ * Names of the journals whose tail was checked for torn records before the first append. Only accessed on ioQueue.
+ */
+@property (nonatomic, strong) NSMutableSet<NSString*>* repairedJournalNames;
+
+/**
+ * Protects storeNames, pendingRecords, writingRecords, writeSequence and flushScheduled.
+ */
+@property (nonatomic, strong) NSLock* lock;
+
+/**
+ * Names ("<table>_<localization>") of the stores with files on disk or pending records.
+ */
+@property (nonatomic, strong) NSMutableSet<NSString*>* storeNames;
+
+/**
+ * Records not yet written, by store name.
+ */
+@property (nonatomic, strong) NSMutableDictionary<NSString*, NSMutableData*>* pendingRecords;
+
+/**
+ * Records taken from pendingRecords by the write in progress, kept until it completes so that reads can replay them.
+ */
+@property (nonatomic, strong) NSDictionary<NSString*, NSData*>* writingRecords;
+
+/**
+ * Incremented when a write completes: reads that overlap it see files changing under them and start again.
+ */
+@property (nonatomic, assign) NSUInteger writeSequence;
+@property (nonatomic, assign) BOOL flushScheduled;
+@end
+
+@implementation GTYDynamicStringsStore
+
+#pragma mark - Initialization
+
+- (instancetype) initWithDirectoryPath:(NSString*)directoryPath
+{
+    self = [super init];
+    if (self)
+    {
+        _directoryPath = directoryPath;
+        _ioQueue = dispatch_queue_create("com.sysdata.glotty.dynamic-strings", DISPATCH_QUEUE_SERIAL);
+        _lock = [NSLock new];
+        _pendingRecords = [NSMutableDictionary new];
+        _repairedJournalNames = [NSMutableSet set];
+        _storeNames = [NSMutableSet set];
+        for (NSString* fileName in [GTYFileManager getFilesContentInDirectoryNamed:directoryPath])
+        {
+            NSString* extension = fileName.pathExtension;
+            if ([extension isEqualToString:kCompactStoreExtension] || [extension isEqualToString:kJournalExtension])
+            {
+                [_storeNames addObject:fileName.stringByDeletingPathExtension];
+            }
+        }
+    }
+    return self;
+}
+
+#pragma mark - Reading
+
+- (BOOL) hasStringsForTable:(NSString*)tableName localization:(NSString*)localization
+{
+    NSString* name = [self storeNameForTable:tableName localization:localization];
+    [self.lock lock];
+    BOOL exists = [self.storeNames containsObject:name];
+    [self.lock unlock];
+    return exists;
+}
+
+- (NSArray<NSString*>*) tableNamesForLocalization:(NSString*)localization
+{
+    NSString* suffix = [NSString stringWithFormat:@"_%@", localization];
+    NSMutableArray<NSString*>* tableNames = [NSMutableArray array];
+    [self.lock lock];
+    for (NSString* name in self.storeNames)
+    {
+        if (name.length > suffix.length && [name hasSuffix:suffix])
+        {
+            [tableNames addObject:[name substringToIndex:name.length - suffix.length]];
+        }
+    }
+    [self.lock unlock];
+    return tableNames;
+}
+
+- (NSMutableDictionary<NSString*, NSString*>*) stringsForTable:(NSString*)tableName localization:(NSString*)localization
+{
+    NSString* name = [self storeNameForTable:tableName localization:localization];
+    while (YES)
+    {
+        [self.lock lock];
+        NSUInteger writeSequence = self.writeSequence;
+        [self.lock unlock];
+
+        NSMutableDictionary* strings = [self readStoreWithName:name containsClear:NULL truncatingTornTail:NO];
+
+        // the files read are valid only if no write completed meanwhile: the records of a write in progress may be
+        // partially in the files, and replaying them again gives the same strings
+        [self.lock lock];
+        BOOL consistent = self.writeSequence == writeSequence;
+        NSData* writing = self.writingRecords[name];
+        NSData* pending = [self.pendingRecords[name] copy];
+        [self.lock unlock];
+        if (!consistent)
+        {
+            continue;
+        }
+
+        for (NSData* records in @[writing ?: [NSData data], pending ?: [NSData data]])
+        {
+            GTYJournalReplay(records.bytes, records.length, strings, NULL);
+        }
+        return strings;
+    }
+}
+
+/**
+ * Reads the compact file and replays the journal on it.
+ *
+ * The journal is read first: a compaction completing in between leaves a compact file that already contains the records of the journal read, and replaying them again gives the same strings.
+ *
+ * @param truncate If YES a torn record at the end of the journal is truncated, so that new records are appended after the valid ones. Only allowed on ioQueue.
+ */
+- (NSMutableDictionary*) readStoreWithName:(NSString*)name containsClear:(BOOL*)containsClear truncatingTornTail:(BOOL)truncate
+{
+    NSString* journalPath = [self pathForStoreWithName:name extension:kJournalExtension];
+    NSData* journal = [NSData dataWithContentsOfFile:journalPath];
+    NSMutableDictionary* strings = [NSMutableDictionary dictionaryWithContentsOfFile:[self pathForStoreWithName:name extension:kCompactStoreExtension]];
+    if (!strings)
+    {
+        strings = [NSMutableDictionary new];
+    }
+
+    NSUInteger validLength = [self replayJournal:journal atPath:journalPath onStrings:strings containsClear:containsClear];
+    if (truncate)
+    {
+        [self truncateJournalAtPath:journalPath length:journal.length toValidLength:validLength];
+    }
+    return strings;
+}
+
+/**
+ * Replays the records of the journal on strings, if not nil.
+ *
+ * @return The length of the valid part of the journal, header included. A journal with a foreign header is considered valid as a whole, so that it is never truncated.
+ */
+- (NSUInteger) replayJournal:(NSData*)journal atPath:(NSString*)journalPath onStrings:(NSMutableDictionary*)strings containsClear:(BOOL*)containsClear
+{
+    if (journal.length < GTY_JOURNAL_HEADER_SIZE)
+    {
+        return 0;
+    }
+
+    uint32_t version;
+    memcpy(&version, (const uint8_t*)journal.bytes + 4, sizeof(version));
+    if (memcmp(journal.bytes, GTY_JOURNAL_MAGIC, 4) != 0 || version != GTY_JOURNAL_VERSION)
+    {
+        SDLogModuleError(kLocalizationManagerLogModuleName, @"Invalid journal of added strings at path %@", journalPath);
+        return journal.length;
+    }
+    return GTY_JOURNAL_HEADER_SIZE + GTYJournalReplay((const uint8_t*)journal.bytes + GTY_JOURNAL_HEADER_SIZE, journal.length - GTY_JOURNAL_HEADER_SIZE, strings, containsClear);
+}
+
+/**
+ * Drops the incomplete records at the end of a journal, or the journal with an incomplete header.
+ *
+ * Must be called on ioQueue.
+ */
+- (void) truncateJournalAtPath:(NSString*)journalPath length:(NSUInteger)length toValidLength:(NSUInteger)validLength
+{
+    if (validLength >= length)
+    {
+        return;
+    }
+    SDLogModuleWarning(kLocalizationManagerLogModuleName, @"Discarding %lu bytes of incomplete records from the journal at path %@", (unsigned long)(length - validLength), journalPath);
+    if (truncate(journalPath.fileSystemRepresentation, (off_t)validLength) != 0)
+    {
+        SDLogModuleError(kLocalizationManagerLogModuleName, @"Unable to truncate the journal at path %@: %s", journalPath, strerror(errno));
+    }
+}
+
+#pragma mark - Writing
+
+- (void) addStrings:(NSDictionary<NSString*, NSString*>*)strings toTable:(NSString*)tableName localization:(NSString*)localization
+{
+    NSMutableData* records = [NSMutableData data];
+    [strings enumerateKeysAndObjectsUsingBlock:^(NSString* key, NSString* value, BOOL* stop) {
+        if ([key isKindOfClass:[NSString class]] && [value isKindOfClass:[NSString class]])
+        {
+            GTYJournalAppendRecord(records, GTY_JOURNAL_RECORD_SET, [key dataUsingEncoding:NSUTF8StringEncoding], [value dataUsingEncoding:NSUTF8StringEncoding]);
+        }
+    }];
+    if (records.length > 0)
+    {
+        [self appendRecords:records toStoreWithName:[self storeNameForTable:tableName localization:localization] onlyIfExisting:NO];
+    }
+}
+
+- (void) removeStringsForTable:(NSString*)tableName localization:(NSString*)localization
+{
+    [self appendRecords:[self clearRecord] toStoreWithName:[self storeNameForTable:tableName localization:localization] onlyIfExisting:YES];
+}
+
+- (void) removeStringsForLocalization:(NSString*)localization
+{
+    for (NSString* tableName in [self tableNamesForLocalization:localization])
+    {
+        [self removeStringsForTable:tableName localization:localization];
+    }
+}
+
+- (void) removeAllStrings
+{
+    [self.lock lock];
+    NSArray<NSString*>* names = self.storeNames.allObjects;
+    [self.lock unlock];
+
+    NSData* clearRecord = [self clearRecord];
+    for (NSString* name in names)
+    {
+        [self appendRecords:clearRecord toStoreWithName:name onlyIfExisting:YES];
+    }
+}
+
+- (void) flush
+{
+    dispatch_sync(self.ioQueue, ^{
+        [self writePendingRecords];
+    });
+}
+
+- (NSData*) clearRecord
+{
+    NSMutableData* record = [NSMutableData data];
+    GTYJournalAppendRecord(record, GTY_JOURNAL_RECORD_CLEAR, nil, nil);
+    return record;
+}
+
+- (void) appendRecords:(NSData*)records toStoreWithName:(NSString*)name onlyIfExisting:(BOOL)onlyIfExisting
+{
+    [self.lock lock];
+    if (onlyIfExisting && ![self.storeNames containsObject:name])
+    {
+        [self.lock unlock];
+        return;
+    }
+    NSMutableData* pending = self.pendingRecords[name];
+    if (!pending)
+    {
+        pending = [NSMutableData data];
+        self.pendingRecords[name] = pending;
+    }
+    [pending appendData:records];
+    [self.storeNames addObject:name];
+    BOOL schedule = !self.flushScheduled;
+    self.flushScheduled = YES;
+    [self.lock unlock];
+
+    if (schedule)
+    {
+        dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(kGroupCommitInterval * NSEC_PER_SEC)), self.ioQueue, ^{
+            [self writePendingRecords];
+        });
+    }
+}
+
+/**
+ * Writes all the pending records, then compacts the journals that need it.
+ *
+ * Must be called on ioQueue.
+ */
+- (void) writePendingRecords
+{
+    [self.lock lock];
+    NSDictionary<NSString*, NSData*>* pendingRecords = self.pendingRecords;
+    self.pendingRecords = [NSMutableDictionary new];
+    self.writingRecords = pendingRecords;
+    self.flushScheduled = NO;
+    [self.lock unlock];
+
+    [pendingRecords enumerateKeysAndObjectsUsingBlock:^(NSString* name, NSData* records, BOOL* stop) {
+        unsigned long long journalLength = [self appendRecords:records toJournalWithName:name];
+        BOOL containsClear = NO;
+        GTYJournalReplay(records.bytes, records.length, nil, &containsClear);
+        if (containsClear || journalLength > kCompactionThreshold)
+        {
+            [self compactStoreWithName:name];
+        }
+    }];
+
+    [self.lock lock];
+    self.writingRecords = nil;
+    self.writeSequence++;
+    [self.lock unlock];
+}
+
+/**
+ * Appends the records to the journal with a single write, and syncs it. If the write fails the journal is truncated back, so that no garbage hides the following records.
+ *
+ * @return The length of the journal after the write.
+ */
+- (unsigned long long) appendRecords:(NSData*)records toJournalWithName:(NSString*)name
+{
+    NSString* path = [self pathForStoreWithName:name extension:kJournalExtension];
+    if (![self.repairedJournalNames containsObject:name])
+    {
+        // reads leave torn records left by a crash in place, the first append drops them
+        NSData* journal = [NSData dataWithContentsOfFile:path];
+        [self truncateJournalAtPath:path length:journal.length toValidLength:[self replayJournal:journal atPath:path onStrings:nil containsClear:NULL]];
+        [self.repairedJournalNames addObject:name];
+    }
+    int fd = open(path.fileSystemRepresentation, O_WRONLY | O_APPEND | O_CREAT, 0644);
+    if (fd < 0)
+    {
+        SDLogModuleError(kLocalizationManagerLogModuleName, @"Unable to open the journal at path %@: %s", path, strerror(errno));
+        return 0;
+    }
+
+    struct stat info;
+    BOOL success = fstat(fd, &info) == 0;
+    off_t initialLength = success ? info.st_size : 0;
+    off_t length = initialLength;
+    if (success && length == 0)
+    {
+        uint8_t header[GTY_JOURNAL_HEADER_SIZE];
+        uint32_t version = GTY_JOURNAL_VERSION;
+        memcpy(header, GTY_JOURNAL_MAGIC, 4);
+        memcpy(header + 4, &version, sizeof(version));
+        success = GTYWriteAll(fd, header, sizeof(header));
+        length = sizeof(header);
+    }
+    success = success && GTYWriteAll(fd, records.bytes, records.length) && fsync(fd) == 0;
+    if (!success)
+    {
+        SDLogModuleError(kLocalizationManagerLogModuleName, @"Unable to write the journal at path %@: %s", path, strerror(errno));
+        ftruncate(fd, initialLength);
+    }
+    close(fd);
+    return success ? (unsigned long long)length + records.length : (unsigned long long)initialLength;
+}
+
+/**
+ * Rewrites the store as a compact file and drops its journal.
+ *
+ * The compact file is written before the journal is deleted: replaying the same journal on the new file gives the same strings, so a crash in between loses nothing.
+ */
+- (void) compactStoreWithName:(NSString*)name
+{
+    NSString* compactPath = [self pathForStoreWithName:name extension:kCompactStoreExtension];
+    NSString* journalPath = [self pathForStoreWithName:name extension:kJournalExtension];
+    NSMutableDictionary* strings = [self readStoreWithName:name containsClear:NULL truncatingTornTail:YES];
+    if (strings.count == 0)
+    {
+        [GTYFileManager deleteFilesAtPath:compactPath];
+        [GTYFileManager deleteFilesAtPath:journalPath];
+
+        [self.lock lock];
+        if (!self.pendingRecords[name])
+        {
+            [self.storeNames removeObject:name];
+        }
+        [self.lock unlock];
+        return;
+    }
+
+    if ([strings writeToFile:compactPath atomically:YES])
+    {
+        [GTYFileManager deleteFilesAtPath:journalPath];
+    }
+    else
+    {
+        SDLogModuleError(kLocalizationManagerLogModuleName, @"Unable to compact added strings at path %@", compactPath);
+    }
+}
+
+#pragma mark - Paths
+
+- (NSString*) storeNameForTable:(NSString*)tableName localization:(NSString*)localization
+{
+    return [NSString stringWithFormat:@"%@_%@", tableName, localization];
+}
+
+- (NSString*) pathForStoreWithName:(NSString*)name extension:(NSString*)extension
+{
+    return [self.directoryPath stringByAppendingPathComponent:[name stringByAppendingPathExtension:extension]];
+}
+
+@end
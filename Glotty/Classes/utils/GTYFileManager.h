@@ -13,6 +13,7 @@
 // limitations under the License.
 
 #import <Foundation/Foundation.h>
+#import "SDLocalizationLogger.h"
 
 #define RESOURCES_DIRECTORY @"resources"
 
@@ -52,8 +53,10 @@
 + (BOOL) deleteFilesAtPath:(NSString*)filePath;
 + (BOOL) deleteFilesContentInDirectoryNamed:(NSString*)directoryName withModifyDateBefore:(NSDate*)expirationDate;
 
+#if GLOTTY_UIKIT
 // Images
 + (UIImage*) getImageNamed:(NSString*)fileName inDirectoryNamed:(NSString*)directoryName;
 + (void) saveImage:(UIImage*)image named:(NSString*)fileName inDirectoryNamed:(NSString*)directoryName;
+#endif
 
 @end
@@ -239,6 +239,7 @@
 	return success;
 }
 
+#if GLOTTY_UIKIT
 #pragma mark - Images
 + (UIImage*) getImageNamed:(NSString*)fileName inDirectoryNamed:(NSString*)directoryName
 {
@@ -258,5 +259,6 @@
 	NSData* pngData = UIImagePNGRepresentation(image);
 	[pngData writeToFile:filePath atomically:YES];
 }
+#endif
 
 @end
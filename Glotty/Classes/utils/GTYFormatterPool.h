@@ -0,0 +1,43 @@
+// Copyright 2017 Sysdata S.p.A.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#import <Foundation/Foundation.h>
+
+/**
+ * A pool of formatters (or any other object that is expensive to create and not thread-safe) with one instance per thread and key.
+ *
+ * Each thread keeps its own instances in its thread dictionary, so formatters are used without locks and concurrent formatting scales with the number of threads.
+ * Each thread keeps at most countLimit formatters, discarding the least recently used one when a new key exceeds the limit, so that keys built from many formats or time zones do not grow the pool without bound.
+ */
+@interface GTYFormatterPool : NSObject
+
+/**
+ * The maximum number of formatters kept by each thread. The default is 32, 0 means no limit.
+ */
+@property (atomic, assign) NSUInteger countLimit;
+
+/**
+ * Returns the instance of the calling thread for the given key, creating it with the given block the first time.
+ *
+ * @param key A key describing the configuration of the formatter, e.g. template, locale and time zone.
+ * @param creator The block that creates and configures the formatter. It is called on the calling thread.
+ */
+- (id) formatterForKey:(NSString*)key creator:(id (^)(void))creator;
+
+/**
+ * Discards the formatters of all threads: each thread creates new ones at its next request.
+ */
+- (void) invalidate;
+
+@end
@@ -0,0 +1,106 @@
+// Copyright 2017 Sysdata S.p.A.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#import "GTYFormatterPool.h"
+
+static const NSUInteger kDefaultCountLimit = 32;
+
+/**
+ * The formatters of a pool owned by a thread.
+ */
+@interface GTYThreadFormatters : NSObject
+@property (nonatomic, assign) NSUInteger generation;
+@property (nonatomic, strong) NSMutableDictionary<NSString*, id>* formattersByKey;
+
+/**
+ * Keys of formattersByKey from the least to the most recently used.
+ */
+@property (nonatomic, strong) NSMutableOrderedSet<NSString*>* keysByUse;
+@end
+
+@implementation GTYThreadFormatters
+@end
+
+@interface GTYFormatterPool ()
+@property (nonatomic, strong) NSString* threadDictionaryKey;
+@property (nonatomic, strong) NSLock* lock;
+
+/**
+ * Incremented by invalidate: threads holding formatters of an older generation drop them.
+ */
+@property (atomic, assign) NSUInteger generation;
+@end
+
+@implementation GTYFormatterPool
+
+- (instancetype) init
+{
+    self = [super init];
+    if (self)
+    {
+        _threadDictionaryKey = [NSString stringWithFormat:@"GTYFormatterPool.%p", self];
+        _lock = [NSLock new];
+        _countLimit = kDefaultCountLimit;
+    }
+    return self;
+}
+
+- (id) formatterForKey:(NSString*)key creator:(id (^)(void))creator
+{
+    NSMutableDictionary* threadDictionary = [NSThread currentThread].threadDictionary;
+    GTYThreadFormatters* formatters = threadDictionary[self.threadDictionaryKey];
+    NSUInteger generation = self.generation;
+    if (!formatters || formatters.generation != generation)
+    {
+        formatters = [GTYThreadFormatters new];
+        formatters.generation = generation;
+        formatters.formattersByKey = [NSMutableDictionary new];
+        formatters.keysByUse = [NSMutableOrderedSet new];
+        threadDictionary[self.threadDictionaryKey] = formatters;
+    }
+
+    id formatter = formatters.formattersByKey[key];
+    if (formatter)
+    {
+        if (![formatters.keysByUse.lastObject isEqualToString:key])
+        {
+            [formatters.keysByUse removeObject:key];
+            [formatters.keysByUse addObject:key];
+        }
+        return formatter;
+    }
+
+    formatter = creator();
+    if (formatter)
+    {
+        NSUInteger countLimit = self.countLimit;
+        while (countLimit > 0 && formatters.keysByUse.count >= countLimit)
+        {
+            [formatters.formattersByKey removeObjectForKey:formatters.keysByUse.firstObject];
+            [formatters.keysByUse removeObjectAtIndex:0];
+        }
+        formatters.formattersByKey[key] = formatter;
+        [formatters.keysByUse addObject:key];
+    }
+    return formatter;
+}
+
+- (void) invalidate
+{
+    [self.lock lock];
+    self.generation++;
+    [self.lock unlock];
+}
+
+@end
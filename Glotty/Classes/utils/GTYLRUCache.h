@@ -0,0 +1,56 @@
+// Copyright 2017 Sysdata S.p.A.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#import <Foundation/Foundation.h>
+
+/**
+ * A thread-safe cache that keeps its objects within a total cost, evicting the least recently used ones first.
+ *
+ * Unlike NSCache, eviction is deterministic: an object is removed only when the total cost exceeds the limit, or explicitly.
+ */
+@interface GTYLRUCache<KeyType, ObjectType> : NSObject
+
+/**
+ * @param totalCostLimit The maximum total cost of the cached objects. 0 means no limit.
+ */
+- (instancetype) initWithTotalCostLimit:(NSUInteger)totalCostLimit;
+
+/**
+ * Setting a lower limit evicts the least recently used objects immediately.
+ */
+@property (atomic, assign) NSUInteger totalCostLimit;
+
+/**
+ * The total cost of the cached objects.
+ */
+@property (atomic, assign, readonly) NSUInteger totalCost;
+
+@property (atomic, assign, readonly) NSUInteger count;
+
+/**
+ * Returns the object for the given key, marking it as the most recently used one.
+ */
+- (ObjectType) objectForKey:(KeyType)key;
+
+/**
+ * Caches the given object as the most recently used one, then evicts the least recently used objects until the total cost is within the limit.
+ *
+ * An object whose cost exceeds the whole limit is not cached.
+ */
+- (void) setObject:(ObjectType)object forKey:(KeyType)key cost:(NSUInteger)cost;
+
+- (void) removeObjectForKey:(KeyType)key;
+- (void) removeAllObjects;
+
+@end
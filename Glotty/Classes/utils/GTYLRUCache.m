@@ -0,0 +1,257 @@
+// Copyright 2017 Sysdata S.p.A.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#import "GTYLRUCache.h"
+
+/**
+ * An entry of the cache, linked in order of use.
+ */
+@interface GTYLRUCacheNode : NSObject
+{
+    @package
+    id _key;
+    id _object;
+    NSUInteger _cost;
+    __unsafe_unretained GTYLRUCacheNode* _previous;
+    GTYLRUCacheNode* _next;
+}
+@end
+
+@implementation GTYLRUCacheNode
+@end
+
+@interface GTYLRUCache ()
+@property (atomic, assign, readwrite) NSUInteger totalCost;
+@property (nonatomic, strong) NSLock* lock;
+@property (nonatomic, strong) NSMutableDictionary* nodesByKey;
+@end
+
+@implementation GTYLRUCache
+{
+    // most recently used node: it owns the list through the next links
+    GTYLRUCacheNode* _head;
+    // least recently used node
+    __unsafe_unretained GTYLRUCacheNode* _tail;
+    NSUInteger _totalCostLimit;
+}
+
+- (instancetype) init
+{
+    return [self initWithTotalCostLimit:0];
+}
+
+- (instancetype) initWithTotalCostLimit:(NSUInteger)totalCostLimit
+{
+    self = [super init];
+    if (self)
+    {
+        _totalCostLimit = totalCostLimit;
+        _lock = [NSLock new];
+        _nodesByKey = [NSMutableDictionary new];
+    }
+    return self;
+}
+
+- (NSUInteger) totalCostLimit
+{
+    [self.lock lock];
+    NSUInteger totalCostLimit = _totalCostLimit;
+    [self.lock unlock];
+    return totalCostLimit;
+}
+
+- (void) setTotalCostLimit:(NSUInteger)totalCostLimit
+{
+    [self.lock lock];
+    _totalCostLimit = totalCostLimit;
+    [self trimToCostLimit];
+    [self.lock unlock];
+}
+
+- (NSUInteger) count
+{
+    [self.lock lock];
+    NSUInteger count = self.nodesByKey.count;
+    [self.lock unlock];
+    return count;
+}
+
+- (id) objectForKey:(id)key
+{
+    if (!key)
+    {
+        return nil;
+    }
+    [self.lock lock];
+    GTYLRUCacheNode* node = self.nodesByKey[key];
+    if (node)
+    {
+        [self unlinkNode:node];
+        [self linkNodeAsHead:node];
+    }
+    id object = node ? node->_object : nil;
+    [self.lock unlock];
+    return object;
+}
+
+- (void) setObject:(id)object forKey:(id)key cost:(NSUInteger)cost
+{
+    if (!key)
+    {
+        return;
+    }
+    if (!object)
+    {
+        [self removeObjectForKey:key];
+        return;
+    }
+
+    [self.lock lock];
+    if (_totalCostLimit > 0 && cost > _totalCostLimit)
+    {
+        // caching it would evict everything else, and then itself
+        GTYLRUCacheNode* node = self.nodesByKey[key];
+        if (node)
+        {
+            [self removeNode:node];
+        }
+        [self.lock unlock];
+        return;
+    }
+
+    GTYLRUCacheNode* node = self.nodesByKey[key];
+    if (node)
+    {
+        [self unlinkNode:node];
+        self.totalCost -= node->_cost;
+    }
+    else
+    {
+        node = [GTYLRUCacheNode new];
+        node->_key = [key copy];
+        self.nodesByKey[node->_key] = node;
+    }
+    node->_object = object;
+    node->_cost = cost;
+    self.totalCost += cost;
+    [self linkNodeAsHead:node];
+    [self trimToCostLimit];
+    [self.lock unlock];
+}
+
+- (void) removeObjectForKey:(id)key
+{
+    if (!key)
+    {
+        return;
+    }
+    [self.lock lock];
+    GTYLRUCacheNode* node = self.nodesByKey[key];
+    if (node)
+    {
+        [self removeNode:node];
+    }
+    [self.lock unlock];
+}
+
+- (void) removeAllObjects
+{
+    [self.lock lock];
+    [self.nodesByKey removeAllObjects];
+    // the list is released from its head, without recursion through the next links
+    GTYLRUCacheNode* node = _head;
+    _head = nil;
+    _tail = nil;
+    while (node)
+    {
+        GTYLRUCacheNode* next = node->_next;
+        node->_next = nil;
+        node = next;
+    }
+    self.totalCost = 0;
+    [self.lock unlock];
+}
+
+- (void) dealloc
+{
+    GTYLRUCacheNode* node = _head;
+    _head = nil;
+    while (node)
+    {
+        GTYLRUCacheNode* next = node->_next;
+        node->_next = nil;
+        node = next;
+    }
+}
+
+#pragma mark - List
+
+/**
+ * The following methods must be called holding the lock.
+ */
+- (void) trimToCostLimit
+{
+    while (_totalCostLimit > 0 && self.totalCost > _totalCostLimit && _tail)
+    {
+        [self removeNode:_tail];
+    }
+}
+
+- (void) removeNode:(GTYLRUCacheNode*)node
+{
+    id key = node->_key;
+    self.totalCost -= node->_cost;
+    // the dictionary keeps the node alive while it is unlinked, then releases it
+    [self unlinkNode:node];
+    [self.nodesByKey removeObjectForKey:key];
+}
+
+- (void) unlinkNode:(GTYLRUCacheNode*)node
+{
+    GTYLRUCacheNode* next = node->_next;
+    if (node->_previous)
+    {
+        node->_previous->_next = next;
+    }
+    else if (_head == node)
+    {
+        _head = next;
+    }
+    if (next)
+    {
+        next->_previous = node->_previous;
+    }
+    else if (_tail == node)
+    {
+        _tail = node->_previous;
+    }
+    node->_previous = nil;
+    node->_next = nil;
+}
+
+- (void) linkNodeAsHead:(GTYLRUCacheNode*)node
+{
+    node->_next = _head;
+    if (_head)
+    {
+        _head->_previous = node;
+    }
+    _head = node;
+    if (!_tail)
+    {
+        _tail = node;
+    }
+}
+
+@end
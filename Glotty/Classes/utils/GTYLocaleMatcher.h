@@ -0,0 +1,52 @@
+// Copyright 2017 Sysdata S.p.A.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#import <Foundation/Foundation.h>
+
+/**
+ * Matches locale identifiers against a fixed list of supported ones, in the way of CLDR language matching.
+ *
+ * Identifiers are compared by language, script and region, after filling a missing script with the likely one of the language and region (e.g. "zh-TW" is written in "Hant", "zh" in "Hans"). Locales with different languages or scripts never match; among the others, the one with the same region is preferred to the generic one, which is preferred to any other region. Both "-" and "_" separators are accepted.
+ *
+ * The supported locales are parsed and indexed by language once, at initialization, so that matching an identifier is a hash lookup and a walk of the few supported locales of its language.
+ */
+@interface GTYLocaleMatcher : NSObject
+
+/**
+ * @param supportedIdentifiers The supported locale identifiers. When two of them match at the same distance, the first one wins.
+ */
+- (instancetype) initWithSupportedIdentifiers:(NSArray<NSString*>*)supportedIdentifiers;
+
+@property (nonatomic, copy, readonly) NSArray<NSString*>* supportedIdentifiers;
+
+/**
+ * Returns the supported identifier that best matches the given one, or nil if none of them matches.
+ */
+- (NSString*) bestSupportedIdentifierForIdentifier:(NSString*)identifier;
+
+/**
+ * Returns the best supported match of the first given identifier that has one, e.g. walking the preferred languages of the user.
+ *
+ * @param matchedIdentifier If not NULL, it is set to the given identifier that has been matched.
+ */
+- (NSString*) bestSupportedIdentifierForIdentifiers:(NSArray<NSString*>*)identifiers matchedIdentifier:(NSString**)matchedIdentifier;
+
+/**
+ * Returns the language IDs ("-" separated) to search for the strings of the given locale, in order of precedence.
+ *
+ * The chain starts with the locale itself and its parents with the same script (e.g. "zh-Hant-TW", "zh-Hant", but not "zh" which is written in "Hans"), continues with the other supported locales of the same language and script, from the closest one, and ends with the given default locale.
+ */
+- (NSArray<NSString*>*) fallbackChainForIdentifier:(NSString*)identifier defaultIdentifier:(NSString*)defaultIdentifier;
+
+@end
@@ -0,0 +1,319 @@
+// Copyright 2017 Sysdata S.p.A.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#import "GTYLocaleMatcher.h"
+
+// distances between two locales with the same language and script, lower is better
+#define GTY_DISTANCE_SAME_REGION        0
+#define GTY_DISTANCE_GENERIC_SUPPORTED  4
+#define GTY_DISTANCE_GENERIC_DESIRED    5
+#define GTY_DISTANCE_OTHER_REGION       6
+#define GTY_DISTANCE_OTHER_VARIANT      1
+
+/**
+ * The subtags of a locale identifier, with the script filled with the likely one when missing.
+ */
+@interface GTYLocaleSubtags : NSObject
+@property (nonatomic, strong) NSString* identifier;
+@property (nonatomic, strong) NSString* language;
+@property (nonatomic, strong) NSString* script;
+@property (nonatomic, assign) BOOL hasExplicitScript;
+@property (nonatomic, strong) NSString* region;
+@property (nonatomic, strong) NSString* variant;
+@end
+
+@implementation GTYLocaleSubtags
+@end
+
+@interface GTYLocaleMatcher ()
+@property (nonatomic, copy, readwrite) NSArray<NSString*>* supportedIdentifiers;
+/**
+ * Parsed supported locales by language, in the order of the supported identifiers.
+ */
+@property (nonatomic, strong) NSDictionary<NSString*, NSArray<GTYLocaleSubtags*>*>* supportedSubtagsByLanguage;
+/**
+ * Supported identifiers by their normalized form, for exact matches.
+ */
+@property (nonatomic, strong) NSDictionary<NSString*, NSString*>* supportedIdentifiersByNormalizedIdentifier;
+@end
+
+@implementation GTYLocaleMatcher
+
+- (instancetype) init
+{
+    return [self initWithSupportedIdentifiers:@[]];
+}
+
+- (instancetype) initWithSupportedIdentifiers:(NSArray<NSString*>*)supportedIdentifiers
+{
+    self = [super init];
+    if (self)
+    {
+        _supportedIdentifiers = [supportedIdentifiers copy] ?: @[];
+
+        NSMutableDictionary* subtagsByLanguage = [NSMutableDictionary new];
+        NSMutableDictionary* identifiersByNormalizedIdentifier = [NSMutableDictionary new];
+        for (NSString* identifier in _supportedIdentifiers)
+        {
+            NSString* normalizedIdentifier = [GTYLocaleMatcher normalizedIdentifier:identifier];
+            if (!identifiersByNormalizedIdentifier[normalizedIdentifier])
+            {
+                identifiersByNormalizedIdentifier[normalizedIdentifier] = identifier;
+            }
+
+            GTYLocaleSubtags* subtags = [GTYLocaleMatcher subtagsOfIdentifier:identifier];
+            if (subtags.language.length > 0)
+            {
+                NSMutableArray* languageSubtags = subtagsByLanguage[subtags.language] ?: [NSMutableArray new];
+                [languageSubtags addObject:subtags];
+                subtagsByLanguage[subtags.language] = languageSubtags;
+            }
+        }
+        _supportedSubtagsByLanguage = [subtagsByLanguage copy];
+        _supportedIdentifiersByNormalizedIdentifier = [identifiersByNormalizedIdentifier copy];
+    }
+    return self;
+}
+
+#pragma mark - Matching
+
+- (NSString*) bestSupportedIdentifierForIdentifier:(NSString*)identifier
+{
+    if (identifier.length == 0)
+    {
+        return nil;
+    }
+
+    NSString* exactMatch = self.supportedIdentifiersByNormalizedIdentifier[[GTYLocaleMatcher normalizedIdentifier:identifier]];
+    if (exactMatch)
+    {
+        return exactMatch;
+    }
+
+    GTYLocaleSubtags* desired = [GTYLocaleMatcher subtagsOfIdentifier:identifier];
+    GTYLocaleSubtags* bestMatch = nil;
+    NSUInteger bestDistance = NSNotFound;
+    for (GTYLocaleSubtags* supported in self.supportedSubtagsByLanguage[desired.language])
+    {
+        NSUInteger distance = [GTYLocaleMatcher distanceOfSupported:supported fromDesired:desired];
+        if (distance < bestDistance)
+        {
+            bestDistance = distance;
+            bestMatch = supported;
+        }
+    }
+    return bestMatch.identifier;
+}
+
+- (NSString*) bestSupportedIdentifierForIdentifiers:(NSArray<NSString*>*)identifiers matchedIdentifier:(NSString**)matchedIdentifier
+{
+    for (NSString* identifier in identifiers)
+    {
+        NSString* supportedIdentifier = [self bestSupportedIdentifierForIdentifier:identifier];
+        if (supportedIdentifier)
+        {
+            if (matchedIdentifier)
+            {
+                *matchedIdentifier = identifier;
+            }
+            return supportedIdentifier;
+        }
+    }
+    return nil;
+}
+
+- (NSArray<NSString*>*) fallbackChainForIdentifier:(NSString*)identifier defaultIdentifier:(NSString*)defaultIdentifier
+{
+    NSMutableOrderedSet<NSString*>* chain = [NSMutableOrderedSet orderedSet];
+    if (identifier.length > 0)
+    {
+        [chain addObject:[GTYLocaleMatcher languageIDOfIdentifier:identifier]];
+
+        GTYLocaleSubtags* desired = [GTYLocaleMatcher subtagsOfIdentifier:identifier];
+        if (desired.language.length > 0)
+        {
+            // parents, from the most specific one
+            if (desired.variant.length > 0)
+            {
+                NSMutableArray* components = [NSMutableArray arrayWithObject:desired.language];
+                if (desired.hasExplicitScript)
+                {
+                    [components addObject:desired.script];
+                }
+                if (desired.region.length > 0)
+                {
+                    [components addObject:desired.region];
+                }
+                [chain addObject:[components componentsJoinedByString:@"-"]];
+            }
+            if (desired.script.length > 0 && (desired.region.length > 0 || desired.variant.length > 0))
+            {
+                [chain addObject:[NSString stringWithFormat:@"%@-%@", desired.language, desired.script]];
+            }
+            NSString* languageScript = [GTYLocaleMatcher likelyScriptForLanguage:desired.language region:nil];
+            if (desired.script.length == 0 || languageScript.length == 0 || [languageScript isEqualToString:desired.script])
+            {
+                [chain addObject:desired.language];
+            }
+
+            // other supported locales of the same language and script, from the closest one
+            NSArray<GTYLocaleSubtags*>* candidates = self.supportedSubtagsByLanguage[desired.language];
+            NSMutableArray<GTYLocaleSubtags*>* matches = [NSMutableArray arrayWithCapacity:candidates.count];
+            NSMutableDictionary<NSString*, NSNumber*>* distances = [NSMutableDictionary dictionaryWithCapacity:candidates.count];
+            for (GTYLocaleSubtags* supported in candidates)
+            {
+                NSUInteger distance = [GTYLocaleMatcher distanceOfSupported:supported fromDesired:desired];
+                if (distance != NSNotFound)
+                {
+                    [matches addObject:supported];
+                    distances[supported.identifier] = @(distance);
+                }
+            }
+            // the sort is stable, so the order of the supported identifiers breaks ties
+            [matches sortWithOptions:NSSortStable usingComparator:^NSComparisonResult(GTYLocaleSubtags* obj1, GTYLocaleSubtags* obj2) {
+                return [distances[obj1.identifier] compare:distances[obj2.identifier]];
+            }];
+            for (GTYLocaleSubtags* supported in matches)
+            {
+                [chain addObject:[GTYLocaleMatcher languageIDOfIdentifier:supported.identifier]];
+            }
+        }
+    }
+    if (defaultIdentifier.length > 0)
+    {
+        [chain addObject:[GTYLocaleMatcher languageIDOfIdentifier:defaultIdentifier]];
+    }
+    return [chain array];
+}
+
+/**
+ * Returns the distance of the supported locale from the desired one, or NSNotFound if they do not match.
+ */
++ (NSUInteger) distanceOfSupported:(GTYLocaleSubtags*)supported fromDesired:(GTYLocaleSubtags*)desired
+{
+    if (![supported.language isEqualToString:desired.language])
+    {
+        return NSNotFound;
+    }
+    // a missing script is unknown, so it is compatible with any script
+    if (supported.script.length > 0 && desired.script.length > 0 && ![supported.script isEqualToString:desired.script])
+    {
+        return NSNotFound;
+    }
+
+    NSUInteger distance;
+    if ([supported.region isEqualToString:desired.region])
+    {
+        distance = GTY_DISTANCE_SAME_REGION;
+    }
+    else if (supported.region.length == 0)
+    {
+        distance = GTY_DISTANCE_GENERIC_SUPPORTED;
+    }
+    else if (desired.region.length == 0)
+    {
+        distance = GTY_DISTANCE_GENERIC_DESIRED;
+    }
+    else
+    {
+        distance = GTY_DISTANCE_OTHER_REGION;
+    }
+    if (![supported.variant isEqualToString:desired.variant])
+    {
+        distance += GTY_DISTANCE_OTHER_VARIANT;
+    }
+    return distance;
+}
+
+#pragma mark - Subtags
+
++ (NSString*) normalizedIdentifier:(NSString*)identifier
+{
+    return [[identifier stringByReplacingOccurrencesOfString:@"_" withString:@"-"] lowercaseString];
+}
+
++ (NSString*) languageIDOfIdentifier:(NSString*)identifier
+{
+    return [identifier stringByReplacingOccurrencesOfString:@"_" withString:@"-"];
+}
+
++ (GTYLocaleSubtags*) subtagsOfIdentifier:(NSString*)identifier
+{
+    NSDictionary* components = [NSLocale componentsFromLocaleIdentifier:[identifier stringByReplacingOccurrencesOfString:@"-" withString:@"_"]];
+
+    GTYLocaleSubtags* subtags = [GTYLocaleSubtags new];
+    subtags.identifier = identifier;
+    NSString* language = [components[NSLocaleLanguageCode] lowercaseString] ?: @"";
+    subtags.language = [GTYLocaleMatcher languageAliases][language] ?: language;
+    subtags.region = [components[NSLocaleCountryCode] uppercaseString] ?: @"";
+    subtags.variant = [components[NSLocaleVariantCode] uppercaseString] ?: @"";
+
+    NSString* script = components[NSLocaleScriptCode];
+    subtags.hasExplicitScript = script.length > 0;
+    if (subtags.hasExplicitScript)
+    {
+        subtags.script = [[[script substringToIndex:1] uppercaseString] stringByAppendingString:[[script substringFromIndex:1] lowercaseString]];
+    }
+    else
+    {
+        subtags.script = [GTYLocaleMatcher likelyScriptForLanguage:subtags.language region:subtags.region] ?: @"";
+    }
+    return subtags;
+}
+
+/**
+ * Returns the likely script of the given language in the given region, or nil if the language is written in a single script.
+ *
+ * This is the subset of the CLDR likely subtags concerning languages written in more than one script.
+ */
++ (NSString*) likelyScriptForLanguage:(NSString*)language region:(NSString*)region
+{
+    static NSDictionary<NSString*, NSString*>* likelyScripts = nil;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        likelyScripts = @{@"zh": @"Hans", @"zh-TW": @"Hant", @"zh-HK": @"Hant", @"zh-MO": @"Hant",
+                          @"yue": @"Hant", @"yue-CN": @"Hans",
+                          @"sr": @"Cyrl", @"sr-ME": @"Latn",
+                          @"uz": @"Latn", @"uz-AF": @"Arab",
+                          @"az": @"Latn", @"az-IR": @"Arab",
+                          @"pa": @"Guru", @"pa-PK": @"Arab",
+                          @"bs": @"Latn", @"mn": @"Cyrl", @"ms": @"Latn", @"ha": @"Latn",
+                          @"ks": @"Arab", @"sd": @"Arab", @"shi": @"Tfng", @"vai": @"Vaii"};
+    });
+
+    if (region.length > 0)
+    {
+        NSString* script = likelyScripts[[NSString stringWithFormat:@"%@-%@", language, region]];
+        if (script)
+        {
+            return script;
+        }
+    }
+    return likelyScripts[language];
+}
+
+/**
+ * Deprecated language codes, replaced by their current ones.
+ */
++ (NSDictionary<NSString*, NSString*>*) languageAliases
+{
+    static NSDictionary<NSString*, NSString*>* languageAliases = nil;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        languageAliases = @{@"iw": @"he", @"in": @"id", @"ji": @"yi", @"no": @"nb", @"tl": @"fil"};
+    });
+    return languageAliases;
+}
+
+@end
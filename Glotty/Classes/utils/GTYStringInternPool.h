@@ -0,0 +1,111 @@
+// Copyright 2017 Sysdata S.p.A.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#import <Foundation/Foundation.h>
+
+/**
+ * A string of an intern pool: its UTF-8 bytes, stored once for all the tables referencing them. The fields are owned by the pool and must not be modified.
+ *
+ * Strings are allocated from slabs of the pool, so a string is not a separate allocation.
+ */
+typedef struct GTYInternedString
+{
+    struct GTYInternedString* next;
+    /** NSString created by GTYInternedStringObject() the first time, read and written atomically. */
+    void* object;
+    /** Read and written atomically. */
+    uint32_t referenceCount;
+    uint32_t hash;
+    uint32_t length;
+    char bytes[];
+} GTYInternedString;
+
+/**
+ * Bytes of a string to intern, at the given offset of a buffer.
+ */
+typedef struct
+{
+    uint32_t offset;
+    uint32_t length;
+    uint32_t hash;
+} GTYInternSpan;
+
+/**
+ * Hash of the given bytes used by intern pools (FNV-1a).
+ */
+static inline uint32_t GTYInternHash(const char* bytes, size_t length)
+{
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < length; i++)
+    {
+        hash ^= (uint8_t)bytes[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+/**
+ * Returns the NSString with the bytes of the given interned string, creating it the first time. The same object is returned for all the references, until the string leaves the pool.
+ */
+NSString* GTYInternedStringObject(GTYInternedString* string);
+
+/**
+ * A pool of reference counted UTF-8 strings, shared by the tables of all locales.
+ *
+ * Keys repeat in every locale and tier of a table, and many values too (brand names, untranslated strings, regional variants), so tables reference the strings of the pool instead of storing their own copies. A string leaves the pool when the last table referencing it is released.
+ *
+ * The pool is split in shards by hash, each with its own lock, buckets and slabs: a table locks each shard once to intern its strings, and tables of different threads rarely wait for each other.
+ * Releasing a string that other tables still reference takes no lock; only the strings losing their last reference are removed in a batch, locking each of their shards once.
+ */
+@interface GTYStringInternPool : NSObject
+
+/**
+ * The pool of the tables of all the localization managers.
+ */
++ (instancetype) sharedPool;
+
+/**
+ * Number of strings in the pool.
+ */
+@property (nonatomic, readonly) NSUInteger count;
+
+/**
+ * Bytes of memory used by the strings in the pool, excluding their NSString objects.
+ */
+@property (nonatomic, readonly) NSUInteger byteCount;
+
+/**
+ * Finds or adds the strings with the given bytes, adding a reference to each of them.
+ *
+ * @param spans The strings to intern, in the given buffer. Their hash must be computed with GTYInternHash().
+ * @param strings Set to the interned strings, in the order of spans.
+ * @param addedByteCount Set to the bytes of the strings added to the pool, i.e. not referenced by any table yet. Can be NULL.
+ *
+ * @return NO if memory is exhausted. The strings interned before the failure are released.
+ */
+- (BOOL) internSpans:(const GTYInternSpan*)spans count:(NSUInteger)count inBytes:(const char*)bytes strings:(GTYInternedString**)strings addedByteCount:(NSUInteger*)addedByteCount;
+
+/**
+ * Removes a reference from each of the given strings. The strings without references leave the pool, with their objects.
+ */
+- (void) releaseStrings:(GTYInternedString* const*)strings count:(NSUInteger)count;
+
+/**
+ * Bytes of memory used by the given strings, each counted once.
+ *
+ * @param exclusive YES to count only the strings whose references are all in the given ones, i.e. the bytes freed by releasing them.
+ */
+- (NSUInteger) byteCountOfStrings:(GTYInternedString* const*)strings count:(NSUInteger)count exclusive:(BOOL)exclusive;
+
+@end
@@ -0,0 +1,522 @@
+// Copyright 2017 Sysdata S.p.A.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#import "GTYStringInternPool.h"
+#import <stdatomic.h>
+
+#define GTY_INTERN_MIN_BUCKETS  64
+#define GTY_INTERN_SHARD_BITS   4
+#define GTY_INTERN_SHARD_COUNT  (1 << GTY_INTERN_SHARD_BITS)
+#define GTY_INTERN_SLAB_SIZE    (64 * 1024)
+#define GTY_INTERN_ALIGNMENT    8
+
+/**
+ * The header of a slab: a block of GTY_INTERN_SLAB_SIZE bytes aligned to its size, so the slab of a string is found by masking its address.
+ * Strings are appended to the current slab of their shard; a slab is freed when its last string leaves the pool and it is not current anymore. A string too large for a slab gets a slab of its own.
+ */
+typedef struct
+{
+    NSUInteger liveCount;
+    size_t usedLength;
+} GTYInternSlab;
+
+/**
+ * A shard of the pool: the strings whose hash has the given top bits, guarded by the lock of the shard.
+ */
+typedef struct
+{
+    // chained hash table of the strings, through their next field
+    GTYInternedString** buckets;
+    NSUInteger bucketMask;
+    NSUInteger count;
+    NSUInteger byteCount;
+    GTYInternSlab* slab;
+} GTYInternShard;
+
+static inline NSUInteger GTYInternShardIndex(uint32_t hash)
+{
+    return hash >> (32 - GTY_INTERN_SHARD_BITS);
+}
+
+static inline size_t GTYInternedStringByteSize(const GTYInternedString* string)
+{
+    return sizeof(GTYInternedString) + string->length;
+}
+
+static inline GTYInternSlab* GTYInternedStringSlab(const GTYInternedString* string)
+{
+    return (GTYInternSlab*)((uintptr_t)string & ~(uintptr_t)(GTY_INTERN_SLAB_SIZE - 1));
+}
+
+static inline _Atomic(uint32_t)* GTYInternedStringReferenceCount(GTYInternedString* string)
+{
+    return (_Atomic(uint32_t)*)&string->referenceCount;
+}
+
+static int GTYInternComparePointers(const void* pointer1, const void* pointer2)
+{
+    uintptr_t address1 = (uintptr_t)*(GTYInternedString* const*)pointer1;
+    uintptr_t address2 = (uintptr_t)*(GTYInternedString* const*)pointer2;
+    return address1 < address2 ? -1 : address1 > address2;
+}
+
+NSString* GTYInternedStringObject(GTYInternedString* string)
+{
+    _Atomic(void*)* slot = (_Atomic(void*)*)&string->object;
+    void* object = atomic_load_explicit(slot, memory_order_acquire);
+    if (object)
+    {
+        return (__bridge NSString*)object;
+    }
+
+    // the object may outlive the string, so the bytes are copied
+    NSString* created = [[NSString alloc] initWithBytes:string->bytes length:string->length encoding:NSUTF8StringEncoding];
+    if (!created)
+    {
+        return nil;
+    }
+    void* expected = NULL;
+    void* retained = (__bridge_retained void*)created;
+    if (!atomic_compare_exchange_strong_explicit(slot, &expected, retained, memory_order_acq_rel, memory_order_acquire))
+    {
+        // another thread created it first
+        CFRelease(retained);
+        return (__bridge NSString*)expected;
+    }
+    return created;
+}
+
+@interface GTYStringInternPool ()
+{
+    GTYInternShard _shards[GTY_INTERN_SHARD_COUNT];
+}
+@property (nonatomic, strong) NSArray<NSLock*>* locks;
+@end
+
+@implementation GTYStringInternPool
+
++ (instancetype) sharedPool
+{
+    static GTYStringInternPool* sharedPool = nil;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        sharedPool = [self new];
+    });
+    return sharedPool;
+}
+
+- (instancetype) init
+{
+    self = [super init];
+    if (self)
+    {
+        NSMutableArray<NSLock*>* locks = [NSMutableArray arrayWithCapacity:GTY_INTERN_SHARD_COUNT];
+        for (NSUInteger index = 0; index < GTY_INTERN_SHARD_COUNT; index++)
+        {
+            [locks addObject:[NSLock new]];
+            _shards[index].buckets = calloc(GTY_INTERN_MIN_BUCKETS, sizeof(GTYInternedString*));
+            _shards[index].bucketMask = GTY_INTERN_MIN_BUCKETS - 1;
+        }
+        _locks = [locks copy];
+    }
+    return self;
+}
+
+- (void) dealloc
+{
+    for (NSUInteger index = 0; index < GTY_INTERN_SHARD_COUNT; index++)
+    {
+        GTYInternShard* shard = &_shards[index];
+        for (NSUInteger bucket = 0; bucket <= shard->bucketMask; bucket++)
+        {
+            GTYInternedString* string = shard->buckets[bucket];
+            while (string)
+            {
+                GTYInternedString* next = string->next;
+                [self freeString:string inShard:shard];
+                string = next;
+            }
+        }
+        free(shard->buckets);
+        free(shard->slab);
+    }
+}
+
+- (NSUInteger) count
+{
+    NSUInteger count = 0;
+    for (NSUInteger index = 0; index < GTY_INTERN_SHARD_COUNT; index++)
+    {
+        [self.locks[index] lock];
+        count += _shards[index].count;
+        [self.locks[index] unlock];
+    }
+    return count;
+}
+
+- (NSUInteger) byteCount
+{
+    NSUInteger byteCount = 0;
+    for (NSUInteger index = 0; index < GTY_INTERN_SHARD_COUNT; index++)
+    {
+        [self.locks[index] lock];
+        byteCount += _shards[index].byteCount;
+        [self.locks[index] unlock];
+    }
+    return byteCount;
+}
+
+#pragma mark - Interning
+
+- (BOOL) internSpans:(const GTYInternSpan*)spans count:(NSUInteger)count inBytes:(const char*)bytes strings:(GTYInternedString**)strings addedByteCount:(NSUInteger*)addedByteCount
+{
+    if (addedByteCount)
+    {
+        *addedByteCount = 0;
+    }
+    if (count == 0)
+    {
+        return YES;
+    }
+    // the spans are grouped by shard (counting sort), so each shard is locked once
+    NSUInteger* order = malloc(count * sizeof(NSUInteger));
+    if (!order)
+    {
+        return NO;
+    }
+    NSUInteger shardStarts[GTY_INTERN_SHARD_COUNT + 1] = {0};
+    for (NSUInteger index = 0; index < count; index++)
+    {
+        shardStarts[GTYInternShardIndex(spans[index].hash) + 1]++;
+        strings[index] = NULL;
+    }
+    for (NSUInteger shardIndex = 0; shardIndex < GTY_INTERN_SHARD_COUNT; shardIndex++)
+    {
+        shardStarts[shardIndex + 1] += shardStarts[shardIndex];
+    }
+    NSUInteger positions[GTY_INTERN_SHARD_COUNT];
+    memcpy(positions, shardStarts, sizeof(positions));
+    for (NSUInteger index = 0; index < count; index++)
+    {
+        order[positions[GTYInternShardIndex(spans[index].hash)]++] = index;
+    }
+
+    BOOL interned = YES;
+    NSUInteger addedBytes = 0;
+    for (NSUInteger shardIndex = 0; shardIndex < GTY_INTERN_SHARD_COUNT && interned; shardIndex++)
+    {
+        if (shardStarts[shardIndex] == shardStarts[shardIndex + 1])
+        {
+            continue;
+        }
+        GTYInternShard* shard = &_shards[shardIndex];
+        NSLock* lock = self.locks[shardIndex];
+        [lock lock];
+        NSUInteger shardByteCount = shard->byteCount;
+        for (NSUInteger position = shardStarts[shardIndex]; position < shardStarts[shardIndex + 1]; position++)
+        {
+            NSUInteger index = order[position];
+            strings[index] = [self internSpan:spans[index] inBytes:bytes shard:shard];
+            if (!strings[index])
+            {
+                interned = NO;
+                break;
+            }
+        }
+        addedBytes += shard->byteCount - shardByteCount;
+        [lock unlock];
+    }
+    free(order);
+
+    if (!interned)
+    {
+        for (NSUInteger index = 0; index < count; index++)
+        {
+            if (strings[index])
+            {
+                [self releaseStrings:&strings[index] count:1];
+            }
+        }
+        return NO;
+    }
+    if (addedByteCount)
+    {
+        *addedByteCount = addedBytes;
+    }
+    return YES;
+}
+
+/**
+ * Returns the string with the bytes of the given span, adding it if needed, with a new reference. Called holding the lock of the shard.
+ */
+- (GTYInternedString*) internSpan:(GTYInternSpan)span inBytes:(const char*)bytes shard:(GTYInternShard*)shard
+{
+    const char* spanBytes = bytes + span.offset;
+    GTYInternedString** bucket = &shard->buckets[span.hash & shard->bucketMask];
+    for (GTYInternedString* string = *bucket; string; string = string->next)
+    {
+        if (string->hash == span.hash && string->length == span.length && memcmp(string->bytes, spanBytes, span.length) == 0)
+        {
+            atomic_fetch_add_explicit(GTYInternedStringReferenceCount(string), 1, memory_order_relaxed);
+            return string;
+        }
+    }
+
+    GTYInternedString* string = [self allocateStringWithLength:span.length inShard:shard];
+    if (!string)
+    {
+        return NULL;
+    }
+    string->object = NULL;
+    atomic_init(GTYInternedStringReferenceCount(string), 1);
+    string->hash = span.hash;
+    string->length = span.length;
+    memcpy(string->bytes, spanBytes, span.length);
+    string->next = *bucket;
+    *bucket = string;
+    shard->count++;
+    shard->byteCount += GTYInternedStringByteSize(string);
+
+    if (shard->count > shard->bucketMask + 1)
+    {
+        [self growBucketsOfShard:shard];
+    }
+    return string;
+}
+
+/**
+ * Appends a string of the given length to the current slab of the shard, starting a new slab if it is full. Called holding the lock of the shard.
+ */
+- (GTYInternedString*) allocateStringWithLength:(uint32_t)length inShard:(GTYInternShard*)shard
+{
+    size_t size = (sizeof(GTYInternedString) + length + GTY_INTERN_ALIGNMENT - 1) & ~(size_t)(GTY_INTERN_ALIGNMENT - 1);
+    size_t headerSize = (sizeof(GTYInternSlab) + GTY_INTERN_ALIGNMENT - 1) & ~(size_t)(GTY_INTERN_ALIGNMENT - 1);
+    if (headerSize + size > GTY_INTERN_SLAB_SIZE)
+    {
+        // a slab of its own, never current, freed with the string
+        GTYInternSlab* slab = NULL;
+        if (posix_memalign((void**)&slab, GTY_INTERN_SLAB_SIZE, headerSize + size) != 0)
+        {
+            return NULL;
+        }
+        slab->liveCount = 1;
+        slab->usedLength = headerSize + size;
+        return (GTYInternedString*)((char*)slab + headerSize);
+    }
+
+    GTYInternSlab* slab = shard->slab;
+    if (!slab || slab->usedLength + size > GTY_INTERN_SLAB_SIZE)
+    {
+        GTYInternSlab* newSlab = NULL;
+        if (posix_memalign((void**)&newSlab, GTY_INTERN_SLAB_SIZE, GTY_INTERN_SLAB_SIZE) != 0)
+        {
+            return NULL;
+        }
+        newSlab->liveCount = 0;
+        newSlab->usedLength = headerSize;
+        if (slab && slab->liveCount == 0)
+        {
+            free(slab);
+        }
+        shard->slab = slab = newSlab;
+    }
+    GTYInternedString* string = (GTYInternedString*)((char*)slab + slab->usedLength);
+    slab->usedLength += size;
+    slab->liveCount++;
+    return string;
+}
+
+- (void) growBucketsOfShard:(GTYInternShard*)shard
+{
+    NSUInteger bucketCount = (shard->bucketMask + 1) * 2;
+    GTYInternedString** buckets = calloc(bucketCount, sizeof(GTYInternedString*));
+    if (!buckets)
+    {
+        // longer chains, still correct
+        return;
+    }
+    NSUInteger bucketMask = bucketCount - 1;
+    for (NSUInteger bucket = 0; bucket <= shard->bucketMask; bucket++)
+    {
+        GTYInternedString* string = shard->buckets[bucket];
+        while (string)
+        {
+            GTYInternedString* next = string->next;
+            string->next = buckets[string->hash & bucketMask];
+            buckets[string->hash & bucketMask] = string;
+            string = next;
+        }
+    }
+    free(shard->buckets);
+    shard->buckets = buckets;
+    shard->bucketMask = bucketMask;
+}
+
+#pragma mark - Releasing
+
+- (void) releaseStrings:(GTYInternedString* const*)strings count:(NSUInteger)count
+{
+    // references other than the last one are removed without locks: a string reaches 0 only holding the lock of its shard, so it cannot be found and retained meanwhile
+    GTYInternedString** lastReferences = NULL;
+    NSUInteger lastReferenceCount = 0;
+    NSUInteger shardCounts[GTY_INTERN_SHARD_COUNT + 1] = {0};
+    for (NSUInteger index = 0; index < count; index++)
+    {
+        GTYInternedString* string = strings[index];
+        _Atomic(uint32_t)* referenceCount = GTYInternedStringReferenceCount(string);
+        uint32_t expected = atomic_load_explicit(referenceCount, memory_order_relaxed);
+        while (expected > 1 && !atomic_compare_exchange_weak_explicit(referenceCount, &expected, expected - 1, memory_order_release, memory_order_relaxed))
+        {
+        }
+        if (expected > 1)
+        {
+            continue;
+        }
+        if (!lastReferences)
+        {
+            lastReferences = malloc((count - index) * sizeof(GTYInternedString*));
+            if (!lastReferences)
+            {
+                // removed one by one
+                [self releaseLastReferencesOfStrings:&string count:1 shardIndex:GTYInternShardIndex(string->hash)];
+                continue;
+            }
+        }
+        lastReferences[lastReferenceCount++] = string;
+        shardCounts[GTYInternShardIndex(string->hash) + 1]++;
+    }
+    if (lastReferenceCount == 0)
+    {
+        free(lastReferences);
+        return;
+    }
+
+    // grouped by shard, so each shard is locked once
+    GTYInternedString** grouped = malloc(lastReferenceCount * sizeof(GTYInternedString*));
+    if (!grouped)
+    {
+        for (NSUInteger index = 0; index < lastReferenceCount; index++)
+        {
+            [self releaseLastReferencesOfStrings:&lastReferences[index] count:1 shardIndex:GTYInternShardIndex(lastReferences[index]->hash)];
+        }
+        free(lastReferences);
+        return;
+    }
+    for (NSUInteger shardIndex = 0; shardIndex < GTY_INTERN_SHARD_COUNT; shardIndex++)
+    {
+        shardCounts[shardIndex + 1] += shardCounts[shardIndex];
+    }
+    NSUInteger positions[GTY_INTERN_SHARD_COUNT];
+    memcpy(positions, shardCounts, sizeof(positions));
+    for (NSUInteger index = 0; index < lastReferenceCount; index++)
+    {
+        grouped[positions[GTYInternShardIndex(lastReferences[index]->hash)]++] = lastReferences[index];
+    }
+    for (NSUInteger shardIndex = 0; shardIndex < GTY_INTERN_SHARD_COUNT; shardIndex++)
+    {
+        NSUInteger shardCount = shardCounts[shardIndex + 1] - shardCounts[shardIndex];
+        if (shardCount > 0)
+        {
+            [self releaseLastReferencesOfStrings:grouped + shardCounts[shardIndex] count:shardCount shardIndex:shardIndex];
+        }
+    }
+    free(grouped);
+    free(lastReferences);
+}
+
+/**
+ * Removes a reference from each of the given strings of a shard, which had a single reference when they were collected, and removes those left without references.
+ */
+- (void) releaseLastReferencesOfStrings:(GTYInternedString* const*)strings count:(NSUInteger)count shardIndex:(NSUInteger)shardIndex
+{
+    GTYInternShard* shard = &_shards[shardIndex];
+    NSLock* lock = self.locks[shardIndex];
+    [lock lock];
+    for (NSUInteger index = 0; index < count; index++)
+    {
+        GTYInternedString* string = strings[index];
+        // the string may have been interned again after it was collected
+        if (atomic_fetch_sub_explicit(GTYInternedStringReferenceCount(string), 1, memory_order_acq_rel) > 1)
+        {
+            continue;
+        }
+        GTYInternedString** link = &shard->buckets[string->hash & shard->bucketMask];
+        while (*link != string)
+        {
+            link = &(*link)->next;
+        }
+        *link = string->next;
+        shard->count--;
+        shard->byteCount -= GTYInternedStringByteSize(string);
+        [self freeString:string inShard:shard];
+    }
+    [lock unlock];
+}
+
+/**
+ * Called holding the lock of the shard.
+ */
+- (void) freeString:(GTYInternedString*)string inShard:(GTYInternShard*)shard
+{
+    void* object = atomic_load_explicit((_Atomic(void*)*)&string->object, memory_order_acquire);
+    if (object)
+    {
+        CFRelease(object);
+    }
+    GTYInternSlab* slab = GTYInternedStringSlab(string);
+    if (--slab->liveCount == 0 && slab != shard->slab)
+    {
+        free(slab);
+    }
+}
+
+#pragma mark - Memory
+
+- (NSUInteger) byteCountOfStrings:(GTYInternedString* const*)strings count:(NSUInteger)count exclusive:(BOOL)exclusive
+{
+    if (count == 0)
+    {
+        return 0;
+    }
+    // sorted by address, the references to the same string are contiguous
+    GTYInternedString** sorted = malloc(count * sizeof(GTYInternedString*));
+    if (!sorted)
+    {
+        return 0;
+    }
+    memcpy(sorted, strings, count * sizeof(GTYInternedString*));
+    qsort(sorted, count, sizeof(GTYInternedString*), GTYInternComparePointers);
+
+    NSUInteger byteCount = 0;
+    NSUInteger index = 0;
+    while (index < count)
+    {
+        GTYInternedString* string = sorted[index];
+        uint32_t referenceCount = 0;
+        while (index < count && sorted[index] == string)
+        {
+            referenceCount++;
+            index++;
+        }
+        // the given references keep the string in the pool, so its fields can be read without locks
+        if (!exclusive || referenceCount >= atomic_load_explicit(GTYInternedStringReferenceCount(string), memory_order_relaxed))
+        {
+            byteCount += GTYInternedStringByteSize(string);
+        }
+    }
+    free(sorted);
+    return byteCount;
+}
+
+@end
@@ -0,0 +1,39 @@
+// Copyright 2017 Sysdata S.p.A.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#import <Foundation/Foundation.h>
+
+/**
+ * A string parsed once into literal segments and placeholder slots.
+ *
+ * Placeholders are replaced all at once: at each position the longest matching placeholder wins, and substituted values are never searched for other placeholders, so the result does not depend on the order of the placeholders.
+ */
+@interface GTYStringTemplate : NSObject
+
+/**
+ * Parses the given string, looking for the given placeholders.
+ */
+- (instancetype) initWithString:(NSString*)string placeholders:(NSArray<NSString*>*)placeholders;
+
+/**
+ * Returns YES if the template has been parsed with exactly the keys of the given dictionary as placeholders.
+ */
+- (BOOL) hasPlaceholdersOfDictionary:(NSDictionary<NSString*, NSString*>*)placeholderDictionary;
+
+/**
+ * Renders the template into a single buffer, replacing each placeholder with its value in the given dictionary.
+ */
+- (NSString*) stringWithPlaceholderDictionary:(NSDictionary<NSString*, NSString*>*)placeholderDictionary;
+
+@end
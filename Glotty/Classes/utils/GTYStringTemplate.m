@@ -0,0 +1,202 @@
+// Copyright 2017 Sysdata S.p.A.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#import "GTYStringTemplate.h"
+
+#define GTY_TEMPLATE_LITERAL    -1
+
+typedef struct
+{
+    NSUInteger location;
+    NSUInteger length;
+    NSInteger slot;         // index of the placeholder, or GTY_TEMPLATE_LITERAL for a range of the string
+} GTYTemplateSegment;
+
+@implementation GTYStringTemplate
+{
+    NSString* _string;
+    unichar* _characters;
+    NSArray<NSString*>* _placeholders;
+    NSSet<NSString*>* _placeholderSet;
+    NSData* _segmentsData;
+    NSUInteger* _occurrences;
+    NSUInteger _literalLength;
+}
+
+- (instancetype) initWithString:(NSString*)string placeholders:(NSArray<NSString*>*)placeholders
+{
+    self = [super init];
+    if (self)
+    {
+        _string = [string copy];
+        _placeholders = [placeholders copy];
+        _placeholderSet = [NSSet setWithArray:_placeholders];
+        _occurrences = calloc(MAX(_placeholders.count, 1), sizeof(NSUInteger));
+
+        NSUInteger length = _string.length;
+        _characters = malloc(MAX(length, 1) * sizeof(unichar));
+        [_string getCharacters:_characters range:NSMakeRange(0, length)];
+
+        [self parse];
+    }
+    return self;
+}
+
+- (void) dealloc
+{
+    free(_characters);
+    free(_occurrences);
+}
+
+/**
+ * Splits the string into segments, matching at each position the longest placeholder.
+ */
+- (void) parse
+{
+    NSArray<NSNumber*>* slotsByLength = [[self slotIndexes] sortedArrayUsingComparator:^NSComparisonResult(NSNumber* obj1, NSNumber* obj2) {
+        NSUInteger length1 = self->_placeholders[obj1.unsignedIntegerValue].length;
+        NSUInteger length2 = self->_placeholders[obj2.unsignedIntegerValue].length;
+        return length1 > length2 ? NSOrderedAscending : (length1 < length2 ? NSOrderedDescending : NSOrderedSame);
+    }];
+
+    NSUInteger slotCount = slotsByLength.count;
+    NSUInteger placeholderLengths[MAX(slotCount, 1)];
+    unichar* placeholderCharacters[MAX(slotCount, 1)];
+    for (NSUInteger index = 0; index < slotCount; index++)
+    {
+        NSString* placeholder = _placeholders[slotsByLength[index].unsignedIntegerValue];
+        placeholderLengths[index] = placeholder.length;
+        placeholderCharacters[index] = malloc(MAX(placeholder.length, 1) * sizeof(unichar));
+        [placeholder getCharacters:placeholderCharacters[index] range:NSMakeRange(0, placeholder.length)];
+    }
+
+    NSMutableData* segments = [NSMutableData data];
+    NSUInteger length = _string.length;
+    NSUInteger literalStart = 0;
+    NSUInteger position = 0;
+    while (position < length)
+    {
+        NSInteger matchedIndex = GTY_TEMPLATE_LITERAL;
+        for (NSUInteger index = 0; index < slotCount; index++)
+        {
+            NSUInteger placeholderLength = placeholderLengths[index];
+            if (placeholderLength > 0 && placeholderLength <= length - position &&
+                placeholderCharacters[index][0] == _characters[position] &&
+                memcmp(placeholderCharacters[index], _characters + position, placeholderLength * sizeof(unichar)) == 0)
+            {
+                matchedIndex = index;
+                break;
+            }
+        }
+
+        if (matchedIndex == GTY_TEMPLATE_LITERAL)
+        {
+            position++;
+            continue;
+        }
+
+        if (position > literalStart)
+        {
+            GTYTemplateSegment literal = { literalStart, position - literalStart, GTY_TEMPLATE_LITERAL };
+            [segments appendBytes:&literal length:sizeof(literal)];
+            _literalLength += literal.length;
+        }
+        NSUInteger slot = slotsByLength[matchedIndex].unsignedIntegerValue;
+        GTYTemplateSegment placeholder = { position, placeholderLengths[matchedIndex], (NSInteger)slot };
+        [segments appendBytes:&placeholder length:sizeof(placeholder)];
+        _occurrences[slot]++;
+        position += placeholderLengths[matchedIndex];
+        literalStart = position;
+    }
+    if (length > literalStart)
+    {
+        GTYTemplateSegment literal = { literalStart, length - literalStart, GTY_TEMPLATE_LITERAL };
+        [segments appendBytes:&literal length:sizeof(literal)];
+        _literalLength += literal.length;
+    }
+    _segmentsData = segments;
+
+    for (NSUInteger index = 0; index < slotCount; index++)
+    {
+        free(placeholderCharacters[index]);
+    }
+}
+
+- (NSArray<NSNumber*>*) slotIndexes
+{
+    NSMutableArray<NSNumber*>* indexes = [NSMutableArray arrayWithCapacity:_placeholders.count];
+    for (NSUInteger index = 0; index < _placeholders.count; index++)
+    {
+        [indexes addObject:@(index)];
+    }
+    return indexes;
+}
+
+- (BOOL) hasPlaceholdersOfDictionary:(NSDictionary<NSString*, NSString*>*)placeholderDictionary
+{
+    if (placeholderDictionary.count != _placeholderSet.count)
+    {
+        return NO;
+    }
+    for (NSString* placeholder in placeholderDictionary)
+    {
+        if (![_placeholderSet containsObject:placeholder])
+        {
+            return NO;
+        }
+    }
+    return YES;
+}
+
+- (NSString*) stringWithPlaceholderDictionary:(NSDictionary<NSString*, NSString*>*)placeholderDictionary
+{
+    if (_literalLength == _string.length)
+    {
+        // no placeholders found
+        return _string;
+    }
+
+    NSUInteger slotCount = _placeholders.count;
+    __unsafe_unretained NSString* values[slotCount];
+    NSUInteger valueLengths[slotCount];
+    NSUInteger length = _literalLength;
+    for (NSUInteger slot = 0; slot < slotCount; slot++)
+    {
+        values[slot] = placeholderDictionary[_placeholders[slot]] ?: @"";
+        valueLengths[slot] = values[slot].length;
+        length += valueLengths[slot] * _occurrences[slot];
+    }
+
+    unichar* buffer = malloc(MAX(length, 1) * sizeof(unichar));
+    const GTYTemplateSegment* segments = _segmentsData.bytes;
+    NSUInteger segmentCount = _segmentsData.length / sizeof(GTYTemplateSegment);
+    NSUInteger position = 0;
+    for (NSUInteger index = 0; index < segmentCount; index++)
+    {
+        const GTYTemplateSegment* segment = &segments[index];
+        if (segment->slot == GTY_TEMPLATE_LITERAL)
+        {
+            memcpy(buffer + position, _characters + segment->location, segment->length * sizeof(unichar));
+            position += segment->length;
+        }
+        else
+        {
+            [values[segment->slot] getCharacters:buffer + position range:NSMakeRange(0, valueLengths[segment->slot])];
+            position += valueLengths[segment->slot];
+        }
+    }
+    return [[NSString alloc] initWithCharactersNoCopy:buffer length:length freeWhenDone:YES];
+}
+
+@end
@@ -0,0 +1,112 @@
+// Copyright 2017 Sysdata S.p.A.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#import <Foundation/Foundation.h>
+
+#define kStringsPackExtension @"strpack"
+
+/**
+ * Set in packs compiled with glotty-pack --resolve: the pack contains the keys of the table in all localizations, with values already resolved through the fallback chain, so the index of a key is the same in all the packs of the table.
+ */
+#define GTYStringsPackFlagResolved 0x1
+
+/**
+ * A compiled, read-only strings table.
+ *
+ * A pack is the binary counterpart of a .strings file: a header, an index of entries sorted by the UTF-8 bytes of their keys and a blob with the UTF-8 text of keys and values.
+ * The file is memory mapped, so opening a pack does not parse anything and lookups are a binary search on the mapped bytes that only allocates the returned value.
+ *
+ * Packs are usually compiled at build time with Scripts/glotty-pack and added to the .lproj folders next to (or instead of) the .strings files.
+ */
+@interface GTYStringsPack : NSObject
+
+/**
+ * Maps the pack at the given path.
+ *
+ * @param path Path of the .strpack file.
+ *
+ * @return The pack, or nil if the file does not exist or it is not a valid pack.
+ */
++ (instancetype) packWithContentsOfFile:(NSString*)path;
+
+/**
+ * Creates a pack reading the given bytes, which are not copied.
+ *
+ * @return The pack, or nil if data is not a valid pack.
+ */
+- (instancetype) initWithData:(NSData*)data;
+
+/**
+ * Number of entries of the pack.
+ */
+@property (nonatomic, readonly) NSUInteger count;
+
+/**
+ * Size in bytes of the mapped file.
+ */
+@property (nonatomic, readonly) NSUInteger byteSize;
+
+/**
+ * Flags of the pack, like GTYStringsPackFlagResolved.
+ */
+@property (nonatomic, readonly) uint16_t flags;
+
+/**
+ * Hash of the keys of the pack, written by glotty-pack and dataWithStrings:. Resolved packs of a table have the same keys, so the header of key IDs generated with them stores the same hash. 0 for packs of version 1.
+ */
+@property (nonatomic, readonly) uint32_t keySetHash;
+
+/**
+ * Returns the key of the entry at the given index, in key order.
+ */
+- (NSString*) keyAtIndex:(NSUInteger)index;
+
+/**
+ * Returns the value associated with the given key, or nil if the pack does not contain it.
+ */
+- (NSString*) stringForKey:(NSString*)key;
+
+/**
+ * Returns YES if the pack has a value for the key with the given UTF-8 bytes. No string is created.
+ */
+- (BOOL) containsStringForKeyBytes:(const char*)keyBytes length:(NSUInteger)keyLength;
+
+/**
+ * Returns YES if the pack has a value for the given key, without creating the value.
+ */
+- (BOOL) containsStringForKey:(NSString*)key;
+
+/**
+ * Keys of the entries with a value, in key order.
+ */
+- (NSArray<NSString*>*) allKeysWithStrings;
+
+/**
+ * Enumerates all entries in key order.
+ */
+- (void) enumerateKeysAndStringsUsingBlock:(void (^)(NSString* key, NSString* string, BOOL* stop))block;
+
+/**
+ * Compiles the given strings into the pack format.
+ */
++ (NSData*) dataWithStrings:(NSDictionary<NSString*, NSString*>*)strings;
+
+/**
+ * Compiles the given strings and writes them atomically to the given path.
+ *
+ * @return YES if the pack has been written.
+ */
++ (BOOL) writeStrings:(NSDictionary<NSString*, NSString*>*)strings toFile:(NSString*)path;
+
+@end
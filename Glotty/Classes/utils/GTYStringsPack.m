@@ -0,0 +1,393 @@
+// Copyright 2017 Sysdata S.p.A.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#import "GTYStringsPack.h"
+#import "SDLocalizationLogger.h"
+
+// Layout of a pack (all integers are little endian):
+//
+//   header   GTYPackHeader
+//   index    GTYPackEntry[count], sorted by key bytes (memcmp, shorter key first on ties)
+//   blob     UTF-8 text of keys and values, referenced by offset from the beginning of the blob
+//
+// Entries of resolved packs whose key has no value in any fallback localization have a value length of UINT32_MAX.
+//
+// Version 2 adds keySetHash to the header: the 32-bit FNV-1a hash of the keys in index order, each preceded by its
+// byte length as a little endian uint32. Version 1 packs have a 24-byte header without it and are still read.
+//
+// Scripts/glotty-pack writes the same layout: keep them aligned.
+
+#define GTY_PACK_MAGIC          "GTYP"
+#define GTY_PACK_VERSION        2
+#define GTY_PACK_FNV_OFFSET     2166136261u
+#define GTY_PACK_FNV_PRIME      16777619u
+#define GTY_PACK_KEY_BUFFER     256
+
+typedef struct
+{
+    char     magic[4];
+    uint16_t version;
+    uint16_t flags;
+    uint32_t count;
+    uint32_t indexOffset;
+    uint32_t blobOffset;
+    uint32_t blobLength;
+    uint32_t keySetHash;
+} GTYPackHeader;
+
+typedef struct
+{
+    uint32_t keyOffset;
+    uint32_t keyLength;
+    uint32_t valueOffset;
+    uint32_t valueLength;
+} GTYPackEntry;
+
+static inline BOOL GTYPackRangeIsValid(uint32_t offset, uint32_t length, uint32_t blobLength)
+{
+    return (uint64_t)offset + (uint64_t)length <= (uint64_t)blobLength;
+}
+
+static inline int GTYPackCompareBytes(const char* a, size_t aLength, const char* b, size_t bLength)
+{
+    int result = memcmp(a, b, MIN(aLength, bLength));
+    if (result != 0)
+    {
+        return result;
+    }
+    return aLength < bLength ? -1 : (aLength > bLength ? 1 : 0);
+}
+
+static inline uint32_t GTYPackHashBytes(uint32_t hash, const void* bytes, size_t length)
+{
+    const uint8_t* cursor = bytes;
+    for (size_t index = 0; index < length; index++)
+    {
+        hash = (hash ^ cursor[index]) * GTY_PACK_FNV_PRIME;
+    }
+    return hash;
+}
+
+static inline uint32_t GTYPackHashKey(uint32_t hash, const char* keyBytes, uint32_t keyLength)
+{
+    uint8_t lengthBytes[4] = { keyLength & 0xFF, (keyLength >> 8) & 0xFF, (keyLength >> 16) & 0xFF, keyLength >> 24 };
+    hash = GTYPackHashBytes(hash, lengthBytes, sizeof(lengthBytes));
+    return GTYPackHashBytes(hash, keyBytes, keyLength);
+}
+
+@interface GTYStringsPack ()
+@property (nonatomic, strong) NSData* data;
+@end
+
+@implementation GTYStringsPack
+{
+    const GTYPackEntry* _entries;
+    const char* _blob;
+    uint32_t _blobLength;
+}
+
+#pragma mark - Reading
+
++ (instancetype) packWithContentsOfFile:(NSString*)path
+{
+    if (path.length == 0)
+    {
+        return nil;
+    }
+
+    NSError* error = nil;
+    NSData* data = [NSData dataWithContentsOfFile:path options:NSDataReadingMappedAlways error:&error];
+    if (!data)
+    {
+        SDLogModuleError(kLocalizationManagerLogModuleName, @"Unable to map strings pack at path %@: %@", path, error);
+        return nil;
+    }
+
+    GTYStringsPack* pack = [[self alloc] initWithData:data];
+    if (!pack)
+    {
+        SDLogModuleError(kLocalizationManagerLogModuleName, @"Invalid strings pack at path %@", path);
+    }
+    return pack;
+}
+
+- (instancetype) initWithData:(NSData*)data
+{
+    self = [super init];
+    if (self)
+    {
+        // the header of version 1 ends before keySetHash
+        size_t headerLength = offsetof(GTYPackHeader, keySetHash);
+        if (data.length < headerLength)
+        {
+            return nil;
+        }
+
+        const GTYPackHeader* header = data.bytes;
+        if (memcmp(header->magic, GTY_PACK_MAGIC, sizeof(header->magic)) != 0 || header->version < 1 || header->version > GTY_PACK_VERSION)
+        {
+            return nil;
+        }
+        if (header->version >= 2)
+        {
+            headerLength = sizeof(GTYPackHeader);
+            if (data.length < headerLength)
+            {
+                return nil;
+            }
+        }
+
+        uint64_t indexEnd = (uint64_t)header->indexOffset + (uint64_t)header->count * sizeof(GTYPackEntry);
+        uint64_t blobEnd = (uint64_t)header->blobOffset + (uint64_t)header->blobLength;
+        if (header->indexOffset < headerLength || header->indexOffset % sizeof(uint32_t) != 0 ||
+            indexEnd > data.length || blobEnd > data.length)
+        {
+            return nil;
+        }
+
+        _data = data;
+        _count = header->count;
+        _flags = header->flags;
+        _keySetHash = header->version >= 2 ? header->keySetHash : 0;
+        _entries = (const GTYPackEntry*)((const char*)data.bytes + header->indexOffset);
+        _blob = (const char*)data.bytes + header->blobOffset;
+        _blobLength = header->blobLength;
+    }
+    return self;
+}
+
+- (NSUInteger) byteSize
+{
+    return self.data.length;
+}
+
+- (NSString*) stringForKey:(NSString*)key
+{
+    NSInteger index = [self indexOfKey:key];
+    if (index == NSNotFound)
+    {
+        return nil;
+    }
+    return [self valueAtIndex:index];
+}
+
+- (BOOL) containsStringForKeyBytes:(const char*)keyBytes length:(NSUInteger)keyLength
+{
+    NSInteger index = [self indexOfKeyBytes:keyBytes length:keyLength];
+    return index != NSNotFound && [self hasValueAtIndex:index];
+}
+
+- (BOOL) containsStringForKey:(NSString*)key
+{
+    NSInteger index = [self indexOfKey:key];
+    return index != NSNotFound && [self hasValueAtIndex:index];
+}
+
+- (NSArray<NSString*>*) allKeysWithStrings
+{
+    NSMutableArray<NSString*>* keys = [NSMutableArray arrayWithCapacity:_count];
+    for (NSUInteger index = 0; index < _count; index++)
+    {
+        NSString* key = [self hasValueAtIndex:index] ? [self keyAtIndex:index] : nil;
+        if (key)
+        {
+            [keys addObject:key];
+        }
+    }
+    return keys;
+}
+
+- (void) enumerateKeysAndStringsUsingBlock:(void (^)(NSString* key, NSString* string, BOOL* stop))block
+{
+    BOOL stop = NO;
+    for (NSUInteger index = 0; index < _count && !stop; index++)
+    {
+        NSString* key = [self keyAtIndex:index];
+        NSString* value = [self valueAtIndex:index];
+        if (key && value)
+        {
+            block(key, value, &stop);
+        }
+    }
+}
+
+/**
+ * Returns the index of the entry with the given key, converting it to UTF-8 without copies when possible.
+ */
+- (NSInteger) indexOfKey:(NSString*)key
+{
+    if (key.length == 0 || _count == 0)
+    {
+        return NSNotFound;
+    }
+
+    // avoid the conversion when the string already holds ASCII bytes, which is the common case for literal keys
+    // keys may contain U+0000, so their length is explicit
+    char buffer[GTY_PACK_KEY_BUFFER];
+    const char* keyBytes = CFStringGetCStringPtr((__bridge CFStringRef)key, kCFStringEncodingUTF8);
+    NSUInteger keyLength = key.length;
+    if (!keyBytes)
+    {
+        NSRange remainingRange = {0, 0};
+        if ([key getBytes:buffer maxLength:sizeof(buffer) usedLength:&keyLength encoding:NSUTF8StringEncoding options:0 range:NSMakeRange(0, key.length) remainingRange:&remainingRange] && remainingRange.length == 0)
+        {
+            keyBytes = buffer;
+        }
+        else
+        {
+            keyBytes = key.UTF8String;
+            keyLength = [key lengthOfBytesUsingEncoding:NSUTF8StringEncoding];
+        }
+    }
+    if (!keyBytes)
+    {
+        return NSNotFound;
+    }
+
+    return [self indexOfKeyBytes:keyBytes length:keyLength];
+}
+
+- (NSInteger) indexOfKeyBytes:(const char*)keyBytes length:(size_t)keyLength
+{
+    NSUInteger low = 0;
+    NSUInteger high = _count;
+    while (low < high)
+    {
+        NSUInteger middle = low + (high - low) / 2;
+        const GTYPackEntry* entry = &_entries[middle];
+        if (!GTYPackRangeIsValid(entry->keyOffset, entry->keyLength, _blobLength))
+        {
+            return NSNotFound;
+        }
+
+        int result = GTYPackCompareBytes(_blob + entry->keyOffset, entry->keyLength, keyBytes, keyLength);
+        if (result == 0)
+        {
+            return middle;
+        }
+        if (result < 0)
+        {
+            low = middle + 1;
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+    return NSNotFound;
+}
+
+- (NSString*) keyAtIndex:(NSUInteger)index
+{
+    if (index >= _count)
+    {
+        return nil;
+    }
+    const GTYPackEntry* entry = &_entries[index];
+    if (!GTYPackRangeIsValid(entry->keyOffset, entry->keyLength, _blobLength))
+    {
+        return nil;
+    }
+    return [[NSString alloc] initWithBytes:_blob + entry->keyOffset length:entry->keyLength encoding:NSUTF8StringEncoding];
+}
+
+- (BOOL) hasValueAtIndex:(NSUInteger)index
+{
+    const GTYPackEntry* entry = &_entries[index];
+    return GTYPackRangeIsValid(entry->valueOffset, entry->valueLength, _blobLength);
+}
+
+- (NSString*) valueAtIndex:(NSUInteger)index
+{
+    const GTYPackEntry* entry = &_entries[index];
+    if (!GTYPackRangeIsValid(entry->valueOffset, entry->valueLength, _blobLength))
+    {
+        return nil;
+    }
+    return [[NSString alloc] initWithBytes:_blob + entry->valueOffset length:entry->valueLength encoding:NSUTF8StringEncoding];
+}
+
+#pragma mark - Writing
+
++ (NSData*) dataWithStrings:(NSDictionary<NSString*, NSString*>*)strings
+{
+    NSMutableArray<NSData*>* keys = [NSMutableArray arrayWithCapacity:strings.count];
+    NSMutableDictionary<NSData*, NSData*>* valuesByKey = [NSMutableDictionary dictionaryWithCapacity:strings.count];
+    for (NSString* key in strings)
+    {
+        NSData* keyData = [key dataUsingEncoding:NSUTF8StringEncoding];
+        NSData* valueData = [strings[key] dataUsingEncoding:NSUTF8StringEncoding];
+        if (keyData && valueData)
+        {
+            [keys addObject:keyData];
+            valuesByKey[keyData] = valueData;
+        }
+    }
+
+    [keys sortUsingComparator:^NSComparisonResult(NSData* obj1, NSData* obj2) {
+        int result = GTYPackCompareBytes(obj1.bytes, obj1.length, obj2.bytes, obj2.length);
+        return result < 0 ? NSOrderedAscending : (result > 0 ? NSOrderedDescending : NSOrderedSame);
+    }];
+
+    NSMutableData* blob = [NSMutableData data];
+    NSMutableData* index = [NSMutableData dataWithCapacity:keys.count * sizeof(GTYPackEntry)];
+    uint32_t keySetHash = GTY_PACK_FNV_OFFSET;
+    for (NSData* keyData in keys)
+    {
+        NSData* valueData = valuesByKey[keyData];
+        if (blob.length + keyData.length + valueData.length > UINT32_MAX)
+        {
+            SDLogModuleError(kLocalizationManagerLogModuleName, @"Too many strings to fit in a strings pack");
+            return nil;
+        }
+
+        GTYPackEntry entry;
+        entry.keyOffset = (uint32_t)blob.length;
+        entry.keyLength = (uint32_t)keyData.length;
+        keySetHash = GTYPackHashKey(keySetHash, keyData.bytes, entry.keyLength);
+        [blob appendData:keyData];
+        entry.valueOffset = (uint32_t)blob.length;
+        entry.valueLength = (uint32_t)valueData.length;
+        [blob appendData:valueData];
+        [index appendBytes:&entry length:sizeof(entry)];
+    }
+
+    GTYPackHeader header;
+    memcpy(header.magic, GTY_PACK_MAGIC, sizeof(header.magic));
+    header.version = GTY_PACK_VERSION;
+    header.flags = 0;
+    header.count = (uint32_t)keys.count;
+    header.indexOffset = sizeof(GTYPackHeader);
+    header.blobOffset = (uint32_t)(sizeof(GTYPackHeader) + index.length);
+    header.blobLength = (uint32_t)blob.length;
+    header.keySetHash = keySetHash;
+
+    NSMutableData* data = [NSMutableData dataWithCapacity:header.blobOffset + blob.length];
+    [data appendBytes:&header length:sizeof(header)];
+    [data appendData:index];
+    [data appendData:blob];
+    return data;
+}
+
++ (BOOL) writeStrings:(NSDictionary<NSString*, NSString*>*)strings toFile:(NSString*)path
+{
+    NSData* data = [self dataWithStrings:strings];
+    if (!data)
+    {
+        return NO;
+    }
+    return [data writeToFile:path atomically:YES];
+}
+
+@end
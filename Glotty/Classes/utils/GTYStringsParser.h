@@ -0,0 +1,82 @@
+// Copyright 2017 Sysdata S.p.A.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#import <Foundation/Foundation.h>
+
+@class GTYCompactTable;
+
+extern NSString* const GTYStringsParserErrorDomain;
+
+/**
+ * Key of the userInfo of parser errors: the line, starting from 1, where a text table is malformed.
+ */
+extern NSString* const GTYStringsParserLineErrorKey;
+
+typedef NS_ENUM(NSInteger, GTYStringsParserErrorCode)
+{
+    GTYStringsParserErrorUnreadableFile = 1,
+    /** The data is neither an old-style text table nor a binary property list, e.g. an XML property list. */
+    GTYStringsParserErrorUnsupportedFormat,
+    GTYStringsParserErrorInvalidEncoding,
+    GTYStringsParserErrorUnexpectedCharacter,
+    GTYStringsParserErrorUnterminatedString,
+    GTYStringsParserErrorUnterminatedComment,
+    GTYStringsParserErrorInvalidEscape,
+    GTYStringsParserErrorInvalidBinaryPropertyList,
+};
+
+/**
+ * A parser of .strings tables that builds the dictionary of the table directly, without going through the generic property list parser.
+ *
+ * It reads the formats tables are shipped in:
+ * - old-style text, in UTF-8 or UTF-16 (detected by BOM or by the zero bytes of ASCII characters), with comments, quoted or unquoted tokens, escapes and the optional braces of a dictionary;
+ * - binary property lists, as produced by Xcode when it compiles .strings files.
+ *
+ * Text is scanned with memchr(), which is vectorized by the C library, to jump to the next quote, backslash or end of comment; strings without escapes are created straight from the file bytes.
+ */
+@interface GTYStringsParser : NSObject
+
+/**
+ * Maps the file at the given path and parses it.
+ *
+ * @param error Set to the reason of the failure, with the line of malformed text tables.
+ *
+ * @return The strings of the table, or nil if the file cannot be read or parsed.
+ */
++ (NSMutableDictionary<NSString*, NSString*>*) stringsWithContentsOfFile:(NSString*)path error:(NSError**)error;
+
+/**
+ * Parses the given bytes of a table.
+ *
+ * @return The strings of the table, or nil if the data cannot be parsed.
+ */
++ (NSMutableDictionary<NSString*, NSString*>*) stringsWithData:(NSData*)data error:(NSError**)error;
+
+/**
+ * Maps the file at the given path and parses it into a compact table.
+ *
+ * The entries of text tables are copied into the table as UTF-8 bytes, without creating strings.
+ *
+ * @return The strings of the table, or nil if the file cannot be read or parsed.
+ */
++ (GTYCompactTable*) compactTableWithContentsOfFile:(NSString*)path error:(NSError**)error;
+
+/**
+ * Parses the given bytes of a table into a compact table.
+ *
+ * @return The strings of the table, or nil if the data cannot be parsed.
+ */
++ (GTYCompactTable*) compactTableWithData:(NSData*)data error:(NSError**)error;
+
+@end
@@ -0,0 +1,928 @@
+// Copyright 2017 Sysdata S.p.A.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#import "GTYStringsParser.h"
+#import "GTYCompactTable.h"
+
+NSString* const GTYStringsParserErrorDomain = @"GTYStringsParserErrorDomain";
+NSString* const GTYStringsParserLineErrorKey = @"GTYStringsParserLine";
+
+#define GTY_BPLIST_MAGIC            "bplist00"
+#define GTY_BPLIST_TRAILER_LENGTH   32
+// average size of an entry of a text table, used to size the dictionary
+#define GTY_STRINGS_ENTRY_ESTIMATE  48
+
+#pragma mark - Text scanner
+
+/**
+ * Unescaped bytes of a string that contains escapes.
+ */
+typedef struct
+{
+    uint8_t* bytes;
+    size_t length;
+    size_t capacity;
+    BOOL outOfMemory;
+} GTYScanBuffer;
+
+/**
+ * Bytes of a scanned string: in the scanned text, or in a scan buffer if the string contains escapes.
+ */
+typedef struct
+{
+    const uint8_t* bytes;
+    size_t length;
+    // position of the string in the text, for errors
+    const uint8_t* position;
+} GTYSpan;
+
+typedef struct
+{
+    const uint8_t* start;
+    const uint8_t* cursor;
+    const uint8_t* end;
+    // keys and values need a buffer each, since both are passed to the sink
+    GTYScanBuffer keyBuffer;
+    GTYScanBuffer valueBuffer;
+    GTYStringsParserErrorCode errorCode;
+    const uint8_t* errorPosition;
+    const char* errorReason;
+} GTYTextScanner;
+
+/**
+ * Receives each entry of a text table. Returns NO, after setting the error of the scanner, to stop parsing.
+ */
+typedef BOOL (*GTYEntrySink)(GTYTextScanner* scanner, void* context, GTYSpan key, GTYSpan value);
+
+static BOOL GTYIsTokenCharacter(uint8_t c)
+{
+    // the characters allowed by old-style property lists in unquoted strings
+    static BOOL table[256];
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        for (int ch = 0; ch < 256; ch++)
+        {
+            table[ch] = (ch >= 'a' && ch <= 'z') || (ch >= 'A' && ch <= 'Z') || (ch >= '0' && ch <= '9') ||
+                        ch == '_' || ch == '$' || ch == '/' || ch == ':' || ch == '.' || ch == '-';
+        }
+    });
+    return table[c];
+}
+
+static BOOL GTYScannerFail(GTYTextScanner* scanner, GTYStringsParserErrorCode code, const uint8_t* position, const char* reason)
+{
+    scanner->errorCode = code;
+    scanner->errorPosition = position;
+    scanner->errorReason = reason;
+    return NO;
+}
+
+static void GTYScanBufferAppend(GTYScanBuffer* buffer, const uint8_t* bytes, size_t length)
+{
+    if (buffer->length + length > buffer->capacity)
+    {
+        size_t capacity = MAX(MAX(buffer->capacity * 2, buffer->length + length), 256);
+        uint8_t* newBytes = realloc(buffer->bytes, capacity);
+        if (!newBytes)
+        {
+            buffer->outOfMemory = YES;
+            return;
+        }
+        buffer->bytes = newBytes;
+        buffer->capacity = capacity;
+    }
+    memcpy(buffer->bytes + buffer->length, bytes, length);
+    buffer->length += length;
+}
+
+static void GTYScanBufferAppendCodePoint(GTYScanBuffer* buffer, uint32_t codePoint)
+{
+    uint8_t bytes[4];
+    size_t length;
+    if (codePoint < 0x80)
+    {
+        bytes[0] = (uint8_t)codePoint;
+        length = 1;
+    }
+    else if (codePoint < 0x800)
+    {
+        bytes[0] = (uint8_t)(0xC0 | (codePoint >> 6));
+        bytes[1] = (uint8_t)(0x80 | (codePoint & 0x3F));
+        length = 2;
+    }
+    else if (codePoint < 0x10000)
+    {
+        bytes[0] = (uint8_t)(0xE0 | (codePoint >> 12));
+        bytes[1] = (uint8_t)(0x80 | ((codePoint >> 6) & 0x3F));
+        bytes[2] = (uint8_t)(0x80 | (codePoint & 0x3F));
+        length = 3;
+    }
+    else
+    {
+        bytes[0] = (uint8_t)(0xF0 | (codePoint >> 18));
+        bytes[1] = (uint8_t)(0x80 | ((codePoint >> 12) & 0x3F));
+        bytes[2] = (uint8_t)(0x80 | ((codePoint >> 6) & 0x3F));
+        bytes[3] = (uint8_t)(0x80 | (codePoint & 0x3F));
+        length = 4;
+    }
+    GTYScanBufferAppend(buffer, bytes, length);
+}
+
+static BOOL GTYSkipWhitespaceAndComments(GTYTextScanner* scanner)
+{
+    const uint8_t* end = scanner->end;
+    while (scanner->cursor < end)
+    {
+        uint8_t c = *scanner->cursor;
+        if (c == ' ' || c == '\n' || c == '\r' || c == '\t' || c == '\f' || c == '\v')
+        {
+            scanner->cursor++;
+        }
+        else if (c == '/' && scanner->cursor + 1 < end && scanner->cursor[1] == '*')
+        {
+            const uint8_t* commentStart = scanner->cursor;
+            const uint8_t* p = scanner->cursor + 2;
+            for (;;)
+            {
+                p = memchr(p, '*', end - p);
+                if (!p || p + 1 >= end)
+                {
+                    return GTYScannerFail(scanner, GTYStringsParserErrorUnterminatedComment, commentStart, "unterminated comment");
+                }
+                if (p[1] == '/')
+                {
+                    break;
+                }
+                p++;
+            }
+            scanner->cursor = p + 2;
+        }
+        else if (c == '/' && scanner->cursor + 1 < end && scanner->cursor[1] == '/')
+        {
+            const uint8_t* newline = memchr(scanner->cursor, '\n', end - scanner->cursor);
+            scanner->cursor = newline ? newline + 1 : end;
+        }
+        else
+        {
+            break;
+        }
+    }
+    return YES;
+}
+
+static int GTYHexValue(uint8_t c)
+{
+    if (c >= '0' && c <= '9')
+    {
+        return c - '0';
+    }
+    if (c >= 'a' && c <= 'f')
+    {
+        return c - 'a' + 10;
+    }
+    if (c >= 'A' && c <= 'F')
+    {
+        return c - 'A' + 10;
+    }
+    return -1;
+}
+
+/**
+ * Reads up to 4 hex digits of a \U escape, starting at the given position.
+ *
+ * @return The number of digits read.
+ */
+static int GTYScanHexDigits(const uint8_t* p, const uint8_t* end, uint32_t* value)
+{
+    int digits = 0;
+    *value = 0;
+    while (digits < 4 && p + digits < end && GTYHexValue(p[digits]) >= 0)
+    {
+        *value = (*value << 4) | (uint32_t)GTYHexValue(p[digits]);
+        digits++;
+    }
+    return digits;
+}
+
+/**
+ * Decodes the escape following a backslash at the given position into the buffer.
+ *
+ * @return The position after the escape, or NULL on errors.
+ */
+static const uint8_t* GTYScanEscape(GTYTextScanner* scanner, GTYScanBuffer* buffer, const uint8_t* backslash)
+{
+    const uint8_t* p = backslash + 1;
+    const uint8_t* end = scanner->end;
+    if (p >= end)
+    {
+        GTYScannerFail(scanner, GTYStringsParserErrorUnterminatedString, backslash, "unterminated escape");
+        return NULL;
+    }
+
+    uint8_t c = *p++;
+    switch (c)
+    {
+        case 'a': GTYScanBufferAppendCodePoint(buffer, '\a'); break;
+        case 'b': GTYScanBufferAppendCodePoint(buffer, '\b'); break;
+        case 'f': GTYScanBufferAppendCodePoint(buffer, '\f'); break;
+        case 'n': GTYScanBufferAppendCodePoint(buffer, '\n'); break;
+        case 'r': GTYScanBufferAppendCodePoint(buffer, '\r'); break;
+        case 't': GTYScanBufferAppendCodePoint(buffer, '\t'); break;
+        case 'v': GTYScanBufferAppendCodePoint(buffer, '\v'); break;
+        case 'U':
+        case 'u':
+        {
+            uint32_t codePoint;
+            int digits = GTYScanHexDigits(p, end, &codePoint);
+            if (digits == 0)
+            {
+                GTYScannerFail(scanner, GTYStringsParserErrorInvalidEscape, backslash, "\\U escape without hex digits");
+                return NULL;
+            }
+            p += digits;
+            if (codePoint >= 0xD800 && codePoint <= 0xDBFF)
+            {
+                // a high surrogate is combined with the low surrogate of the following escape
+                uint32_t low;
+                if (p + 2 < end && p[0] == '\\' && (p[1] == 'U' || p[1] == 'u') && GTYScanHexDigits(p + 2, end, &low) == 4 && low >= 0xDC00 && low <= 0xDFFF)
+                {
+                    codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (low - 0xDC00);
+                    p += 6;
+                }
+                else
+                {
+                    codePoint = 0xFFFD;
+                }
+            }
+            else if (codePoint >= 0xDC00 && codePoint <= 0xDFFF)
+            {
+                codePoint = 0xFFFD;
+            }
+            GTYScanBufferAppendCodePoint(buffer, codePoint);
+            break;
+        }
+        case '0': case '1': case '2': case '3': case '4': case '5': case '6': case '7':
+        {
+            // up to 3 octal digits, read as a Latin-1 character
+            uint32_t codePoint = c - '0';
+            for (int digits = 1; digits < 3 && p < end && *p >= '0' && *p <= '7'; digits++)
+            {
+                codePoint = (codePoint << 3) | (uint32_t)(*p++ - '0');
+            }
+            GTYScanBufferAppendCodePoint(buffer, MIN(codePoint, 0xFFu));
+            break;
+        }
+        default:
+            // \" \\ \' and any other character stand for themselves
+            GTYScanBufferAppend(buffer, &c, 1);
+            break;
+    }
+    return p;
+}
+
+/**
+ * Returns YES if the given bytes are well-formed UTF-8. Runs of ASCII characters are checked 8 bytes at a time.
+ */
+static BOOL GTYIsValidUTF8(const uint8_t* bytes, size_t length)
+{
+    size_t i = 0;
+    while (i < length)
+    {
+        if (i + sizeof(uint64_t) <= length)
+        {
+            uint64_t chunk;
+            memcpy(&chunk, bytes + i, sizeof(chunk));
+            if ((chunk & 0x8080808080808080ULL) == 0)
+            {
+                i += sizeof(chunk);
+                continue;
+            }
+        }
+
+        uint8_t c = bytes[i];
+        if (c < 0x80)
+        {
+            i++;
+            continue;
+        }
+        size_t continuationCount;
+        uint32_t codePoint;
+        uint32_t minimum;
+        if ((c & 0xE0) == 0xC0)
+        {
+            continuationCount = 1;
+            codePoint = c & 0x1F;
+            minimum = 0x80;
+        }
+        else if ((c & 0xF0) == 0xE0)
+        {
+            continuationCount = 2;
+            codePoint = c & 0x0F;
+            minimum = 0x800;
+        }
+        else if ((c & 0xF8) == 0xF0)
+        {
+            continuationCount = 3;
+            codePoint = c & 0x07;
+            minimum = 0x10000;
+        }
+        else
+        {
+            return NO;
+        }
+        if (length - i <= continuationCount)
+        {
+            return NO;
+        }
+        for (size_t k = 1; k <= continuationCount; k++)
+        {
+            uint8_t continuation = bytes[i + k];
+            if ((continuation & 0xC0) != 0x80)
+            {
+                return NO;
+            }
+            codePoint = (codePoint << 6) | (continuation & 0x3F);
+        }
+        if (codePoint < minimum || codePoint > 0x10FFFF || (codePoint >= 0xD800 && codePoint <= 0xDFFF))
+        {
+            return NO;
+        }
+        i += continuationCount + 1;
+    }
+    return YES;
+}
+
+/**
+ * Scans a quoted string at the cursor.
+ *
+ * The closing quote and the backslashes are found with memchr(): the bytes between them are copied as they are, and strings without escapes are not copied at all.
+ */
+static BOOL GTYScanQuotedString(GTYTextScanner* scanner, GTYScanBuffer* buffer, GTYSpan* span)
+{
+    const uint8_t* openingQuote = scanner->cursor;
+    const uint8_t* end = scanner->end;
+    const uint8_t* p = openingQuote + 1;
+    span->position = openingQuote;
+    const uint8_t* quote = memchr(p, '"', end - p);
+    if (!quote)
+    {
+        return GTYScannerFail(scanner, GTYStringsParserErrorUnterminatedString, openingQuote, "unterminated string");
+    }
+
+    const uint8_t* backslash = memchr(p, '\\', quote - p);
+    if (!backslash)
+    {
+        scanner->cursor = quote + 1;
+        span->bytes = p;
+        span->length = quote - p;
+        return YES;
+    }
+
+    buffer->length = 0;
+    while (backslash)
+    {
+        GTYScanBufferAppend(buffer, p, backslash - p);
+        p = GTYScanEscape(scanner, buffer, backslash);
+        if (!p)
+        {
+            return NO;
+        }
+        if (p > quote)
+        {
+            // the quote was escaped
+            quote = memchr(p, '"', end - p);
+            if (!quote)
+            {
+                return GTYScannerFail(scanner, GTYStringsParserErrorUnterminatedString, openingQuote, "unterminated string");
+            }
+        }
+        backslash = memchr(p, '\\', quote - p);
+    }
+    GTYScanBufferAppend(buffer, p, quote - p);
+    scanner->cursor = quote + 1;
+    if (buffer->outOfMemory)
+    {
+        return GTYScannerFail(scanner, GTYStringsParserErrorUnreadableFile, openingQuote, "out of memory");
+    }
+    span->bytes = buffer->bytes ?: (const uint8_t*)"";
+    span->length = buffer->length;
+    return YES;
+}
+
+/**
+ * Scans a quoted or unquoted string at the cursor.
+ */
+static BOOL GTYScanString(GTYTextScanner* scanner, GTYScanBuffer* buffer, GTYSpan* span, const char* expectation)
+{
+    if (scanner->cursor >= scanner->end)
+    {
+        return GTYScannerFail(scanner, GTYStringsParserErrorUnexpectedCharacter, scanner->cursor, expectation);
+    }
+    if (*scanner->cursor == '"')
+    {
+        return GTYScanQuotedString(scanner, buffer, span);
+    }
+
+    const uint8_t* start = scanner->cursor;
+    while (scanner->cursor < scanner->end && GTYIsTokenCharacter(*scanner->cursor))
+    {
+        scanner->cursor++;
+    }
+    if (scanner->cursor == start)
+    {
+        return GTYScannerFail(scanner, GTYStringsParserErrorUnexpectedCharacter, start, expectation);
+    }
+    span->bytes = start;
+    span->length = scanner->cursor - start;
+    span->position = start;
+    return YES;
+}
+
+static BOOL GTYScanExpectedCharacter(GTYTextScanner* scanner, uint8_t character, const char* expectation)
+{
+    if (!GTYSkipWhitespaceAndComments(scanner))
+    {
+        return NO;
+    }
+    if (scanner->cursor >= scanner->end || *scanner->cursor != character)
+    {
+        return GTYScannerFail(scanner, GTYStringsParserErrorUnexpectedCharacter, scanner->cursor, expectation);
+    }
+    scanner->cursor++;
+    return YES;
+}
+
+/**
+ * Parses the entries of an old-style text table in UTF-8: "key" = "value"; pairs, "key"; entries whose value is the key itself and the optional braces around them.
+ */
+static BOOL GTYParseText(GTYTextScanner* scanner, GTYEntrySink sink, void* context)
+{
+    if (!GTYSkipWhitespaceAndComments(scanner))
+    {
+        return NO;
+    }
+    BOOL braced = scanner->cursor < scanner->end && *scanner->cursor == '{';
+    if (braced)
+    {
+        scanner->cursor++;
+    }
+
+    for (;;)
+    {
+        if (!GTYSkipWhitespaceAndComments(scanner))
+        {
+            return NO;
+        }
+        if (scanner->cursor >= scanner->end)
+        {
+            return braced ? GTYScannerFail(scanner, GTYStringsParserErrorUnexpectedCharacter, scanner->cursor, "expected '}'") : YES;
+        }
+        if (braced && *scanner->cursor == '}')
+        {
+            scanner->cursor++;
+            if (!GTYSkipWhitespaceAndComments(scanner))
+            {
+                return NO;
+            }
+            return scanner->cursor >= scanner->end ? YES : GTYScannerFail(scanner, GTYStringsParserErrorUnexpectedCharacter, scanner->cursor, "unexpected characters after '}'");
+        }
+
+        GTYSpan key;
+        if (!GTYScanString(scanner, &scanner->keyBuffer, &key, "expected a key") || !GTYSkipWhitespaceAndComments(scanner))
+        {
+            return NO;
+        }
+        if (scanner->cursor < scanner->end && *scanner->cursor == ';')
+        {
+            scanner->cursor++;
+            if (!sink(scanner, context, key, key))
+            {
+                return NO;
+            }
+            continue;
+        }
+        if (!GTYScanExpectedCharacter(scanner, '=', "expected '=' or ';' after the key") || !GTYSkipWhitespaceAndComments(scanner))
+        {
+            return NO;
+        }
+        GTYSpan value;
+        if (!GTYScanString(scanner, &scanner->valueBuffer, &value, "expected a value after '='") ||
+            !GTYScanExpectedCharacter(scanner, ';', "expected ';' after the value") ||
+            !sink(scanner, context, key, value))
+        {
+            return NO;
+        }
+    }
+}
+
+#pragma mark - Sinks
+
+static NSString* GTYCreateString(GTYTextScanner* scanner, GTYSpan span)
+{
+    NSString* string = [[NSString alloc] initWithBytes:span.bytes length:span.length encoding:NSUTF8StringEncoding];
+    if (!string)
+    {
+        GTYScannerFail(scanner, GTYStringsParserErrorInvalidEncoding, span.position, "invalid UTF-8 sequence");
+    }
+    return string;
+}
+
+/**
+ * Adds the entry to the NSMutableDictionary given as context.
+ */
+static BOOL GTYDictionarySink(GTYTextScanner* scanner, void* context, GTYSpan key, GTYSpan value)
+{
+    NSString* keyString = GTYCreateString(scanner, key);
+    if (!keyString)
+    {
+        return NO;
+    }
+    NSString* valueString = value.bytes == key.bytes ? keyString : GTYCreateString(scanner, value);
+    if (!valueString)
+    {
+        return NO;
+    }
+    NSMutableDictionary* strings = (__bridge NSMutableDictionary*)context;
+    strings[keyString] = valueString;
+    return YES;
+}
+
+/**
+ * Copies the bytes of the entry to the GTYCompactTableBuilder given as context, without creating strings.
+ */
+static BOOL GTYCompactTableSink(GTYTextScanner* scanner, void* context, GTYSpan key, GTYSpan value)
+{
+    if (!GTYIsValidUTF8(key.bytes, key.length))
+    {
+        return GTYScannerFail(scanner, GTYStringsParserErrorInvalidEncoding, key.position, "invalid UTF-8 sequence");
+    }
+    if (value.bytes != key.bytes && !GTYIsValidUTF8(value.bytes, value.length))
+    {
+        return GTYScannerFail(scanner, GTYStringsParserErrorInvalidEncoding, value.position, "invalid UTF-8 sequence");
+    }
+    GTYCompactTableBuilder* builder = (__bridge GTYCompactTableBuilder*)context;
+    if (![builder addKeyBytes:(const char*)key.bytes length:key.length valueBytes:(const char*)value.bytes length:value.length replacingExisting:YES])
+    {
+        return GTYScannerFail(scanner, GTYStringsParserErrorUnreadableFile, key.position, "out of memory");
+    }
+    return YES;
+}
+
+#pragma mark - Binary property lists
+
+typedef struct
+{
+    const uint8_t* bytes;
+    uint64_t length;
+    uint8_t offsetSize;
+    uint8_t referenceSize;
+    uint64_t objectCount;
+    uint64_t offsetTableOffset;
+} GTYBinaryPlist;
+
+static uint64_t GTYReadBigEndian(const uint8_t* bytes, uint8_t size)
+{
+    uint64_t value = 0;
+    for (uint8_t i = 0; i < size; i++)
+    {
+        value = (value << 8) | bytes[i];
+    }
+    return value;
+}
+
+/**
+ * Returns the offset of the object with the given reference, or 0 if it is out of range.
+ */
+static uint64_t GTYBinaryPlistObjectOffset(const GTYBinaryPlist* plist, uint64_t reference)
+{
+    if (reference >= plist->objectCount)
+    {
+        return 0;
+    }
+    uint64_t offset = GTYReadBigEndian(plist->bytes + plist->offsetTableOffset + reference * plist->offsetSize, plist->offsetSize);
+    return offset >= strlen(GTY_BPLIST_MAGIC) && offset < plist->offsetTableOffset ? offset : 0;
+}
+
+/**
+ * Reads the marker of the object at the given offset and its count, which follows as an integer object when the low nibble is 0xF.
+ *
+ * @return The offset of the content of the object, or 0 if it is out of range.
+ */
+static uint64_t GTYBinaryPlistReadCount(const GTYBinaryPlist* plist, uint64_t offset, uint8_t* type, uint64_t* count)
+{
+    uint8_t marker = plist->bytes[offset];
+    *type = marker >> 4;
+    *count = marker & 0x0F;
+    offset++;
+    if (*count == 0x0F)
+    {
+        if (offset >= plist->offsetTableOffset || (plist->bytes[offset] >> 4) != 0x1)
+        {
+            return 0;
+        }
+        uint8_t size = 1 << (plist->bytes[offset] & 0x0F);
+        if (size > 8 || offset + 1 + size > plist->offsetTableOffset)
+        {
+            return 0;
+        }
+        *count = GTYReadBigEndian(plist->bytes + offset + 1, size);
+        offset += 1 + size;
+    }
+    return offset;
+}
+
+static NSString* GTYBinaryPlistString(const GTYBinaryPlist* plist, uint64_t reference)
+{
+    uint64_t offset = GTYBinaryPlistObjectOffset(plist, reference);
+    if (offset == 0)
+    {
+        return nil;
+    }
+    uint8_t type;
+    uint64_t count;
+    offset = GTYBinaryPlistReadCount(plist, offset, &type, &count);
+    if (offset == 0)
+    {
+        return nil;
+    }
+
+    switch (type)
+    {
+        case 0x5: // ASCII
+            if (count > plist->offsetTableOffset - offset)
+            {
+                return nil;
+            }
+            return [[NSString alloc] initWithBytes:plist->bytes + offset length:(NSUInteger)count encoding:NSASCIIStringEncoding];
+        case 0x6: // UTF-16 big endian, count of code units
+            if (count > (plist->offsetTableOffset - offset) / 2)
+            {
+                return nil;
+            }
+            return [[NSString alloc] initWithBytes:plist->bytes + offset length:(NSUInteger)count * 2 encoding:NSUTF16BigEndianStringEncoding];
+        case 0x7: // UTF-8
+            if (count > plist->offsetTableOffset - offset)
+            {
+                return nil;
+            }
+            return [[NSString alloc] initWithBytes:plist->bytes + offset length:(NSUInteger)count encoding:NSUTF8StringEncoding];
+        default:
+            return nil;
+    }
+}
+
+/**
+ * Reads the top dictionary of a binary property list, whose keys and values must all be strings.
+ *
+ * @return NO, with the offset of the invalid object, if the list is malformed or contains anything else.
+ */
+static BOOL GTYParseBinaryPlist(const uint8_t* bytes, uint64_t length, NSMutableDictionary* strings, uint64_t* errorOffset)
+{
+    *errorOffset = 0;
+    if (length < strlen(GTY_BPLIST_MAGIC) + GTY_BPLIST_TRAILER_LENGTH)
+    {
+        return NO;
+    }
+
+    const uint8_t* trailer = bytes + length - GTY_BPLIST_TRAILER_LENGTH;
+    GTYBinaryPlist plist;
+    plist.bytes = bytes;
+    plist.length = length;
+    plist.offsetSize = trailer[6];
+    plist.referenceSize = trailer[7];
+    plist.objectCount = GTYReadBigEndian(trailer + 8, 8);
+    uint64_t topObject = GTYReadBigEndian(trailer + 16, 8);
+    plist.offsetTableOffset = GTYReadBigEndian(trailer + 24, 8);
+
+    uint64_t tableEnd = length - GTY_BPLIST_TRAILER_LENGTH;
+    if (plist.offsetSize < 1 || plist.offsetSize > 8 || plist.referenceSize < 1 || plist.referenceSize > 8 ||
+        plist.offsetTableOffset < strlen(GTY_BPLIST_MAGIC) || plist.offsetTableOffset > tableEnd ||
+        plist.objectCount > (tableEnd - plist.offsetTableOffset) / plist.offsetSize)
+    {
+        *errorOffset = length - GTY_BPLIST_TRAILER_LENGTH;
+        return NO;
+    }
+
+    uint64_t offset = GTYBinaryPlistObjectOffset(&plist, topObject);
+    if (offset == 0)
+    {
+        *errorOffset = length - GTY_BPLIST_TRAILER_LENGTH;
+        return NO;
+    }
+    uint8_t type;
+    uint64_t count;
+    uint64_t contentOffset = GTYBinaryPlistReadCount(&plist, offset, &type, &count);
+    if (contentOffset == 0 || type != 0xD || count > (plist.offsetTableOffset - contentOffset) / (2 * plist.referenceSize))
+    {
+        *errorOffset = offset;
+        return NO;
+    }
+
+    // keys references, then values references
+    const uint8_t* keyReferences = bytes + contentOffset;
+    const uint8_t* valueReferences = keyReferences + count * plist.referenceSize;
+    for (uint64_t i = 0; i < count; i++)
+    {
+        uint64_t keyReference = GTYReadBigEndian(keyReferences + i * plist.referenceSize, plist.referenceSize);
+        uint64_t valueReference = GTYReadBigEndian(valueReferences + i * plist.referenceSize, plist.referenceSize);
+        NSString* key = GTYBinaryPlistString(&plist, keyReference);
+        NSString* value = key ? GTYBinaryPlistString(&plist, valueReference) : nil;
+        if (!value)
+        {
+            *errorOffset = GTYBinaryPlistObjectOffset(&plist, key ? valueReference : keyReference) ?: offset;
+            return NO;
+        }
+        strings[key] = value;
+    }
+    return YES;
+}
+
+#pragma mark - Parser
+
+@implementation GTYStringsParser
+
++ (NSMutableDictionary<NSString*, NSString*>*) stringsWithContentsOfFile:(NSString*)path error:(NSError**)error
+{
+    NSData* data = [self mappedDataWithContentsOfFile:path error:error];
+    return data ? [self stringsWithData:data error:error] : nil;
+}
+
++ (NSMutableDictionary<NSString*, NSString*>*) stringsWithData:(NSData*)data error:(NSError**)error
+{
+    NSMutableDictionary* strings = [NSMutableDictionary dictionaryWithCapacity:data.length / GTY_STRINGS_ENTRY_ESTIMATE];
+    NSMutableDictionary* binaryStrings = nil;
+    if (![self parseData:data sink:GTYDictionarySink context:(__bridge void*)strings binaryStrings:&binaryStrings error:error])
+    {
+        return nil;
+    }
+    return binaryStrings ?: strings;
+}
+
++ (GTYCompactTable*) compactTableWithContentsOfFile:(NSString*)path error:(NSError**)error
+{
+    NSData* data = [self mappedDataWithContentsOfFile:path error:error];
+    return data ? [self compactTableWithData:data error:error] : nil;
+}
+
++ (GTYCompactTable*) compactTableWithData:(NSData*)data error:(NSError**)error
+{
+    GTYCompactTableBuilder* builder = [[GTYCompactTableBuilder alloc] initWithCapacity:data.length / GTY_STRINGS_ENTRY_ESTIMATE];
+    NSMutableDictionary* binaryStrings = nil;
+    if (![self parseData:data sink:GTYCompactTableSink context:(__bridge void*)builder binaryStrings:&binaryStrings error:error])
+    {
+        return nil;
+    }
+    return binaryStrings ? [GTYCompactTable tableWithStrings:binaryStrings] : [builder build];
+}
+
++ (NSData*) mappedDataWithContentsOfFile:(NSString*)path error:(NSError**)error
+{
+    NSError* readError = nil;
+    NSData* data = path ? [NSData dataWithContentsOfFile:path options:NSDataReadingMappedIfSafe error:&readError] : nil;
+    if (!data && error)
+    {
+        NSString* description = [NSString stringWithFormat:@"Unable to read strings file %@", path];
+        NSMutableDictionary* userInfo = [NSMutableDictionary dictionaryWithObject:description forKey:NSLocalizedDescriptionKey];
+        userInfo[NSUnderlyingErrorKey] = readError;
+        userInfo[NSFilePathErrorKey] = path;
+        *error = [NSError errorWithDomain:GTYStringsParserErrorDomain code:GTYStringsParserErrorUnreadableFile userInfo:userInfo];
+    }
+    return data;
+}
+
+/**
+ * Parses the given data, passing each entry of text tables to the given sink.
+ *
+ * Strings of binary property lists are not UTF-8, so they are returned as a dictionary instead.
+ */
++ (BOOL) parseData:(NSData*)data sink:(GTYEntrySink)sink context:(void*)context binaryStrings:(NSMutableDictionary**)binaryStrings error:(NSError**)error
+{
+    const uint8_t* bytes = data.bytes;
+    NSUInteger length = data.length;
+
+    if (length >= strlen(GTY_BPLIST_MAGIC) && memcmp(bytes, GTY_BPLIST_MAGIC, strlen(GTY_BPLIST_MAGIC)) == 0)
+    {
+        NSMutableDictionary* strings = [NSMutableDictionary dictionary];
+        uint64_t errorOffset;
+        if (!GTYParseBinaryPlist(bytes, length, strings, &errorOffset))
+        {
+            [self setError:error code:GTYStringsParserErrorInvalidBinaryPropertyList reason:[NSString stringWithFormat:@"invalid or non-string object at byte %llu of a binary property list", (unsigned long long)errorOffset] line:0];
+            return NO;
+        }
+        *binaryStrings = strings;
+        return YES;
+    }
+
+    // UTF-16 text is converted to UTF-8 once, so a single scanner handles both
+    NSData* utf8Data = data;
+    NSStringEncoding utf16Encoding = 0;
+    NSUInteger bomLength = 0;
+    if (length >= 2 && bytes[0] == 0xFF && bytes[1] == 0xFE)
+    {
+        utf16Encoding = NSUTF16LittleEndianStringEncoding;
+        bomLength = 2;
+    }
+    else if (length >= 2 && bytes[0] == 0xFE && bytes[1] == 0xFF)
+    {
+        utf16Encoding = NSUTF16BigEndianStringEncoding;
+        bomLength = 2;
+    }
+    else if (length >= 2 && bytes[0] == 0 && bytes[1] != 0)
+    {
+        utf16Encoding = NSUTF16BigEndianStringEncoding;
+    }
+    else if (length >= 2 && bytes[0] != 0 && bytes[1] == 0)
+    {
+        utf16Encoding = NSUTF16LittleEndianStringEncoding;
+    }
+    else if (length >= 3 && bytes[0] == 0xEF && bytes[1] == 0xBB && bytes[2] == 0xBF)
+    {
+        bomLength = 3;
+    }
+
+    if (utf16Encoding != 0)
+    {
+        NSString* text = (length - bomLength) % 2 == 0 ? [[NSString alloc] initWithBytes:bytes + bomLength length:length - bomLength encoding:utf16Encoding] : nil;
+        utf8Data = [text dataUsingEncoding:NSUTF8StringEncoding];
+        if (!utf8Data)
+        {
+            [self setError:error code:GTYStringsParserErrorInvalidEncoding reason:@"invalid UTF-16 text" line:0];
+            return NO;
+        }
+        bytes = utf8Data.bytes;
+        length = utf8Data.length;
+        bomLength = 0;
+    }
+
+    GTYTextScanner scanner = {0};
+    scanner.start = bytes + bomLength;
+    scanner.cursor = scanner.start;
+    scanner.end = bytes + length;
+
+    if (GTYSkipWhitespaceAndComments(&scanner) && scanner.cursor < scanner.end && *scanner.cursor == '<')
+    {
+        [self setError:error code:GTYStringsParserErrorUnsupportedFormat reason:@"XML property lists are not supported" line:0];
+        return NO;
+    }
+    scanner.cursor = scanner.start;
+    scanner.errorCode = 0;
+
+    BOOL parsed = GTYParseText(&scanner, sink, context);
+    free(scanner.keyBuffer.bytes);
+    free(scanner.valueBuffer.bytes);
+    if (!parsed)
+    {
+        [self setError:error code:scanner.errorCode reason:@(scanner.errorReason) line:[self lineOfPosition:scanner.errorPosition inScanner:&scanner]];
+        return NO;
+    }
+    return YES;
+}
+
+#pragma mark - Errors
+
++ (NSUInteger) lineOfPosition:(const uint8_t*)position inScanner:(const GTYTextScanner*)scanner
+{
+    NSUInteger line = 1;
+    const uint8_t* p = scanner->start;
+    while (p < position && (p = memchr(p, '\n', position - p)))
+    {
+        line++;
+        p++;
+    }
+    return line;
+}
+
+/**
+ * @param line Line of the error, or 0 if it is not in a text table.
+ */
++ (void) setError:(NSError**)error code:(GTYStringsParserErrorCode)code reason:(NSString*)reason line:(NSUInteger)line
+{
+    if (!error)
+    {
+        return;
+    }
+    NSMutableDictionary* userInfo = [NSMutableDictionary dictionary];
+    if (line > 0)
+    {
+        userInfo[NSLocalizedDescriptionKey] = [NSString stringWithFormat:@"Malformed strings table at line %lu: %@", (unsigned long)line, reason];
+        userInfo[GTYStringsParserLineErrorKey] = @(line);
+    }
+    else
+    {
+        userInfo[NSLocalizedDescriptionKey] = [NSString stringWithFormat:@"Malformed strings table: %@", reason];
+    }
+    *error = [NSError errorWithDomain:GTYStringsParserErrorDomain code:code userInfo:userInfo];
+}
+
+@end
@@ -136,8 +136,20 @@
 
 + (BOOL)isLocaleIdentifierAvailableOnSystem:(NSString *)identifier
 {
-    NSArray *availableLocales = [NSLocale availableLocaleIdentifiers];
-    return ([availableLocales containsObject:[identifier stringByReplacingOccurrencesOfString:@"-" withString:@"_"]]);
+    static NSSet *availableLocales = nil;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        // identifiers are stored also in the "-" form, so that lookups never need to convert them
+        NSArray *identifiers = [NSLocale availableLocaleIdentifiers];
+        NSMutableSet *set = [NSMutableSet setWithCapacity:identifiers.count * 2];
+        for (NSString *availableIdentifier in identifiers)
+        {
+            [set addObject:availableIdentifier];
+            [set addObject:[availableIdentifier stringByReplacingOccurrencesOfString:@"_" withString:@"-"]];
+        }
+        availableLocales = [set copy];
+    });
+    return identifier ? [availableLocales containsObject:identifier] : NO;
 }
 
 @end